@@ -29,13 +29,19 @@ LOCAL_SRC_FILES  := GiSkiaView.cpp \
                     $(SRC_PATH)/geom/mglnrel.cpp \
                     $(SRC_PATH)/geom/mgnear.cpp \
                     $(SRC_PATH)/geom/mgnearbz.cpp \
+                    $(SRC_PATH)/geom/mgrtree.cpp \
                     $(SRC_PATH)/geom/mgvec.cpp \
                     $(SRC_PATH)/graph/gipath.cpp \
+                    $(SRC_PATH)/graph/giraster.cpp \
+                    $(SRC_PATH)/graph/gitiles.cpp \
                     $(SRC_PATH)/graph/gixform.cpp \
+                    $(SRC_PATH)/graph/gidlist.cpp \
                     $(SRC_PATH)/graph/gigraph.cpp \
                     $(SRC_PATH)/shape/mgcmddraw.cpp \
                     $(SRC_PATH)/shape/mgcmds.cpp \
                     $(SRC_PATH)/shape/mgcmdselect.cpp \
+                    $(SRC_PATH)/shape/mgdispcache.cpp \
+                    $(SRC_PATH)/shape/mgsnapshot.cpp \
                     $(SRC_PATH)/shape/mgcmderase.cpp \
                     $(SRC_PATH)/shape/mgcmdmgr.cpp \
                     $(SRC_PATH)/shape/mgdrawline.cpp \
@@ -47,7 +53,10 @@ LOCAL_SRC_FILES  := GiSkiaView.cpp \
                     $(SRC_PATH)/shape/mglines.cpp \
                     $(SRC_PATH)/shape/mgrdrect.cpp \
                     $(SRC_PATH)/shape/mgrect.cpp \
+                    $(SRC_PATH)/shape/mgregion.cpp \
                     $(SRC_PATH)/shape/mgshape.cpp \
-                    $(SRC_PATH)/shape/mgsplines.cpp
+                    $(SRC_PATH)/shape/mgshapeidx.cpp \
+                    $(SRC_PATH)/shape/mgsplines.cpp \
+                    $(SRC_PATH)/shape/mgstoragebin.cpp
 
 include $(BUILD_SHARED_LIBRARY)
@@ -4,9 +4,10 @@
 
 #include "GiCanvasBase.h"
 
-GiCanvasBase::GiCanvasBase() : _gs(&_xf), _bkcolor(GiColor::White()), _ctxstatus(0)
+GiCanvasBase::GiCanvasBase() : _gs(&_xf), _bkcolor(GiColor::White()), _ctxstatus(0), _penWidth(0)
 {
     _gs._setCanvas(this);
+    _gs.setBatchMode(true);     // merge primitives to reduce the calls across JNI
     _xf.setResolution(screenDpi());
 }
 
@@ -37,6 +38,7 @@ bool GiCanvasBase::drawCachedBitmap2(const GiCanvas*, float, float, bool) { retu
 void GiCanvasBase::penChanged(const GiContext&, float penWidth) {}
 void GiCanvasBase::brushChanged(const GiContext&) {}
 void GiCanvasBase::setNeedRedraw() {}
+void GiCanvasBase::setNeedRedrawRect(float, float, float, float) { setNeedRedraw(); }
 
 bool GiCanvasBase::rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2)
 {
@@ -147,7 +149,11 @@ bool GiCanvasBase::checkStroke(const GiContext* ctx)
 		}
 		if (_gictx.getLineWidth() != ctx->getLineWidth()) {
 			_gictx.setLineWidth(ctx->getLineWidth());
-			changed = true;
+			float w = _gs.calcPenWidth(ctx->getLineWidth());
+			if (_penWidth != w) {	// skip if the pixel width is not changed
+				_penWidth = w;
+				changed = true;
+			}
 		}
 		if (_gictx.getLineStyle() != ctx->getLineStyle()) {
 			_gictx.setLineStyle(ctx->getLineStyle());
@@ -159,7 +165,8 @@ bool GiCanvasBase::checkStroke(const GiContext* ctx)
 	if (!ctx->isNullLine() && changed)
 	{
 		_ctxstatus |= 1;
-		penChanged(*ctx, _gs.calcPenWidth(ctx->getLineWidth()));
+		_penWidth = _gs.calcPenWidth(ctx->getLineWidth());
+		penChanged(*ctx, _penWidth);
 	}
 
 	return !ctx->isNullLine();
@@ -196,6 +203,16 @@ bool GiCanvasBase::beginPaint()
 	return true;
 }
 
+bool GiCanvasBase::beginPaint(float x, float y, float w, float h)
+{
+	_ctxstatus = 0;
+
+	RECT_2D clipBox = { x, y, x + w, y + h };
+	_gs._beginPaint(clipBox);
+
+	return true;
+}
+
 void GiCanvasBase::endPaint()
 {
 	_gs._endPaint();
@@ -28,8 +28,10 @@ public:
     virtual GiColor setBkColor(const GiColor& color);
 
 	bool beginPaint();
+	bool beginPaint(float x, float y, float w, float h);   //!< only redraw in the clip rect
 	void endPaint();
 	virtual void setNeedRedraw();
+	virtual void setNeedRedrawRect(float x, float y, float w, float h);
     virtual void penChanged(const GiContext& ctx, float penWidth);
 	virtual void brushChanged(const GiContext& ctx);
 
@@ -90,6 +92,7 @@ private:
 	GiColor     	_bkcolor;
 	GiContext   	_gictx;
 	int         	_ctxstatus;
+	float       	_penWidth;
 };
 
 #endif // __TOUCHVG_SWIG_CANVAS_H_
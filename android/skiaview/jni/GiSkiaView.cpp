@@ -43,6 +43,12 @@ public:
     virtual void redraw(bool) {
     	_canvas->setNeedRedraw();
     }
+    virtual void regenRect(const Box2d& rectM) {
+    	if (!rectM.isNull()) {
+    		Box2d rect(rectM * _canvas->xf().modelToDisplay());
+    		_canvas->setNeedRedrawRect(rect.xmin, rect.ymin, rect.width(), rect.height());
+    	}
+    }
 };
 
 GiSkiaView::GiSkiaView(GiCanvasBase* canvas) : _zoomMask(7)
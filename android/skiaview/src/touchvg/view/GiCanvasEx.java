@@ -7,7 +7,9 @@ import android.graphics.DashPathEffect;
 import android.graphics.Paint;
 import android.graphics.Path;
 import android.graphics.PathEffect;
+import android.graphics.Rect;
 import android.graphics.RectF;
+import touchvg.skiaview.Chars;
 import touchvg.skiaview.Floats;
 import touchvg.skiaview.GiCanvasBase;
 import touchvg.skiaview.GiContext;
@@ -18,6 +20,7 @@ public class GiCanvasEx extends GiCanvasBase{
 	private Paint mBrush = new Paint();
 	private Canvas mCanvas = null;
 	private View mView = null;
+	private Rect mClipRect = new Rect();
 	private static final float patDash[]      = { 5, 5 };
 	private static final float patDot[]       = { 1, 3 };
 	private static final float patDashDot[]   = { 10, 2, 2, 2 };
@@ -39,7 +42,13 @@ public class GiCanvasEx extends GiCanvasBase{
 		}
 		
 		this.mCanvas = canvas;
-		super.beginPaint();
+		if (canvas.getClipBounds(mClipRect)) {	// only redraw the dirty rect
+			super.beginPaint(mClipRect.left, mClipRect.top,
+					mClipRect.width(), mClipRect.height());
+		}
+		else {
+			super.beginPaint();
+		}
 		
 		mPen.setAntiAlias(true);
 		mPen.setDither(true);
@@ -52,8 +61,8 @@ public class GiCanvasEx extends GiCanvasBase{
 	}
 	
 	public void endPaint() {
+		super.endPaint();			// may flush batched primitives to mCanvas
 		this.mCanvas = null;
-		super.endPaint();
 	}
 	
 	@Override
@@ -61,6 +70,12 @@ public class GiCanvasEx extends GiCanvasBase{
 		mView.invalidate();
 	}
 	
+	@Override
+	public void setNeedRedrawRect(float x, float y, float w, float h) {
+		mView.invalidate((int)Math.floor(x) - 1, (int)Math.floor(y) - 1,
+				(int)Math.ceil(x + w) + 1, (int)Math.ceil(y + h) + 1);
+	}
+	
 	@Override
 	public void antiAliasModeChanged(boolean alias) {
 		mPen.setAntiAlias(alias);
@@ -195,6 +210,39 @@ public class GiCanvasEx extends GiCanvasBase{
 		return true;
 	}
 
+	@Override
+	public boolean drawPath(Floats pxs, Chars types, boolean stroke, boolean fill) {
+		boolean ret = pxs.count() >= 4 && types.count() * 2 == pxs.count();
+		Path p = new Path();
+		
+		for (int i = 0; ret && i < types.count(); i++) {
+			int type = types.get(i) & ~1;
+			float x = pxs.get(2*i), y = pxs.get(2*i+1);
+			
+			if (type == 6) {			// kGiMoveTo
+				p.moveTo(x, y);
+			}
+			else if (type == 2) {		// kGiLineTo
+				p.lineTo(x, y);
+			}
+			else if (type == 4 && i + 2 < types.count()) {	// kGiBeziersTo
+				p.cubicTo(x, y, pxs.get(2*i+2), pxs.get(2*i+3), pxs.get(2*i+4), pxs.get(2*i+5));
+				i += 2;
+			}
+			if ((types.get(i) & 1) != 0) {	// kGiCloseFigure
+				p.close();
+			}
+		}
+		if (ret) {
+			if (fill)
+				mCanvas.drawPath(p, mBrush);
+			if (stroke)
+				mCanvas.drawPath(p, mPen);
+		}
+		
+		return ret;
+	}
+
 	@Override
 	public boolean drawPolygon(Floats pxs, boolean stroke, boolean fill) {
 		boolean ret = pxs.count() >= 4;
@@ -0,0 +1,169 @@
+// allocbench.cpp: 统计每帧绘图时的堆内存分配次数
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: allocbench [图形个数] [帧数]，默认为100000个图形、每种显示比例10帧
+//       另加点数较多的折线和样条曲线(长笔画)，放大后只显示其可见部分，每帧还对其选中判断。
+//       首帧之后的帧仍有堆内存分配时返回1
+
+#include "benchutil.h"
+#include <gigraph.h>
+#include <mgshapet.h>
+#include <mgbasicsp.h>
+#include <mgcurv.h>
+#include <math.h>
+#include <stdio.h>
+#include <new>
+
+static long s_allocs = 0;       // 累计的堆内存分配次数
+
+void* operator new(size_t size)
+{
+    s_allocs++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) throw()
+{
+    free(p);
+}
+#endif
+
+// 一帧的内容: 随机图形列表，以及点数较多的各种图元
+struct FrameCase : public BenchCase
+{
+    BenchShapes*    shapes;
+    MgShape*        strokes[2];     // 长笔画(折线和样条曲线)
+    GiGraphics*     gs;
+    CountCanvas*    canvas;
+    std::vector<Point2d>    pts;
+    std::vector<Vector2d>   vecs;
+    std::vector<UInt8>      types;
+    GiContext       ctx;
+
+    void run() {
+        int n = (int)pts.size();
+
+        canvas->beginPaint();
+        shapes->draw(*gs);
+        gs->drawLines(&ctx, n, &pts.front());
+        gs->drawBeziers(&ctx, n, &pts.front());
+        gs->drawPolygon(&ctx, n, &pts.front());
+        gs->drawSplines(&ctx, n, &pts.front(), &vecs.front());
+        gs->drawClosedSplines(&ctx, n, &pts.front(), &vecs.front());
+        gs->drawBSplines(&ctx, n, &pts.front());
+        gs->drawClosedBSplines(&ctx, n, &pts.front());
+        gs->drawPath(&ctx, n, &pts.front(), &types.front());
+        canvas->endPaint();
+
+        Point2d nearpt;
+        Int32 segment;
+        for (int i = 0; i < 2; i++) {               // 按曲线段空间索引选中
+            const MgBaseShape* sp = strokes[i]->shapec();
+            Point2d pt(sp->getPoint(sp->getPointCount() / 2));
+            sp->hitTest(pt, sp->getExtent().width() / 100, nearpt, segment);
+            sp->hitTestBox(Box2d(pt, sp->getExtent().width() / 10, sp->getExtent().height() / 10));
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    int frames = argc > 2 ? atoi(argv[2]) : 10;
+    BenchShapes shapes;
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    CountCanvas canvas(&gs);
+    FrameCase frame;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    Box2d extent(shapes.getExtent());
+
+    frame.shapes = &shapes;
+    frame.gs = &gs;
+    frame.canvas = &canvas;
+    frame.pts.resize(20000);
+    frame.vecs.resize(frame.pts.size());
+    frame.types.resize(frame.pts.size(), kGiLineTo);
+    frame.types[0] = kGiMoveTo;
+    frame.types.back() |= kGiCloseFigure;
+    for (size_t i = 0; i < frame.pts.size(); i++) {   // 布满图形范围的螺旋线
+        float t = (float)i / frame.pts.size();
+        float angle = t * 40 * _M_PI;
+        frame.pts[i] = extent.center() + Vector2d(cosf(angle) * extent.width(),
+            sinf(angle) * extent.height()) * (0.05f + t * 0.45f);
+    }
+    mgCubicSplines((Int32)frame.pts.size(), &frame.pts.front(), &frame.vecs.front());
+
+    MgShapeT<MgLines> lines;                        // 布满图形范围的锯齿线
+    MgShapeT<MgSplines> splines;
+
+    lines._shape.resize(10000);
+    for (UInt32 i = 0; i < 10000; i++) {
+        lines.shape()->setPoint(i, Point2d(extent.xmin + extent.width() * i / 9999,
+            i % 2 ? extent.ymin : extent.ymax));
+    }
+    splines._shape.resize(2000);
+    for (UInt32 i = 0; i < 2000; i++)
+        splines.shape()->setPoint(i, frame.pts[i * 10]);
+    frame.strokes[0] = shapes.addShape(lines);
+    frame.strokes[1] = shapes.addShape(splines);
+
+    xf.setWndSize(1024, 768);
+    xf.setViewScaleRange(1e-5f, 1e5f);
+    xf.zoomTo(extent * xf.modelToWorld());
+
+    const float factors[] = { 1, 4, 16 };
+    Point2d centerW(xf.getCenterW());
+    float scale = xf.getViewScale();
+
+    printf("shapes: %ld, frames: %d\n", count, frames);
+    printf("%8s %12s %14s %12s\n", "zoom", "first frame", "later frames", "ms/frame");
+
+    for (int i = 0; i < 3; i++) {
+        xf.zoom(centerW, scale * factors[i]);
+
+        long allocs = s_allocs;
+        frame.run();                                // 首帧可能扩充临时缓冲区
+        long firstAllocs = s_allocs - allocs;
+
+        allocs = s_allocs;
+        double t = benchNow();
+        for (int j = 0; j < frames; j++)
+            frame.run();
+        t = (benchNow() - t) / frames;
+        allocs = s_allocs - allocs;
+
+        printf("%8g %12ld %14ld %12.2f\n", factors[i], firstAllocs, allocs, t);
+        if (allocs > 0)
+            ret = 1;
+    }
+
+    return ret;
+}
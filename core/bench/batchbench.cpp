@@ -0,0 +1,178 @@
+// batchbench.cpp: 比较逐个提交与按绘图参数批量提交图元的画布调用次数和显示结果
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: batchbench [图形个数] [同样式的连续图形个数]，默认为100000个图形、每20个图形换一种样式
+//       两种方式显示的像素不一致时返回1
+
+#include "benchutil.h"
+#include <giraster.h>
+#include <mgbasicsp.h>
+#include <stdio.h>
+#include <string.h>
+
+// 记录画笔和画刷更新次数的画布，与 GiCanvasBase 一样只在绘图参数改变时更新
+class StateCanvas : public CountCanvas
+{
+public:
+    long        penChanges;
+    long        brushChanges;
+    GiContext   ctx;
+    float       penWidth;
+
+    StateCanvas(GiGraphics* gs) : CountCanvas(gs), penChanges(0), brushChanges(0), penWidth(-1) {}
+
+    virtual bool rawLine(const GiContext* c, float, float, float, float) { return stroke(c) && add(2); }
+    virtual bool rawLines(const GiContext* c, const Point2d*, int n) { return stroke(c) && add(n); }
+    virtual bool rawBeziers(const GiContext* c, const Point2d*, int n) { return stroke(c) && add(n); }
+    virtual bool rawPolygon(const GiContext* c, const Point2d*, int n) { return style(c) && add(n); }
+    virtual bool rawRect(const GiContext* c, float, float, float, float) { return style(c) && add(4); }
+    virtual bool rawEllipse(const GiContext* c, float, float, float, float) { return style(c) && add(4); }
+    virtual bool rawPath(const GiContext* c, int n, const Point2d*, const UInt8*) { return style(c) && add(n); }
+    virtual bool rawEndPath(const GiContext* c, bool) { return style(c) && add(0); }
+
+private:
+    bool stroke(const GiContext* c) {
+        float w = owner()->calcPenWidth(c->getLineWidth());
+        if (w != penWidth || c->getLineColor() != ctx.getLineColor()
+            || c->getLineStyle() != ctx.getLineStyle()) {
+            penWidth = w;
+            ctx.setLineColor(c->getLineColor());
+            ctx.setLineStyle(c->getLineStyle());
+            penChanges++;
+        }
+        return true;
+    }
+    bool style(const GiContext* c) {
+        if (c->hasFillColor() && c->getFillColor() != ctx.getFillColor()) {
+            ctx.setFillColor(c->getFillColor());
+            brushChanges++;
+        }
+        return stroke(c);
+    }
+};
+
+// 按样式序号设置图形的绘图参数，矩形在奇数样式时填充
+struct StyleVisitor : public MgShapeVisitor
+{
+    long    run;
+    long    i;
+
+    bool visit(MgShape* sp) {
+        const GiColor colors[] = { GiColor(0, 0, 0), GiColor(200, 0, 0),
+            GiColor(0, 128, 0), GiColor(0, 0, 255) };
+        const float widths[] = { 0, -2, 50, -1 };
+        int style = (int)(i++ / run) % 4;
+        GiContext* ctx = sp->context();
+
+        ctx->setLineColor(colors[style]);
+        ctx->setLineWidth(widths[style]);
+        ctx->setLineStyle(kLineSolid);
+        if (style % 2 && sp->shape()->isKindOf(MgRect::Type()))
+            ctx->setFillColor(GiColor(255, 255, 128));
+        else
+            ctx->setNoFillColor();
+        return true;
+    }
+};
+
+static void setStyles(BenchShapes* shapes, long run)
+{
+    StyleVisitor visitor;
+
+    visitor.run = run;
+    visitor.i = 0;
+    shapes->traverse(visitor);
+}
+
+struct BatchDrawCase : public BenchCase
+{
+    BenchShapes*    shapes;
+    GiGraphics*     gs;
+    StateCanvas*    canvas;
+
+    void run() {
+        canvas->beginPaint();
+        shapes->draw(*gs);
+        canvas->endPaint();
+    }
+};
+
+// 在位图画布上显示，返回像素数据。
+// 不用反走样，反走样时相邻图元在同一路径中的边缘覆盖率与分别显示时略有差别
+static std::vector<UInt8> rasterize(BenchShapes* shapes, const Box2d& extent, bool batch)
+{
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    GiCanvasRaster canvas(&gs);
+
+    xf.setWndSize(800, 600);
+    xf.zoomTo(extent * xf.modelToWorld());
+    gs.setAntiAliasMode(false);
+    gs.setBatchMode(batch);
+    canvas.beginPaint();
+    shapes->draw(gs);
+    canvas.endPaint();
+
+    return std::vector<UInt8>(canvas.getPixels(),
+        canvas.getPixels() + canvas.getWidth() * canvas.getHeight() * 4);
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    long run = argc > 2 ? atol(argv[2]) : 20;
+    BenchShapes shapes;
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    StateCanvas canvas(&gs);
+    BatchDrawCase c;
+    int reps, ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    setStyles(&shapes, mgMax(run, 1L));
+    Box2d extent(shapes.getExtent());
+
+    xf.setWndSize(1024, 768);
+    xf.zoomTo(extent * xf.modelToWorld());
+    c.shapes = &shapes;
+    c.gs = &gs;
+    c.canvas = &canvas;
+
+    printf("shapes: %ld, shapes per style: %ld\n", count, run);
+    printf("%8s %10s %10s %12s %12s %10s %12s\n", "batch", "ms", "calls",
+           "pen changes", "brush chgs", "saved", "saved states");
+
+    for (int batch = 0; batch < 2; batch++) {
+        gs.setBatchMode(batch != 0);
+        canvas.primitives = canvas.penChanges = canvas.brushChanges = 0;
+        canvas.ctx = GiContext();
+        canvas.penWidth = -1;
+        gs.resetBatchStats();
+        c.run();
+
+        long calls = canvas.primitives;
+        long pens = canvas.penChanges;
+        long brushes = canvas.brushChanges;
+        const GiBatchStats& stats = gs.getBatchStats();
+        long savedCalls = stats.savedCalls(), savedStates = stats.savedStates;
+
+        double ms = benchRepeat(c, reps);
+        printf("%8s %10.3f %10ld %12ld %12ld %10ld %12ld\n", batch ? "on" : "off",
+               ms, calls, pens, brushes, savedCalls, savedStates);
+    }
+
+    std::vector<UInt8> a(rasterize(&shapes, extent, false));
+    std::vector<UInt8> b(rasterize(&shapes, extent, true));
+    long diff = 0;
+
+    for (size_t i = 0; i < a.size(); i += 4) {
+        if (memcmp(&a[i], &b[i], 4) != 0)
+            diff++;
+    }
+    printf("raster pixels different: %ld\n", diff);
+    if (diff > 0)
+        ret = 1;
+
+    return ret;
+}
@@ -0,0 +1,126 @@
+//! \file benchutil.h
+//! \brief 定义性能测试程序的计时辅助函数
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __TOUCHVG_BENCHUTIL_H_
+#define __TOUCHVG_BENCHUTIL_H_
+
+#include <mgshapest.h>
+#include <gicanvas.h>
+#include <testgraph/RandomShape.h>
+#include <stdlib.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+//! 返回以毫秒为单位的当前时刻
+inline double benchNow()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#endif
+}
+
+//! 重复执行的测试项
+struct BenchCase
+{
+    virtual ~BenchCase() {}
+    virtual void run() = 0;
+};
+
+//! 重复执行测试项直到累计时间达到 minMs 毫秒，返回平均每次的毫秒数
+inline double benchRepeat(BenchCase& c, int& reps, double minMs = 200, int maxReps = 1000)
+{
+    double start = benchNow();
+    double elapsed = 0;
+
+    for (reps = 0; reps < 1 || (elapsed < minMs && reps < maxReps); reps++) {
+        c.run();
+        elapsed = benchNow() - start;
+    }
+
+    return elapsed / reps;
+}
+
+//! 测试用的图形列表类型
+typedef MgShapesT<std::vector<MgShape*> > BenchShapes;
+
+//! 生成指定个数的随机图形(直线、矩形、样条曲线各占约三分之一)
+inline void benchRandomShapes(MgShapes* shapes, long count, unsigned seed = 1)
+{
+    RandomParam param;
+
+    srand(seed);
+    param.lineCount = count / 3;
+    param.rectCount = count / 3;
+    param.arcCount = 0;
+    param.curveCount = count - param.lineCount - param.rectCount;
+    param.initShapes(shapes);
+}
+
+//! 只统计图元个数和点数的画布，用于测量图形系统和图形列表本身的耗时
+class CountCanvas : public GiCanvas
+{
+public:
+    long    primitives;     // 图元个数
+    long    points;         // 图元的点数
+
+    CountCanvas(GiGraphics* gs) : primitives(0), points(0) {
+        gs->_setCanvas(this);
+        gs->_xf().setResolution(96);
+    }
+    void beginPaint() {
+        RECT_2D clipBox = { 0, 0, (float)owner()->xf().getWidth(), (float)owner()->xf().getHeight() };
+        owner2()->_beginPaint(clipBox);
+    }
+    void endPaint() { owner2()->_endPaint(); }
+
+    virtual void clearWindow() {}
+    virtual bool drawCachedBitmap(float, float, bool) { return false; }
+    virtual bool drawCachedBitmap2(const GiCanvas*, float, float, bool) { return false; }
+    virtual void saveCachedBitmap(bool) {}
+    virtual bool hasCachedBitmap(bool) const { return false; }
+    virtual bool isBufferedDrawing() const { return false; }
+    virtual int getCanvasType() const { return 0; }
+    virtual const GiContext* getCurrentContext() const { return &_ctx; }
+    virtual void _clipBoxChanged(const RECT_2D&) {}
+    virtual void _antiAliasModeChanged(bool) {}
+
+    virtual void clearCachedBitmap(bool) {}
+    virtual float getScreenDpi() const { return 96; }
+    virtual GiColor getBkColor() const { return GiColor::White(); }
+    virtual GiColor setBkColor(const GiColor& color) { return color; }
+    virtual bool rawLine(const GiContext*, float, float, float, float) { return add(2); }
+    virtual bool rawLines(const GiContext*, const Point2d*, int count) { return add(count); }
+    virtual bool rawBeziers(const GiContext*, const Point2d*, int count) { return add(count); }
+    virtual bool rawPolygon(const GiContext*, const Point2d*, int count) { return add(count); }
+    virtual bool rawRect(const GiContext*, float, float, float, float) { return add(4); }
+    virtual bool rawEllipse(const GiContext*, float, float, float, float) { return add(4); }
+    virtual bool rawPath(const GiContext*, int count, const Point2d*, const UInt8*) { return add(count); }
+    virtual bool rawBeginPath() { return true; }
+    virtual bool rawEndPath(const GiContext*, bool) { return add(0); }
+    virtual bool rawMoveTo(float, float) { points++; return true; }
+    virtual bool rawLineTo(float, float) { points++; return true; }
+    virtual bool rawBezierTo(const Point2d*, int count) { points += count; return true; }
+    virtual bool rawClosePath() { return true; }
+
+protected:
+    bool add(int count) { primitives++; points += count; return true; }
+
+private:
+    GiContext   _ctx;
+};
+
+#endif // __TOUCHVG_BENCHUTIL_H_
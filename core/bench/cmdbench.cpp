@@ -0,0 +1,128 @@
+// cmdbench.cpp: 比较多个文档共用全局命令管理器与各自使用命令管理器时的吞吐量
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: cmdbench [每个文档的图形个数] [毫秒数]，默认为500个图形、每种线程数运行500毫秒
+//       每个线程编辑一个文档：加载图形、写锁定图形列表、锁定动态图形后显示并等待输出(模拟提交到屏幕)。
+//       各自使用命令管理器时吞吐量不高于共用时返回1
+
+#include "benchutil.h"
+#include <mgcmd.h>
+#include <mgstoragebin.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+
+static const void*  s_docData = NULL;       // 各文档共用的图形数据
+static UInt32       s_docSize = 0;
+
+static void onShapesLocked(MgShapes*, void* obj, bool locked)
+{
+    if (!locked)
+        (*(long*)obj)++;
+}
+
+struct Session
+{
+    bool            ownManager;     // 是否使用自己的命令管理器和观察者
+    double          endTime;
+    long            iterations;
+    long            changes;        // 观察到的图形列表改变次数
+
+    static void* run(void* arg) {
+        Session* t = (Session*)arg;
+        MgCommandManager* cmds = t->ownManager ? mgCreateCommandManager() : mgGetCommandManager();
+        BenchShapes shapes;
+        GiTransform xf;
+        GiGraphics gs(&xf);
+        CountCanvas canvas(&gs);
+
+        if (t->ownManager)
+            MgShapesLock::registerObserver(&shapes, onShapesLocked, &t->changes);
+        xf.setWndSize(1024, 768);
+
+        while (benchNow() < t->endTime) {
+            MgStorageBin s;
+            if (s.attach(s_docData, s_docSize))
+                shapes.load(&s);                        // 按类型创建各个图形
+            {
+                MgShapesLock locker(&shapes, MgShapesLock::Edit, 5000);
+                if (locker.locked() && shapes.getLastShape())
+                    shapes.getLastShape()->shape()->offset(Vector2d(1, 0), -1);
+            }
+            {
+                MgDynShapeLock locker(cmds->getDynamicShapeLock(), true, 5000);
+                if (locker.locked()) {
+                    xf.zoomTo(shapes.getExtent() * xf.modelToWorld());
+                    canvas.beginPaint();
+                    shapes.draw(gs);
+                    canvas.endPaint();
+                    usleep(2000);                       // 等待输出
+                }
+            }
+            t->iterations++;
+        }
+
+        if (t->ownManager) {
+            MgShapesLock::unregisterObserver(&shapes, onShapesLocked, &t->changes);
+            cmds->release();
+        }
+        return NULL;
+    }
+};
+
+// 返回每秒完成的迭代次数
+static double runSessions(int threads, bool ownManager, int ms, long& changes)
+{
+    std::vector<Session> sessions(threads);
+    std::vector<pthread_t> ids(threads);
+    double start = benchNow();
+    long total = 0;
+
+    changes = 0;
+    for (int i = 0; i < threads; i++) {
+        sessions[i].ownManager = ownManager;
+        sessions[i].endTime = start + ms;
+        sessions[i].iterations = 0;
+        sessions[i].changes = 0;
+        pthread_create(&ids[i], NULL, Session::run, &sessions[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+        total += sessions[i].iterations;
+        changes += sessions[i].changes;
+    }
+
+    return total * 1000.0 / (benchNow() - start);
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 500;
+    int ms = argc > 2 ? atoi(argv[2]) : 500;
+    BenchShapes shapes;
+    MgStorageBin s;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    shapes.save(&s);
+    s_docData = s.getWrittenData(s_docSize);
+
+    printf("shapes per document: %ld, %d ms per run\n", count, ms);
+    printf("%8s %14s %14s %10s %12s\n", "threads", "shared iter/s", "own iter/s",
+           "speedup", "own changes");
+
+    const int threads[] = { 1, 2, 4, 8 };
+    for (int i = 0; i < 4; i++) {
+        long changes;
+        double shared = runSessions(threads[i], false, ms, changes);
+        double own = runSessions(threads[i], true, ms, changes);
+
+        printf("%8d %14.1f %14.1f %10.2f %12ld\n", threads[i], shared, own,
+               own / shared, changes);
+        if (threads[i] > 1 && own <= shared)
+            ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,173 @@
+// dlistbench.cpp: 比较平移放缩时逐个图形显示与重放显示列表的性能
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: dlistbench [图形个数]，默认为100000个图形
+//       两种方式输出的图元个数不一致、重放的点数比逐个图形显示多10%以上、
+//       或在显示图元时嵌套显示后外层显示的个数改变时返回1。
+//       逐个图形显示时部分可见的曲线只输出可见段，因此重放时的点数可能略多；
+//       放缩后显示缓存按新比例重新记录，折线的简化级别与逐个图形显示相同
+
+#include "benchutil.h"
+#include <mgdispcache.h>
+#include <stdio.h>
+
+// 在前几个图元输出时再显示一次图形列表或显示列表的画布，检查嵌套显示不影响外层的查找结果
+class NestedCanvas : public CountCanvas
+{
+public:
+    const BenchShapes*      shapes;     // 嵌套显示的图形列表
+    const GiDisplayList*    list;       // 嵌套显示的显示列表
+    int                     remain;     // 还要嵌套显示的次数
+
+    NestedCanvas(GiGraphics* gs) : CountCanvas(gs), shapes(NULL), list(NULL), remain(0) {}
+
+    void drawNested() {
+        if (remain > 0) {
+            remain--;                           // 先减，嵌套显示的图元不再嵌套
+            if (shapes)
+                shapes->draw(*owner2());
+            if (list)
+                list->draw(*owner2());
+        }
+    }
+    virtual bool rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2) {
+        drawNested();
+        return CountCanvas::rawLine(ctx, x1, y1, x2, y2);
+    }
+    virtual bool rawLines(const GiContext* ctx, const Point2d* pxs, int count) {
+        drawNested();
+        return CountCanvas::rawLines(ctx, pxs, count);
+    }
+    virtual bool rawBeziers(const GiContext* ctx, const Point2d* pxs, int count) {
+        drawNested();
+        return CountCanvas::rawBeziers(ctx, pxs, count);
+    }
+    virtual bool rawPolygon(const GiContext* ctx, const Point2d* pxs, int count) {
+        drawNested();
+        return CountCanvas::rawPolygon(ctx, pxs, count);
+    }
+};
+
+// 按一组显示比例和位置各显示一帧，模拟平移放缩
+struct PanZoomCase : public BenchCase
+{
+    BenchShapes*    shapes;
+    GiTransform*    xf;
+    GiGraphics*     gs;
+    CountCanvas*    canvas;
+    MgDisplayCache* cache;          // 为NULL时逐个图形显示
+    float           factor;         // 放大倍数
+    Point2d         centerW;
+    float           scale;
+    float           width;          // 全图显示时的世界坐标宽度
+
+    void run() {
+        for (int i = 0; i < 8; i++) {           // 绕中心平移
+            float d = 0.1f * (i - 4) / factor;
+            xf->zoom(centerW + Vector2d(d * width, 0), scale * factor);
+            canvas->beginPaint();
+            if (cache)
+                cache->draw(shapes, *gs);
+            else
+                shapes->draw(*gs);
+            canvas->endPaint();
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    BenchShapes shapes;
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    CountCanvas canvas(&gs);
+    MgDisplayCache cache;
+    int reps, ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    Box2d extent(shapes.getExtent());
+
+    xf.setWndSize(1024, 768);
+    xf.setViewScaleRange(1e-5f, 1e5f);
+    xf.zoomTo(extent * xf.modelToWorld());
+
+    PanZoomCase direct, replay;
+    direct.shapes = replay.shapes = &shapes;
+    direct.xf = replay.xf = &xf;
+    direct.gs = replay.gs = &gs;
+    direct.canvas = replay.canvas = &canvas;
+    direct.cache = NULL;
+    replay.cache = &cache;
+    direct.centerW = replay.centerW = xf.getCenterW();
+    direct.scale = replay.scale = xf.getViewScale();
+    direct.width = replay.width = (extent * xf.modelToWorld()).width();
+
+    double t = benchNow();
+    canvas.beginPaint();
+    cache.draw(&shapes, gs);                    // 首次显示时记录
+    canvas.endPaint();
+    t = benchNow() - t;
+
+    const GiDisplayList& list = cache.getDisplayList();
+    printf("shapes: %ld, record: %.2f ms, items: %lu, primitives: %lu, memory: %lu KB\n",
+           count, t, (unsigned long)list.getItemCount(),
+           (unsigned long)list.getPrimitiveCount(),
+           (unsigned long)list.getMemorySize() / 1024);
+    printf("%8s %12s %12s %9s %11s %12s %12s\n", "zoom", "direct ms", "replay ms",
+           "speedup", "primitives", "points", "replay pts");
+
+    const float factors[] = { 1, 4, 16, 64 };
+    for (int i = 0; i < 4; i++) {
+        direct.factor = replay.factor = factors[i];
+
+        canvas.primitives = canvas.points = 0;
+        direct.run();
+        long prims = canvas.primitives, points = canvas.points;
+
+        canvas.primitives = canvas.points = 0;
+        replay.run();
+        long points2 = canvas.points;
+        if (canvas.primitives != prims) {
+            printf("mismatch at zoom %g: %ld != %ld primitives\n",
+                   factors[i], prims, canvas.primitives);
+            ret = 1;
+        }
+        if (points2 > points + points / 10) {
+            printf("too many replayed points at zoom %g: %ld > %ld\n",
+                   factors[i], points2, points);
+            ret = 1;
+        }
+
+        double msDirect = benchRepeat(direct, reps) / 8;
+        double msReplay = benchRepeat(replay, reps) / 8;
+
+        printf("%8g %12.3f %12.3f %9.2f %11ld %12ld %12ld\n", factors[i],
+               msDirect, msReplay, msDirect / msReplay, prims / 8, points / 8, points2 / 8);
+    }
+
+    GiGraphics gs2(&xf);
+    NestedCanvas nested(&gs2);
+
+    xf.zoom(direct.centerW, direct.scale * 4);
+    nested.beginPaint();
+    int shapesDrawn = shapes.draw(gs2);
+    int itemsDrawn = list.draw(gs2);
+
+    nested.shapes = &shapes;
+    nested.remain = 3;
+    int shapesNested = shapes.draw(gs2);
+    nested.shapes = NULL;
+    nested.list = &list;
+    nested.remain = 3;
+    int itemsNested = list.draw(gs2);
+    nested.endPaint();
+
+    printf("nested draw: shapes %d (%d), display list items %d (%d)\n",
+           shapesNested, shapesDrawn, itemsNested, itemsDrawn);
+    if (shapesNested != shapesDrawn || itemsNested != itemsDrawn)
+        ret = 1;
+
+    return ret;
+}
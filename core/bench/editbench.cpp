@@ -0,0 +1,111 @@
+// editbench.cpp: 比较每次写锁定结束时同步全部图形的索引与只同步改变的图形的耗时
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: editbench [图形个数] [编辑次数]，默认为100000个图形、编辑2000次
+//       每次编辑写锁定图形列表，平移一个图形，部分编辑还平移两次或平移后删除。
+//       编辑后区域查找与遍历全部图形的结果不同、或只同步改变的图形不比全部同步快时返回1
+
+#include "benchutil.h"
+#include <mgcmd.h>
+#include <stdio.h>
+#include <algorithm>
+
+// 收集区域查找到的图形
+struct CollectVisitor : public MgShapeVisitor
+{
+    std::vector<MgShape*>   shapes;
+
+    bool visit(MgShape* sp) {
+        shapes.push_back(sp);
+        return true;
+    }
+};
+
+// 遍历全部图形，收集包络框与矩形框相交的图形
+struct FullVisitor : public MgShapeVisitor
+{
+    Box2d                   box;
+    std::vector<MgShape*>   shapes;
+
+    bool visit(MgShape* sp) {
+        if (sp->shape()->getExtent().isIntersect(box))
+            shapes.push_back(sp);
+        return true;
+    }
+};
+
+// 编辑图形，full为true时按原来的做法同步全部图形的索引，返回平均每次编辑的毫秒数
+static double editShapes(BenchShapes* shapes, int edits, bool full)
+{
+    double start = benchNow();
+
+    for (int i = 0; i < edits; i++) {
+        MgShapesLock locker(shapes, MgShapesLock::Edit);
+        UInt32 count = shapes->getShapeCount();
+        MgShape* sp = NULL;
+
+        shapes->getShapes((UInt32)rand() % count, 1, &sp);
+        for (int j = (i % 5 == 0) ? 2 : 1; j > 0; j--) {
+            sp->shape()->offset(Vector2d((float)(rand() % 200 - 100), (float)(rand() % 200 - 100)), -1);
+            sp->shape()->update();
+            if (full)
+                shapes->syncIndex();
+            else
+                shapes->shapeChanged(sp);
+        }
+        if (i % 7 == 0) {                   // 平移后删除，暂缓更新的空间索引中不能残留该图形
+            shapes->removeShape(sp->getID());
+            sp->release();
+        }
+    }
+
+    return (benchNow() - start) / edits;
+}
+
+// 检查区域查找结果是否与遍历全部图形的结果相同
+static bool checkQuery(BenchShapes* shapes)
+{
+    Box2d extent(shapes->getExtent());
+
+    for (int i = 0; i < 50; i++) {
+        Point2d pt(extent.xmin + extent.width() * (rand() % 1000) / 1000,
+                   extent.ymin + extent.height() * (rand() % 1000) / 1000);
+        CollectVisitor found;
+        FullVisitor full;
+
+        full.box.set(pt, extent.width() / 20, extent.height() / 20);
+        shapes->queryExtent(full.box, found);
+        shapes->traverse(full);
+        std::sort(found.shapes.begin(), found.shapes.end());
+        std::sort(full.shapes.begin(), full.shapes.end());
+        if (found.shapes != full.shapes)
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    int edits = argc > 2 ? atoi(argv[2]) : 2000;
+    BenchShapes shapes;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    printf("shapes: %ld, edits: %d\n", count, edits);
+
+    double fullMs = editShapes(&shapes, edits / 10, true);
+    bool fullOk = checkQuery(&shapes);
+    printf("sync all shapes      %10.4f ms/edit  query %s\n", fullMs, fullOk ? "ok" : "different");
+
+    double changedMs = editShapes(&shapes, edits, false);
+    bool changedOk = checkQuery(&shapes);
+    printf("sync changed shapes  %10.4f ms/edit  query %s\n", changedMs, changedOk ? "ok" : "different");
+
+    if (!fullOk || !changedOk || changedMs >= fullMs)
+        ret = 1;
+
+    return ret;
+}
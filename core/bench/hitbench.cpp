@@ -0,0 +1,202 @@
+// hitbench.cpp: 比较长折线和样条曲线逐段检查与按线段空间索引的点选和框选性能
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: hitbench [顶点数] [查找次数]，默认为20000个顶点、1000次查找
+//       两种方式的点选结果不一致时返回1
+
+#include "benchutil.h"
+#include <mgbasicsp.h>
+#include <mgnear.h>
+#include <mgcurv.h>
+#include <math.h>
+#include <stdio.h>
+
+static const float kTol = 0.5f;
+
+// 生成模拟手绘的曲线点，相邻点距约为1
+static void createStroke(MgBaseShape* sp, long count)
+{
+    Point2d pt;
+    float angle = 0, turn = 0;
+
+    ((MgBaseLines*)sp)->resize(count);
+    for (long i = 0; i < count; i++) {
+        turn = turn * 0.95f + RandomParam::RandF(-2, 2) * 0.01f;
+        angle += turn;
+        pt += Vector2d(cosf(angle), sinf(angle));
+        sp->setPoint(i, pt);
+    }
+    sp->update();
+}
+
+struct HitResult {
+    float   dist;
+    Int32   segment;
+};
+
+// 逐段检查的点选
+struct ScanHitCase : public BenchCase
+{
+    const std::vector<Point2d>& knots;
+    const std::vector<Vector2d>* knotvs;
+    const std::vector<Point2d>& pts;
+    std::vector<HitResult> results;
+    ScanHitCase(const std::vector<Point2d>& k, const std::vector<Vector2d>* v,
+                const std::vector<Point2d>& p)
+        : knots(k), knotvs(v), pts(p), results(p.size()) {}
+
+    virtual void run() {
+        Point2d nearpt;
+        for (size_t i = 0; i < pts.size(); i++) {
+            HitResult& r = results[i];
+            r.dist = knotvs ? mgCubicSplinesHit((Int32)knots.size(), &knots.front(),
+                &knotvs->front(), false, pts[i], kTol, nearpt, r.segment)
+                : mgLinesHit((Int32)knots.size(), &knots.front(), false,
+                pts[i], kTol, nearpt, r.segment);
+        }
+    }
+};
+
+// 图形的点选，段数较多时使用线段空间索引
+struct ShapeHitCase : public BenchCase
+{
+    const MgBaseShape* shape;
+    const std::vector<Point2d>& pts;
+    std::vector<HitResult> results;
+    ShapeHitCase(const MgBaseShape* s, const std::vector<Point2d>& p)
+        : shape(s), pts(p), results(p.size()) {}
+
+    virtual void run() {
+        Point2d nearpt;
+        for (size_t i = 0; i < pts.size(); i++) {
+            HitResult& r = results[i];
+            r.dist = shape->hitTest(pts[i], kTol, nearpt, r.segment);
+        }
+    }
+};
+
+// 逐段检查的样条曲线框选
+struct ScanBoxCase : public BenchCase
+{
+    const std::vector<Point2d>& knots;
+    const std::vector<Vector2d>& knotvs;
+    const std::vector<Box2d>& boxes;
+    long hits;
+    ScanBoxCase(const std::vector<Point2d>& k, const std::vector<Vector2d>& v,
+                const std::vector<Box2d>& b) : knots(k), knotvs(v), boxes(b), hits(0) {}
+
+    virtual void run() {
+        hits = 0;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            if (mgCubicSplinesIntersectBox(boxes[i], (Int32)knots.size(),
+                                           &knots.front(), &knotvs.front(), false))
+                hits++;
+        }
+    }
+};
+
+// 图形的框选
+struct ShapeBoxCase : public BenchCase
+{
+    const MgBaseShape* shape;
+    const std::vector<Box2d>& boxes;
+    long hits;
+    ShapeBoxCase(const MgBaseShape* s, const std::vector<Box2d>& b)
+        : shape(s), boxes(b), hits(0) {}
+
+    virtual void run() {
+        hits = 0;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            if (shape->hitTestBox(boxes[i]))
+                hits++;
+        }
+    }
+};
+
+static void report(const char* name, double ms, int reps, long count)
+{
+    printf("%-24s %10.3f ms  %8.3f us/query  (%d reps)\n",
+           name, ms, ms * 1000.0 / count, reps);
+}
+
+static bool sameResults(const std::vector<HitResult>& a, const std::vector<HitResult>& b)
+{
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].segment != b[i].segment || fabsf(a[i].dist - b[i].dist) > 1e-5f) {
+            printf("mismatch at %lu: segment %ld != %ld\n", (unsigned long)i,
+                   (long)a[i].segment, (long)b[i].segment);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 20000;
+    long queries = argc > 2 ? atol(argv[2]) : 1000;
+    MgBaseShape* lines = MgLines::create();
+    MgBaseShape* splines = MgSplines::create();
+    std::vector<Point2d> knots(count), pts(queries);
+    std::vector<Vector2d> knotvs(count);
+    std::vector<Box2d> boxes(queries);
+    int reps, ret = 0;
+    double ms;
+
+    srand(1);
+    createStroke(lines, count);
+    splines->copy(*lines);
+    splines->update();
+    for (long i = 0; i < count; i++)
+        knots[i] = lines->getPoint(i);
+    mgCubicSplines(count, &knots.front(), &knotvs.front());
+
+    Box2d rect(lines->getExtent());
+    for (long i = 0; i < queries; i++) {        // 一半在曲线附近，一半随机
+        Point2d pt(i % 2 ? knots[rand() % count] : Point2d(
+            RandomParam::RandF(rect.xmin, rect.xmax), RandomParam::RandF(rect.ymin, rect.ymax)));
+        pts[i] = pt + Vector2d(RandomParam::RandF(-1, 1), RandomParam::RandF(-1, 1)) * 0.3f;
+        boxes[i].set(pts[i], 2.f, 2.f);
+    }
+    printf("vertices: %ld, queries: %ld\n", count, queries);
+
+    ScanHitCase scanLines(knots, NULL, pts);
+    ms = benchRepeat(scanLines, reps);
+    report("lines scan hit", ms, reps, queries);
+
+    ShapeHitCase treeLines(lines, pts);
+    treeLines.run();                            // 首次查找时构造索引
+    ms = benchRepeat(treeLines, reps);
+    report("lines indexed hit", ms, reps, queries);
+    if (!sameResults(scanLines.results, treeLines.results))
+        ret = 1;
+
+    ScanHitCase scanSplines(knots, &knotvs, pts);
+    ms = benchRepeat(scanSplines, reps);
+    report("splines scan hit", ms, reps, queries);
+
+    ShapeHitCase treeSplines(splines, pts);
+    treeSplines.run();
+    ms = benchRepeat(treeSplines, reps);
+    report("splines indexed hit", ms, reps, queries);
+    if (!sameResults(scanSplines.results, treeSplines.results))
+        ret = 1;
+
+    ScanBoxCase scanBox(knots, knotvs, boxes);
+    ms = benchRepeat(scanBox, reps);
+    report("splines scan box", ms, reps, queries);
+
+    ShapeBoxCase treeBox(splines, boxes);
+    ms = benchRepeat(treeBox, reps);
+    report("splines indexed box", ms, reps, queries);
+    if (scanBox.hits != treeBox.hits) {
+        printf("box hits mismatch: %ld != %ld\n", scanBox.hits, treeBox.hits);
+        ret = 1;
+    }
+
+    lines->release();
+    splines->release();
+
+    return ret;
+}
@@ -0,0 +1,129 @@
+// lazybench.cpp: 检查延迟加载部分图形后的显示次序和保存次序，以及多个读线程同时加载图形
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: lazybench [图形个数] [读线程数]，默认为10000个图形、4个读线程
+//       先按视口加载一部分图形再遍历和保存，图形次序或范围与原图形列表不同、或图形个数不对时返回1
+
+#include "benchutil.h"
+#include <mgstoragebin.h>
+#include <pthread.h>
+#include <stdio.h>
+
+// 按遍历次序收集图形ID
+struct IdVisitor : public MgShapeVisitor
+{
+    std::vector<UInt32> ids;
+
+    bool visit(MgShape* sp) {
+        ids.push_back(sp->getID());
+        return true;
+    }
+};
+
+static std::vector<UInt32> collectIDs(const MgShapes* shapes)
+{
+    IdVisitor visitor;
+    shapes->traverse(visitor);
+    return visitor.ids;
+}
+
+// 从已保存的数据延迟加载图形
+static bool loadLazy(MgShapes* shapes, MgStorageBin& reader, MgStorageBin& writer)
+{
+    UInt32 size = 0;
+    const void* data = writer.getWrittenData(size);
+
+    shapes->clear();
+    return reader.attach(data, size) && shapes->loadLazy(&reader);
+}
+
+// 加载部分图形后保存，再完整加载，检查图形次序
+static bool checkOrder(const BenchShapes& shapes, const std::vector<UInt32>& ids)
+{
+    MgStorageBin r, w;
+    BenchShapes saved;
+
+    if (!shapes.save(&w) || !loadLazy(&saved, r, w))
+        return false;
+    return collectIDs(&saved) == ids;
+}
+
+// 读线程: 用不同的查找框同时触发延迟加载
+struct ReaderThread
+{
+    const BenchShapes*  shapes;
+    Box2d               box;
+    long                found;
+
+    static void* run(void* param) {
+        ReaderThread* p = (ReaderThread*)param;
+        Point2d nearpt;
+        Int32 segment;
+
+        for (int i = 0; i < 8; i++) {
+            Box2d box(p->box.center(), p->box.width() * (i + 1) / 8, p->box.height() * (i + 1) / 8);
+            if (p->shapes->hitTest(box, nearpt, segment))
+                p->found++;
+            p->shapes->getExtent();
+            p->shapes->getShapeCount();
+        }
+        return NULL;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 10000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    BenchShapes shapes;
+    MgStorageBin r, w;
+    BenchShapes loaded;
+    Point2d nearpt;
+    Int32 segment;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    std::vector<UInt32> ids(collectIDs(&shapes));
+    Box2d extent(shapes.getExtent());
+
+    shapes.save(&w);
+    printf("shapes: %ld, reader threads: %d\n", count, threads);
+
+    // 先加载后面的图形，再加载视口内的图形，最后按全图范围加载其余图形
+    if (!loadLazy(&loaded, r, w))
+        return 1;
+    loaded.findShape(ids[ids.size() * 3 / 4]);
+    loaded.hitTest(Box2d(extent.center(), extent.width() / 10, extent.height() / 10),
+                   nearpt, segment);
+    bool sameExtent = (loaded.getExtent() == extent);
+    loaded.hitTest(extent, nearpt, segment);
+    bool ordered = checkOrder(loaded, ids);
+    printf("partial load then save: %s\n", ordered ? "ordered" : "out of order");
+    printf("partial load extent: %s\n", sameExtent ? "same" : "different");
+    if (!ordered || !sameExtent)
+        ret = 1;
+
+    // 多个读线程同时按视口加载
+    if (!loadLazy(&loaded, r, w))
+        return 1;
+    std::vector<ReaderThread> readers(threads);
+    std::vector<pthread_t> tids(threads);
+    for (int i = 0; i < threads; i++) {
+        float x = extent.xmin + extent.width() * (i + 1) / (threads + 1);
+        readers[i].shapes = &loaded;
+        readers[i].box = Box2d(Point2d(x, extent.center().y), extent.width() / 2, extent.height());
+        readers[i].found = 0;
+        pthread_create(&tids[i], NULL, ReaderThread::run, &readers[i]);
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(tids[i], NULL);
+
+    bool same = (loaded.getShapeCount() == (UInt32)count && collectIDs(&loaded) == ids);
+    printf("concurrent readers: %lu shapes, %s\n",
+           (unsigned long)loaded.getShapeCount(), same ? "ordered" : "out of order");
+    if (!same || !checkOrder(loaded, ids))
+        ret = 1;
+
+    return ret;
+}
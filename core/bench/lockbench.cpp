@@ -0,0 +1,165 @@
+// lockbench.cpp: 多线程读写图形列表时比较轮询等待与阻塞等待的读写锁
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: lockbench [读线程数] [毫秒数]，默认为4个读线程(模拟显示)、1个写线程(模拟编辑)，各运行1000毫秒
+//       阻塞等待的锁有超时未锁定时返回1
+
+#include "benchutil.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+
+// 原来的读写锁算法: 锁定不了时每次休眠25毫秒再检查，读者不让写者优先
+class PollLockRW
+{
+public:
+    PollLockRW() { _counts[0] = _counts[1] = _counts[2] = 0; }
+
+    bool lock(bool forWrite, int timeout) {
+        bool ret = false;
+
+        if (1 == __sync_add_and_fetch(_counts, 1)) {
+            __sync_add_and_fetch(_counts + (forWrite ? 2 : 1), 1);
+            ret = true;
+        }
+        else {
+            ret = !forWrite && 0 == _counts[2];
+            for (int i = 0; i < timeout && !ret; i += 25) {
+                usleep(25 * 1000);
+                ret = forWrite ? (!_counts[1] && !_counts[2]) : !_counts[2];
+            }
+            if (ret)
+                __sync_add_and_fetch(_counts + (forWrite ? 2 : 1), 1);
+            else
+                __sync_sub_and_fetch(_counts, 1);
+        }
+
+        return ret;
+    }
+
+    void unlock(bool forWrite) {
+        __sync_sub_and_fetch(_counts + (forWrite ? 2 : 1), 1);
+        __sync_sub_and_fetch(_counts, 1);
+    }
+
+private:
+    volatile long _counts[3];
+};
+
+// 各线程的等待时间统计
+struct WaitStats
+{
+    long    locks;
+    long    timeouts;
+    double  waitTime;
+    double  maxWait;
+
+    WaitStats() : locks(0), timeouts(0), waitTime(0), maxWait(0) {}
+
+    void add(double wait, bool locked) {
+        if (!locked) {
+            timeouts++;
+            return;
+        }
+        locks++;
+        waitTime += wait;
+        if (maxWait < wait)
+            maxWait = wait;
+    }
+    void merge(const WaitStats& s) {
+        locks += s.locks;
+        timeouts += s.timeouts;
+        waitTime += s.waitTime;
+        if (maxWait < s.maxWait)
+            maxWait = s.maxWait;
+    }
+};
+
+template <class LOCK>
+struct LockThread
+{
+    LOCK*       lock;
+    bool        forWrite;
+    int         holdUs;         // 每次锁定后占用的微秒数
+    int         idleUs;         // 每次解锁后空闲的微秒数
+    double      endTime;
+    WaitStats   stats;
+
+    static void* run(void* arg) {
+        LockThread* t = (LockThread*)arg;
+
+        while (benchNow() < t->endTime) {
+            double start = benchNow();
+            bool locked = t->lock->lock(t->forWrite, 200);
+
+            t->stats.add(benchNow() - start, locked);
+            if (locked) {
+                usleep(t->holdUs);
+                t->lock->unlock(t->forWrite);
+            }
+            usleep(t->idleUs);
+        }
+        return NULL;
+    }
+};
+
+// 启动一个写线程和多个读线程，返回读者和写者的等待统计
+template <class LOCK>
+static void runThreads(LOCK& lock, int readers, int ms, WaitStats& rs, WaitStats& ws)
+{
+    std::vector<LockThread<LOCK> > threads(readers + 1);
+    std::vector<pthread_t> ids(threads.size());
+    double endTime = benchNow() + ms;
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        LockThread<LOCK>& t = threads[i];
+        t.lock = &lock;
+        t.forWrite = (i == 0);
+        t.holdUs = t.forWrite ? 3000 : 2000;    // 编辑3毫秒，显示2毫秒
+        t.idleUs = t.forWrite ? 5000 : 500;     // 读者几乎连续地显示
+        t.endTime = endTime;
+        pthread_create(&ids[i], NULL, LockThread<LOCK>::run, &t);
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        pthread_join(ids[i], NULL);
+        if (threads[i].forWrite)
+            ws.merge(threads[i].stats);
+        else
+            rs.merge(threads[i].stats);
+    }
+}
+
+static void printStats(const char* name, const char* role, const WaitStats& s)
+{
+    printf("%8s %8s %8ld %10ld %12.3f %12.3f\n", name, role, s.locks, s.timeouts,
+           s.locks ? s.waitTime / s.locks : 0.0, s.maxWait);
+}
+
+int main(int argc, char* argv[])
+{
+    int readers = argc > 1 ? atoi(argv[1]) : 4;
+    int ms = argc > 2 ? atoi(argv[2]) : 1000;
+    WaitStats pollReaders, pollWriters, rwReaders, rwWriters;
+    PollLockRW pollLock;
+    MgLockRW rwLock;
+
+    printf("readers: %d, writers: 1, %d ms\n", readers, ms);
+    runThreads(pollLock, readers, ms, pollReaders, pollWriters);
+    runThreads(rwLock, readers, ms, rwReaders, rwWriters);
+
+    printf("%8s %8s %8s %10s %12s %12s\n", "lock", "thread", "locks",
+           "timeouts", "avg wait ms", "max wait ms");
+    printStats("poll", "reader", pollReaders);
+    printStats("poll", "writer", pollWriters);
+    printStats("rwlock", "reader", rwReaders);
+    printStats("rwlock", "writer", rwWriters);
+
+    MgLockStats stats(rwLock.getStats());
+    printf("rwlock stats: locks %ld (write %ld), contended %ld, timeouts %ld, "
+           "wait %.1f ms (max %.3f), hold %.1f ms (max %.3f)\n",
+           stats.locks, stats.writeLocks, stats.contended, stats.timeouts,
+           stats.waitTime, stats.maxWait, stats.holdTime, stats.maxHold);
+
+    return rwReaders.timeouts + rwWriters.timeouts > 0 ? 1 : 0;
+}
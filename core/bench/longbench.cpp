@@ -0,0 +1,130 @@
+// longbench.cpp: 检查点数超过0x2000的图形的存取，以及折线、曲线和多边形是否连续输出
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: longbench [顶点数]，默认为20000个顶点
+//       锯齿波浪线保存后重新加载，再按全图和局部显示各种线型，
+//       加载的点不同、连续的线分成多个图元输出、或多边形填充不是一个路径时返回1
+
+#include "benchutil.h"
+#include <mgstoragebin.h>
+#include <mgshapet.h>
+#include <mgbasicsp.h>
+#include <math.h>
+#include <stdio.h>
+
+// 另外统计填充路径个数的画布
+class PathCanvas : public CountCanvas
+{
+public:
+    long    fills;          // 填充的路径个数
+
+    PathCanvas(GiGraphics* gs) : CountCanvas(gs), fills(0) {}
+
+    void reset() {
+        primitives = 0;
+        points = 0;
+        fills = 0;
+    }
+    virtual bool rawEndPath(const GiContext* ctx, bool fill) {
+        if (fill)
+            fills++;
+        return CountCanvas::rawEndPath(ctx, fill);
+    }
+};
+
+// 生成沿X轴的锯齿波浪线，横向范围为0到3000，相邻点的纵向距离较大以免显示时被当作重合点
+static void wavePoints(long count, std::vector<Point2d>& pts, std::vector<Vector2d>& vecs)
+{
+    pts.resize(count);
+    vecs.resize(count);
+    for (long i = 0; i < count; i++) {
+        float x = 3000.f * i / (count - 1);
+        pts[i].set(x, 50.f * sinf(x * 0.05f) + (i % 2 ? 10.f : -10.f));
+        vecs[i].set(1.f, 2.5f * cosf(x * 0.05f));
+    }
+}
+
+// 保存后重新加载，检查点数和坐标
+static bool checkLoad(const std::vector<Point2d>& pts)
+{
+    BenchShapes shapes, loaded;
+    MgShapeT<MgLines> shape;
+    MgStorageBin r, w;
+    UInt32 size = 0;
+
+    shape._shape.resize((UInt32)pts.size());
+    MgShape* added = shapes.addShape(shape);
+    for (UInt32 i = 0; i < pts.size(); i++)
+        added->shape()->setPoint(i, pts[i]);
+    added->shape()->update();
+    if (!shapes.save(&w))
+        return false;
+
+    const void* data = w.getWrittenData(size);
+    if (!r.attach(data, size) || !loaded.load(&r) || loaded.getShapeCount() != 1)
+        return false;
+
+    const MgBaseShape* sp = loaded.getLastShape()->shapec();
+    bool same = (sp->getPointCount() == pts.size());
+
+    for (UInt32 i = 0; same && i < pts.size(); i++)
+        same = (sp->getPoint(i) == pts[i]);
+    printf("load: %lu points, %s\n", (unsigned long)sp->getPointCount(), same ? "same" : "different");
+
+    return same;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 20000;
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    PathCanvas canvas(&gs);
+    GiContext ctx;
+    std::vector<Point2d> pts;
+    std::vector<Vector2d> vecs;
+    int ret = 0;
+
+    if (count <= 0x2000) {
+        printf("the count must be greater than %d\n", 0x2000);
+        return 1;
+    }
+    wavePoints(count, pts, vecs);
+    if (!checkLoad(pts))
+        ret = 1;
+
+    ctx.setFillColor(GiColor(0, 0, 255, 64));
+    xf.setWndSize(1024, 768);
+    printf("%8s %10s %12s %10s %10s\n", "view", "type", "primitives", "points", "fills");
+
+    for (int k = 0; k < 2; k++) {
+        if (k == 0)                         // 全图显示
+            xf.zoomTo(Box2d(0.f, -100.f, 3000.f, 100.f) * xf.modelToWorld());
+        else                                // 只显示中间部分，可见的一段线超过0x2000个点
+            xf.zoomTo(Box2d(500.f, -100.f, 2500.f, 100.f) * xf.modelToWorld());
+
+        for (int type = 0; type < 5; type++) {
+            const char* names[] = { "lines", "beziers", "splines", "bsplines", "polygon" };
+            int n = (int)count;
+
+            canvas.reset();
+            canvas.beginPaint();
+            switch (type) {
+            case 0: gs.drawLines(&ctx, n, &pts.front()); break;
+            case 1: gs.drawBeziers(&ctx, 1 + (n - 1) / 3 * 3, &pts.front()); break;
+            case 2: gs.drawSplines(&ctx, n, &pts.front(), &vecs.front()); break;
+            case 3: gs.drawBSplines(&ctx, n, &pts.front()); break;
+            default: gs.drawPolygon(&ctx, n, &pts.front()); break;
+            }
+            canvas.endPaint();
+
+            printf("%8s %10s %12ld %10ld %10ld\n", k ? "part" : "all", names[type],
+                   canvas.primitives, canvas.points, canvas.fills);
+            if (type < 4 ? canvas.primitives != 1 : canvas.fills != 1)
+                ret = 1;
+        }
+    }
+
+    return ret;
+}
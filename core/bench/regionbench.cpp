@@ -0,0 +1,164 @@
+// regionbench.cpp: 比较拖动框选时每次遍历全部图形与增量区域查找的耗时
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: regionbench [图形个数] [拖动次数]，默认为100000个图形、拖动400次
+//       选择框先逐步扩大再逐步缩小，每次移动图形范围的千分之一。
+//       增量查找与遍历全部图形的结果或最上面的选中图形不同时返回1
+
+#include "benchutil.h"
+#include <mgregion.h>
+#include <mgshapet.h>
+#include <mgbasicsp.h>
+#include <algorithm>
+#include <stdio.h>
+
+// 生成分布在图形范围内的小图形(直线、矩形、折线各占约三分之一)，大小约为范围的百分之一
+static void localShapes(BenchShapes* shapes, long count)
+{
+    srand(1);
+    for (long i = 0; i < count; i++) {
+        Point2d pt((float)(rand() % 20000) / 10 - 1000, (float)(rand() % 20000) / 10 - 1000);
+        Vector2d vec((float)(rand() % 400) / 10 - 20, (float)(rand() % 400) / 10 - 20);
+
+        MgShape* sp;
+
+        if (i % 3 == 0) {
+            sp = shapes->addShape(MgShapeT<MgLine>());
+            sp->shape()->setPoint(0, pt);
+            sp->shape()->setPoint(1, pt + vec);
+        }
+        else if (i % 3 == 1) {
+            MgShapeT<MgRect> shape;
+            shape._shape.setRect(Box2d(pt, pt + vec));
+            sp = shapes->addShape(shape);
+        }
+        else {
+            MgShapeT<MgLines> shape;
+            shape._shape.resize(4);
+            sp = shapes->addShape(shape);
+            for (UInt32 j = 0; j < 4; j++)      // 锯齿线
+                sp->shape()->setPoint(j, pt + Vector2d(vec.x * j / 3, j % 2 ? vec.y : 0));
+        }
+        sp->shape()->update();
+        shapes->shapeChanged(sp);           // 按更新后的包络框同步索引
+    }
+    shapes->afterChanged();
+}
+
+// 原来的框选做法: 每次拖动都按显示次序判断所有图形
+struct FullVisitor : public MgShapeVisitor
+{
+    Box2d                   box;
+    bool                    contains;
+    std::vector<UInt32>     ids;
+    UInt32                  topID;      // 最后选中的即为显示在最上面的
+
+    bool visit(MgShape* sp) {
+        if (contains ? box.contains(sp->shape()->getExtent())
+            : sp->shape()->hitTestBox(box)) {
+            ids.push_back(sp->getID());
+            topID = sp->getID();
+        }
+        return true;
+    }
+};
+
+struct DragResult
+{
+    double  fullMs;         // 平均每次拖动遍历全部图形的毫秒数
+    double  deltaMs;        // 平均每次拖动增量查找的毫秒数
+    double  tested;         // 增量查找平均每次判断的图形个数
+    long    selected;       // 最大选中个数
+    long    mismatches;
+};
+
+static DragResult runDrag(BenchShapes* shapes, bool contains, int events)
+{
+    DragResult ret = { 0, 0, 0, 0, 0 };
+    Box2d extent(shapes->getExtent());
+    Point2d start(extent.center() - Vector2d(extent.width(), extent.height()) / 8);
+    Vector2d step(extent.width() / 1000, extent.height() / 1000);
+    MgRegionSelection region;
+    FullVisitor full;
+
+    full.contains = contains;
+    for (int i = 0; i < events; i++) {
+        int k = i < events / 2 ? i + 1 : events - i;        // 先扩大再缩小
+        Box2d box(start, start + step * (float)k);
+        MgRegionQuery query(box, contains);
+
+        double t = benchNow();
+        full.box = box;
+        full.ids.clear();
+        full.topID = 0;
+        shapes->traverse(full);
+        std::sort(full.ids.begin(), full.ids.end());
+        ret.fullMs += benchNow() - t;
+
+        t = benchNow();
+        region.update(shapes, query);
+        ret.deltaMs += benchNow() - t;
+        ret.tested += region.getTestedCount();
+
+        if (region.getIDs() != full.ids || region.getTopID() != full.topID)
+            ret.mismatches++;
+        if (ret.selected < (long)full.ids.size())
+            ret.selected = (long)full.ids.size();
+    }
+
+    ret.fullMs /= events;
+    ret.deltaMs /= events;
+    ret.tested /= events;
+
+    return ret;
+}
+
+// 与选择框相同的套索多边形应得到相同的相交结果
+static bool checkLasso(BenchShapes* shapes)
+{
+    Box2d extent(shapes->getExtent());
+    Box2d box(extent.center(), extent.width() / 5, extent.height() / 5);
+    Point2d pts[] = { box.leftBottom(), box.rightBottom(), box.rightTop(), box.leftTop() };
+    MgRegionSelection rect, lasso;
+
+    rect.update(shapes, MgRegionQuery(box));
+    lasso.update(shapes, MgRegionQuery(4, pts));
+    printf("lasso: %lu selected, rectangle: %lu selected\n",
+           (unsigned long)lasso.getIDs().size(), (unsigned long)rect.getIDs().size());
+
+    return lasso.getIDs().size() >= rect.getIDs().size() / 2;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    int events = argc > 2 ? atoi(argv[2]) : 400;
+    BenchShapes shapes;
+    int ret = 0;
+
+    printf("shapes: %ld, drag events: %d\n", count, events);
+    printf("%8s %10s %12s %12s %12s %10s %10s\n", "shapes", "mode", "full ms", "delta ms",
+           "tested", "selected", "mismatch");
+
+    for (int k = 0; k < 2; k++) {           // 随机图形多为贯穿全图的长直线和曲线
+        if (k == 0)
+            benchRandomShapes(&shapes, count);
+        else {
+            shapes.clear();
+            localShapes(&shapes, count);
+        }
+        for (int i = 0; i < 2; i++) {
+            DragResult r = runDrag(&shapes, i > 0, events);
+            printf("%8s %10s %12.4f %12.4f %12.1f %10ld %10ld\n", k ? "local" : "random",
+                   i > 0 ? "contains" : "intersect",
+                   r.fullMs, r.deltaMs, r.tested, r.selected, r.mismatches);
+            if (r.mismatches > 0)
+                ret = 1;
+        }
+        if (!checkLasso(&shapes))
+            ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,199 @@
+// renderbench.cpp: 测试图形列表的显示、点选、框选、存取和范围计算的性能
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: renderbench [最大图形个数]，默认为1000000个图形
+// 依次测试1000、10000、100000、1000000个图形(不超过最大个数)，结果以JSON格式输出到stdout
+
+#include "benchutil.h"
+#include <mgstoragebin.h>
+#include <stdio.h>
+
+// 以JSON格式输出一项测试结果
+static void report(long count, const char* name, double ms, int reps, const char* extra = "")
+{
+    static bool first = true;
+
+    printf("%s\n    {\"shapes\": %ld, \"name\": \"%s\", \"ms\": %.4f, \"reps\": %d%s}",
+           first ? "" : ",", count, name, ms, reps, extra);
+    first = false;
+}
+
+struct DrawCase : public BenchCase {
+    BenchShapes*    shapes;
+    GiGraphics*     gs;
+    CountCanvas*    canvas;
+    int             drawn;
+
+    void run() {
+        canvas->beginPaint();
+        drawn = shapes->draw(*gs);
+        canvas->endPaint();
+    }
+};
+
+struct HitTestCase : public BenchCase {
+    BenchShapes*            shapes;
+    std::vector<Point2d>    pts;
+    float                   tol;
+    int                     found;
+
+    void run() {
+        found = 0;
+        for (size_t i = 0; i < pts.size(); i++) {
+            Point2d nearpt;
+            Int32 segment;
+            if (shapes->hitTest(Box2d(pts[i], 2 * tol, 2 * tol), nearpt, segment))
+                found++;
+        }
+    }
+};
+
+// 与 MgCommandSelect 滑动多选的做法相同
+struct BoxSelectCase : public BenchCase, public MgShapeVisitor {
+    BenchShapes*        shapes;
+    std::vector<Box2d>  boxes;
+    bool                intersect;
+    long                found;
+    Box2d               box;
+
+    void run() {
+        found = 0;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            box = boxes[i];
+            shapes->traverse(*this);
+        }
+    }
+
+    bool visit(MgShape* sp) {
+        if (intersect ? sp->shape()->hitTestBox(box)
+            : box.contains(sp->shape()->getExtent()))
+            found++;
+        return true;
+    }
+};
+
+struct SaveCase : public BenchCase {
+    BenchShapes*    shapes;
+    MgStorageBin    s;
+    UInt32          size;
+
+    void run() {
+        s.resetWriting();
+        shapes->save(&s);
+        s.getWrittenData(size);
+    }
+};
+
+struct LoadCase : public BenchCase {
+    const void*     data;
+    UInt32          size;
+    long            loaded;
+
+    void run() {
+        MgStorageBin s;
+        BenchShapes shapes;
+        s.attach(data, size);
+        shapes.load(&s);
+        loaded = (long)shapes.getShapeCount();
+    }
+};
+
+struct ExtentCase : public BenchCase {
+    BenchShapes*    shapes;
+    Box2d           extent;
+
+    void run() { extent = shapes->getExtent(); }
+};
+
+static void benchShapes(long count)
+{
+    BenchShapes shapes;
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    CountCanvas canvas(&gs);
+    char extra[120];
+    int reps;
+    double ms;
+
+    benchRandomShapes(&shapes, count);
+
+    ExtentCase ext;
+    ext.shapes = &shapes;
+    ms = benchRepeat(ext, reps);
+    report(count, "getExtent", ms, reps);
+
+    xf.setWndSize(1024, 768);
+    xf.setViewScaleRange(1e-5f, 1e5f);
+    xf.zoomTo(ext.extent * xf.modelToWorld());
+
+    const float factors[] = { 0.25f, 1, 4, 16, 64 };
+    Point2d centerW(xf.getCenterW());
+    float scale = xf.getViewScale();
+
+    DrawCase draw;
+    draw.shapes = &shapes;
+    draw.gs = &gs;
+    draw.canvas = &canvas;
+    for (int i = 0; i < 5; i++) {
+        xf.zoom(centerW, scale * factors[i]);
+        canvas.primitives = canvas.points = 0;
+        ms = benchRepeat(draw, reps);
+        sprintf(extra, ", \"zoom\": %g, \"drawn\": %d, \"primitives\": %ld, \"points\": %ld",
+                factors[i], draw.drawn, canvas.primitives / reps, canvas.points / reps);
+        report(count, "draw", ms, reps, extra);
+    }
+    xf.zoom(centerW, scale);
+
+    const Box2d& rect = ext.extent;
+    HitTestCase hit;
+    hit.shapes = &shapes;
+    hit.tol = xf.displayToModel(5.f);
+    srand(2);
+    for (int i = 0; i < 200; i++) {
+        hit.pts.push_back(Point2d(RandomParam::RandF(rect.xmin, rect.xmax),
+                                  RandomParam::RandF(rect.ymin, rect.ymax)));
+    }
+    ms = benchRepeat(hit, reps);
+    sprintf(extra, ", \"queries\": %d, \"found\": %d", (int)hit.pts.size(), hit.found);
+    report(count, "hitTest", ms, reps, extra);
+
+    BoxSelectCase boxsel;
+    boxsel.shapes = &shapes;
+    for (int i = 0; i < 10; i++) {
+        Point2d pt(RandomParam::RandF(rect.xmin, rect.xmax), RandomParam::RandF(rect.ymin, rect.ymax));
+        boxsel.boxes.push_back(Box2d(pt, rect.width() * 0.1f, rect.height() * 0.1f));
+    }
+    for (int i = 0; i < 2; i++) {
+        boxsel.intersect = (i == 1);
+        ms = benchRepeat(boxsel, reps);
+        sprintf(extra, ", \"queries\": %d, \"found\": %ld", (int)boxsel.boxes.size(), boxsel.found);
+        report(count, i ? "boxSelectIntersect" : "boxSelectContain", ms, reps, extra);
+    }
+
+    SaveCase save;
+    save.shapes = &shapes;
+    ms = benchRepeat(save, reps, 200, 20);
+    sprintf(extra, ", \"bytes\": %ld", (long)save.size);
+    report(count, "save", ms, reps, extra);
+
+    LoadCase load;
+    load.data = save.s.getWrittenData(load.size);
+    ms = benchRepeat(load, reps, 200, 20);
+    sprintf(extra, ", \"loaded\": %ld", load.loaded);
+    report(count, "load", ms, reps, extra);
+}
+
+int main(int argc, char* argv[])
+{
+    long maxCount = argc > 1 ? atol(argv[1]) : 1000000;
+
+    printf("{\n  \"benchmark\": \"renderbench\",\n  \"results\": [");
+    for (long count = 1000; count <= maxCount; count *= 10) {
+        benchShapes(count);
+        fflush(stdout);
+    }
+    printf("\n  ]\n}\n");
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+// smoothbench.cpp: 比较样条曲线整体重算与局部拟合的去点性能和误差
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: smoothbench [最大点数] [局部范围]，默认为5000个点、局部范围为6
+//       原曲线各点到去点后曲线的距离超过公差时返回1
+
+#include "benchutil.h"
+#include <mgbasicsp.h>
+#include <math.h>
+#include <stdio.h>
+
+static const float kTol = 0.5f;
+
+// 生成模拟手绘的曲线点，相邻点距约为1
+static MgBaseShape* createStroke(long count)
+{
+    MgBaseShape* sp = MgSplines::create();
+    Point2d pt;
+    float angle = 0, turn = 0;
+
+    ((MgSplines*)sp)->resize(count);
+    for (long i = 0; i < count; i++) {
+        turn = turn * 0.95f + RandomParam::RandF(-2, 2) * 0.01f;
+        angle += turn;
+        pt += Vector2d(cosf(angle), sinf(angle)) + Vector2d(
+            RandomParam::RandF(-1, 1) * 0.1f, RandomParam::RandF(-1, 1) * 0.1f);
+        sp->setPoint(i, pt);
+    }
+    sp->update();
+
+    return sp;
+}
+
+// 原曲线各点到新曲线的最大距离
+static float maxDeviation(const MgBaseShape* src, const MgBaseShape* dest)
+{
+    float maxDist = 0;
+    Point2d nearpt;
+    Int32 segment;
+
+    for (UInt32 i = 0; i < src->getPointCount(); i++) {
+        float dist = dest->hitTest(src->getPoint(i), kTol * 4, nearpt, segment);
+        maxDist = mgMax(maxDist, dist);
+    }
+
+    return maxDist;
+}
+
+// 去点并返回耗时的毫秒数
+static double smooth(MgBaseShape* sp, UInt32 window)
+{
+    double t = benchNow();
+    ((MgSplines*)sp)->smooth(kTol, window);
+    return benchNow() - t;
+}
+
+int main(int argc, char* argv[])
+{
+    long maxCount = argc > 1 ? atol(argv[1]) : 5000;
+    UInt32 window = argc > 2 ? (UInt32)atol(argv[2]) : 6;
+    int ret = 0;
+
+    srand(1);
+    printf("tol: %g, window: %lu\n", kTol, (unsigned long)window);
+    printf("%8s %12s %8s %10s %12s %8s %10s\n", "points",
+           "global ms", "kept", "max dist", "local ms", "kept", "max dist");
+
+    for (long n = 500; n <= maxCount; n *= 2) {
+        MgBaseShape* src = createStroke(n);
+        MgBaseShape* global = MgSplines::create();
+        MgBaseShape* local = MgSplines::create();
+
+        global->copy(*src);
+        global->update();
+        local->copy(*src);
+        local->update();
+
+        double msGlobal = smooth(global, 0);
+        double msLocal = smooth(local, window);
+        float errGlobal = maxDeviation(src, global);
+        float errLocal = maxDeviation(src, local);
+
+        printf("%8ld %12.2f %8lu %10.4f %12.2f %8lu %10.4f\n", n,
+               msGlobal, (unsigned long)global->getPointCount(), errGlobal,
+               msLocal, (unsigned long)local->getPointCount(), errLocal);
+        if (errLocal >= kTol) {
+            printf("local smooth exceeds tolerance\n");
+            ret = 1;
+        }
+
+        src->release();
+        global->release();
+        local->release();
+    }
+
+    return ret;
+}
@@ -0,0 +1,171 @@
+// snapbench.cpp: 比较显示线程锁定图形列表与显示只读快照时编辑线程的等待时间
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: snapbench [图形个数] [编辑次数]，默认为100000个图形、编辑50次
+//       显示线程连续显示，编辑线程每次移动一个图形。
+//       快照中的图形个数不对或共用图形个数与预期不符时返回1
+
+#include "benchutil.h"
+#include <mgsnapshot.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+
+struct RenderThread
+{
+    BenchShapes*        shapes;         // 锁定方式时显示的图形列表
+    MgSnapshotStore*    store;          // 快照方式时不为NULL
+    Box2d               extent;
+    volatile bool       stop;
+    long                frames;
+    long                badFrames;      // 快照图形个数不对的帧数
+    UInt32              shapeCount;
+
+    static void* run(void* arg) {
+        RenderThread* t = (RenderThread*)arg;
+        GiTransform xf;
+        GiGraphics gs(&xf);
+        CountCanvas canvas(&gs);
+        int reader = t->store ? t->store->registerReader() : -1;
+
+        xf.setWndSize(1024, 768);
+        xf.zoomTo(t->extent * xf.modelToWorld());
+
+        while (!t->stop) {
+            canvas.beginPaint();
+            if (t->store) {
+                MgSnapshotReader r(t->store, reader);       // 不锁定图形列表
+                if (r.snapshot()) {
+                    if (r.snapshot()->getShapeCount() != t->shapeCount)
+                        t->badFrames++;
+                    r.snapshot()->draw(gs);
+                }
+            }
+            else {
+                MgShapesLock locker(t->shapes, MgShapesLock::ReadOnly, 1000);
+                if (locker.locked())
+                    t->shapes->draw(gs);
+            }
+            canvas.endPaint();
+            t->frames++;
+        }
+        if (t->store)
+            t->store->unregisterReader(reader);
+
+        return NULL;
+    }
+};
+
+struct EditResult
+{
+    double  avgWait;        // 平均每次编辑等待锁定的毫秒数
+    double  maxWait;
+    double  avgPublish;     // 平均每次发布快照的毫秒数
+    long    frames;
+    long    badFrames;
+};
+
+// 编辑线程(本线程)移动图形，显示线程同时显示
+static EditResult runEdits(BenchShapes* shapes, MgSnapshotStore* store, int edits)
+{
+    RenderThread render;
+    pthread_t tid;
+    EditResult ret = { 0, 0, 0, 0, 0 };
+    double publishTime = 0;
+
+    render.shapes = shapes;
+    render.store = store;
+    render.extent = shapes->getExtent();
+    render.stop = false;
+    render.frames = render.badFrames = 0;
+    render.shapeCount = shapes->getShapeCount();
+    if (store)
+        store->publish(shapes);
+    pthread_create(&tid, NULL, RenderThread::run, &render);
+
+    for (int i = 0; i < edits; i++) {
+        usleep(2000);                           // 模拟触摸事件的间隔
+        UInt32 index = (UInt32)rand() % shapes->getShapeCount();
+        double t = benchNow();
+
+        if (store) {                            // 编辑线程独自改写图形列表
+            MgShape* sp = shapes->findShape(index + 1);
+            if (sp) {
+                sp->shape()->offset(Vector2d(1, 1), -1);
+                shapes->shapeChanged(sp);
+                shapes->afterChanged();
+            }
+            t = benchNow();
+            store->publish(shapes);
+            publishTime += benchNow() - t;
+        }
+        else {
+            MgShapesLock locker(shapes, MgShapesLock::Edit, 5000);
+            double wait = benchNow() - t;
+            MgShape* sp = locker.locked() ? shapes->findShape(index + 1) : NULL;
+
+            ret.avgWait += wait;
+            if (ret.maxWait < wait)
+                ret.maxWait = wait;
+            if (sp)
+                sp->shape()->offset(Vector2d(1, 1), -1);
+        }
+    }
+
+    render.stop = true;
+    pthread_join(tid, NULL);
+
+    ret.avgWait /= edits;
+    ret.avgPublish = publishTime / edits;
+    ret.frames = render.frames;
+    ret.badFrames = render.badFrames;
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    int edits = argc > 2 ? atoi(argv[2]) : 50;
+    BenchShapes shapes;
+    MgSnapshotStore store;
+    UInt32 shared, copied;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    printf("shapes: %ld, edits: %d\n", count, edits);
+
+    double t = benchNow();
+    store.publish(&shapes);
+    t = benchNow() - t;
+    store.getPublishStats(shared, copied);
+    printf("first publish: %.2f ms, copied %lu shapes\n", t, (unsigned long)copied);
+
+    MgShape* sp = shapes.findShape(1);          // 改变一个图形后再发布，只复制该图形
+    sp->shape()->offset(Vector2d(1, 1), -1);
+    t = benchNow();
+    store.publish(&shapes);
+    t = benchNow() - t;
+    store.getPublishStats(shared, copied);
+    printf("publish after one edit: %.2f ms, shared %lu, copied %lu\n",
+           t, (unsigned long)shared, (unsigned long)copied);
+    if (copied != 1 || shared + 1 != shapes.getShapeCount())
+        ret = 1;
+
+    EditResult locked = runEdits(&shapes, NULL, edits);
+    EditResult snap = runEdits(&shapes, &store, edits);
+
+    printf("%10s %14s %14s %14s %10s\n", "mode", "avg wait ms", "max wait ms",
+           "publish ms", "frames");
+    printf("%10s %14.3f %14.3f %14s %10ld\n", "lock", locked.avgWait, locked.maxWait,
+           "-", locked.frames);
+    printf("%10s %14.3f %14.3f %14.3f %10ld\n", "snapshot", snap.avgWait, snap.maxWait,
+           snap.avgPublish, snap.frames);
+    printf("retired versions not reclaimed: %lu, bad frames: %ld\n",
+           (unsigned long)store.getRetiredCount(), snap.badFrames);
+    if (snap.badFrames > 0)
+        ret = 1;
+
+    return ret;
+}
@@ -0,0 +1,91 @@
+// splinebench.cpp: 比较闭合三次样条曲线的稠密矩阵解法与循环三对角线解法
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: splinebench [最大型值点数]，默认为100000个点
+//       稠密矩阵解法需要n*n个浮点数，超过 kMaxDense 个点时不测试
+
+#include "benchutil.h"
+#include <mgcurv.h>
+#include <math.h>
+#include <stdio.h>
+
+static const int kMaxDense = 2000;
+
+// 原来的解法: 构造n*n稠密矩阵，用 mgGaussJordan 求解
+struct DenseCase : public BenchCase
+{
+    const std::vector<Point2d>& knots;
+    std::vector<Vector2d>& vecs;
+    std::vector<float> mat;
+    DenseCase(const std::vector<Point2d>& k, std::vector<Vector2d>& v)
+        : knots(k), vecs(v), mat(k.size() * k.size()) {}
+
+    virtual void run() {
+        int n = (int)knots.size(), n1 = n - 1;
+        float* a = &mat.front();
+
+        for (int i = n*n - 1; i >= 0; i--)
+            a[i] = 0.f;
+        a[n1] = 1; a[0] = 4; a[1] = 1;
+        a[n1*n+n1-1] = 1; a[n1*n+n1] = 4; a[n1*n] = 1;
+        vecs[0] = (knots[1] - knots[n1]) * 3;
+        vecs[n1] = (knots[0] - knots[n1-1]) * 3;
+        for (int i = 1; i < n1; i++) {
+            a[i*n+i-1] = 1; a[i*n+i] = 4; a[i*n+i+1] = 1;
+            vecs[i] = (knots[i+1] - knots[i-1]) * 3;
+        }
+        mgGaussJordan(n, a, &vecs.front());
+    }
+};
+
+// 循环三对角线解法
+struct CyclicCase : public BenchCase
+{
+    const std::vector<Point2d>& knots;
+    std::vector<Vector2d>& vecs;
+    CyclicCase(const std::vector<Point2d>& k, std::vector<Vector2d>& v)
+        : knots(k), vecs(v) {}
+
+    virtual void run() {
+        mgCubicSplines((Int32)knots.size(), &knots.front(), &vecs.front(), kCubicLoop);
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    long maxCount = argc > 1 ? atol(argv[1]) : 100000;
+    int reps;
+
+    srand(1);
+    printf("%8s %14s %14s %12s\n", "knots", "dense ms", "cyclic ms", "max diff");
+
+    for (long n = 10; n <= maxCount; n *= 10) {
+        std::vector<Point2d> knots(n);
+        std::vector<Vector2d> vecs1(n), vecs2(n);
+
+        for (long i = 0; i < n; i++) {
+            float angle = _M_2PI * i / n;
+            float r = RandomParam::RandF(80, 120);
+            knots[i].set(r * cosf(angle), r * sinf(angle));
+        }
+
+        CyclicCase cyclic(knots, vecs2);
+        double msCyclic = benchRepeat(cyclic, reps);
+
+        if (n > kMaxDense) {
+            printf("%8ld %14s %14.4f %12s\n", n, "-", msCyclic, "-");
+            continue;
+        }
+
+        DenseCase dense(knots, vecs1);
+        double msDense = benchRepeat(dense, reps, 200, n > 500 ? 3 : 1000);
+        float diff = 0;
+
+        for (long i = 0; i < n; i++)
+            diff = mgMax(diff, (vecs1[i] - vecs2[i]).length());
+        printf("%8ld %14.4f %14.4f %12g\n", n, msDense, msCyclic, diff);
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+// storagebench.cpp: 比较二进制存取类与按名称存取的图形保存和加载性能
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: storagebench [图形个数]，默认为100000个图形
+
+#include "benchutil.h"
+#include <mgstoragebin.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+
+// 按字段名查找的内存存取类，模拟XML、JSON等按名称存取的方式
+class NamedStorage : public MgStorage
+{
+    struct Field {
+        std::string         name;
+        std::vector<float>  values;
+        std::string         text;
+    };
+    struct Node {
+        std::string         name;
+        std::vector<Field>  fields;
+        std::vector<Node*>  children;
+        Node*               parent;
+        Node(const char* s, Node* p) : name(s), parent(p) {}
+        ~Node() {
+            for (size_t i = 0; i < children.size(); i++)
+                delete children[i];
+        }
+    };
+    Node    _root;
+    Node*   _cur;
+
+    const Field* find(const char* name) const {
+        for (size_t i = 0; i < _cur->fields.size(); i++) {
+            if (_cur->fields[i].name == name)
+                return &_cur->fields[i];
+        }
+        return NULL;
+    }
+    void add(const char* name, const float* values, int count, const char* text = "") {
+        Field f;
+        f.name = name;
+        f.values.assign(values, values + count);
+        f.text = text;
+        _cur->fields.push_back(f);
+    }
+
+public:
+    NamedStorage() : _root("", NULL), _cur(&_root) {}
+    void rewind() { _cur = &_root; }
+
+    virtual bool readNode(const char* name, int index, bool ended) {
+        if (ended) {
+            _cur = _cur->parent;
+            return true;
+        }
+        size_t i = index < 0 ? 0 : (size_t)index;
+        if (i < _cur->children.size() && _cur->children[i]->name == name) {
+            _cur = _cur->children[i];
+            return true;
+        }
+        return false;
+    }
+    virtual bool readBool(const char* name, bool defvalue) {
+        const Field* f = find(name);
+        return f ? f->values[0] != 0 : defvalue;
+    }
+    virtual float readFloat(const char* name, float defvalue = 0) {
+        const Field* f = find(name);
+        return f ? f->values[0] : defvalue;
+    }
+    virtual int readFloatArray(const char* name, float* values, int count) {
+        const Field* f = find(name);
+        if (!f)
+            return 0;
+        if (!values)
+            return (int)f->values.size();
+        std::vector<float> tmp(f->values);      // 模拟经 mgvector 中转复制
+        int n = mgMin(count, (int)tmp.size());
+        for (int i = 0; i < n; i++)
+            values[i] = tmp[i];
+        return n;
+    }
+    virtual int readString(const char* name, char* value, int count) {
+        const Field* f = find(name);
+        int n = f ? (int)f->text.size() : 0;
+        if (value && n > 0) {
+            n = mgMin(n, count);
+            memcpy(value, f->text.c_str(), n);
+        }
+        return n;
+    }
+    virtual bool writeNode(const char* name, int, bool ended) {
+        if (ended) {
+            _cur = _cur->parent;
+        }
+        else {
+            _cur->children.push_back(new Node(name, _cur));
+            _cur = _cur->children.back();
+        }
+        return true;
+    }
+    virtual void writeBool(const char* name, bool value) {
+        float v = value ? 1.f : 0.f;
+        add(name, &v, 1);
+    }
+    virtual void writeFloat(const char* name, float value) { add(name, &value, 1); }
+    virtual void writeFloatArray(const char* name, const float* values, int count) {
+        add(name, values, count);
+    }
+    virtual void writeString(const char* name, const char* value) { add(name, NULL, 0, value); }
+
+protected:
+    virtual int readInt(const char* name, int defvalue = 0) {
+        const Field* f = find(name);
+        return f ? (int)f->values[0] : defvalue;
+    }
+    virtual void writeInt(const char* name, int value) {
+        float v = (float)value;
+        add(name, &v, 1);
+    }
+};
+
+static void report(const char* name, double ms, long count)
+{
+    printf("%-24s %10.2f ms  %8.3f us/shape\n", name, ms, ms * 1000.0 / count);
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 100000;
+    const char* filename = "storagebench.tvgb";
+    BenchShapes shapes;
+    double t;
+
+    benchRandomShapes(&shapes, count);
+    printf("shapes: %ld\n", (long)shapes.getShapeCount());
+
+    {
+        NamedStorage s;
+        BenchShapes loaded;
+
+        t = benchNow();
+        shapes.save(&s);
+        report("named save", benchNow() - t, count);
+
+        s.rewind();
+        t = benchNow();
+        loaded.load(&s);
+        report("named load", benchNow() - t, count);
+    }
+    {
+        MgStorageBin s;
+        BenchShapes loaded;
+        UInt32 size = 0;
+
+        t = benchNow();
+        shapes.save(&s);
+        s.getWrittenData(size);
+        report("binary save", benchNow() - t, count);
+
+        t = benchNow();
+        s.save(filename);
+        report("binary write file", benchNow() - t, count);
+        printf("binary size: %.2f MB\n", size / 1048576.0);
+
+        MgStorageBin r;
+        t = benchNow();
+        bool ret = r.open(filename) && loaded.load(&r);
+        report("binary mmap load", benchNow() - t, count);
+        r.close();
+
+        if (!ret || loaded.getShapeCount() != shapes.getShapeCount()) {
+            printf("binary load failed: %ld shapes\n", (long)loaded.getShapeCount());
+            return 1;
+        }
+        remove(filename);
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// strokebench.cpp: 检查徒手绘制折线时在线去点的顶点数和偏差
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: strokebench [采样点数]，默认为2000个采样点
+//       模拟手绘的采样点和先前进再回钩的采样点分别经折线命令去点，
+//       有采样点到结果折线的距离超过容差、两个命令管理器的统计互相影响、
+//       或同名的其他命令被当作折线命令时返回1
+
+#include "benchutil.h"
+#include <mgcmddraw.h>
+#include <math.h>
+#include <stdio.h>
+
+// 名称与折线命令相同的其他命令
+class SameNameCommand : public MgBaseCommand
+{
+public:
+    virtual const char* getName() const { return "lines"; }
+    virtual void release() {}
+};
+
+// 只提供图形列表和坐标系的视图
+class StrokeView : public MgView
+{
+public:
+    BenchShapes     shapes_;
+    GiTransform     xf;
+    GiGraphics      gs;
+
+    StrokeView() : gs(&xf) {
+        xf.setResolution(96);
+        xf.setWndSize(1024, 768);
+    }
+    virtual MgShapes* shapes() { return &shapes_; }
+    virtual GiTransform* xform() { return &xf; }
+    virtual GiGraphics* graph() { return &gs; }
+    virtual void regen() {}
+    virtual void redraw(bool) {}
+};
+
+// 用折线命令输入一组采样点(模型坐标)，返回生成的图形
+static MgShape* drawStroke(MgCommandManager* cmds, MgMotion& motion,
+                           const std::vector<Point2d>& pts)
+{
+    MgCommand* cmd = cmds->getCommand();
+    const Matrix2d& m2d = motion.view->xform()->modelToDisplay();
+
+    motion.startPointM = pts[0];
+    motion.startPoint = pts[0] * m2d;
+    for (size_t i = 1; i < pts.size(); i++) {
+        motion.lastPointM = pts[i - 1];
+        motion.lastPoint = pts[i - 1] * m2d;
+        motion.pointM = pts[i];
+        motion.point = pts[i] * m2d;
+        if (i == 1)
+            cmd->touchBegan(&motion);
+        else if (i + 1 < pts.size())
+            cmd->touchMoved(&motion);
+        else
+            cmd->touchEnded(&motion);
+    }
+
+    return motion.view->shapes()->getLastShape();
+}
+
+// 采样点到折线的最大距离
+static float maxDeviation(const MgShape* sp, const std::vector<Point2d>& pts)
+{
+    float maxDist = 0;
+    Point2d nearpt;
+    Int32 segment;
+
+    for (size_t i = 0; i < pts.size(); i++) {
+        float dist = sp->shapec()->hitTest(pts[i], _FLT_MAX, nearpt, segment);
+        maxDist = mgMax(maxDist, dist);
+    }
+
+    return maxDist;
+}
+
+// 生成模拟手绘的采样点，相邻点距约为2像素
+static void handStroke(const GiTransform& xf, long count, std::vector<Point2d>& pts)
+{
+    Point2d pt(100, 400);
+    float angle = 0, turn = 0;
+
+    srand(1);
+    pts.resize(count);
+    for (long i = 0; i < count; i++) {
+        turn = turn * 0.95f + RandomParam::RandF(-2, 2) * 0.01f;
+        angle += turn;
+        pt += Vector2d(cosf(angle), sinf(angle)) * 2.f + Vector2d(
+            RandomParam::RandF(-1, 1) * 0.2f, RandomParam::RandF(-1, 1) * 0.2f);
+        pts[i] = pt * xf.displayToModel();
+    }
+}
+
+// 沿X轴前进10倍容差后回钩到9.05倍容差处，回钩点与X轴夹角的正弦为0.099
+static void hookStroke(float tol, std::vector<Point2d>& pts)
+{
+    float angle = asinf(0.099f);
+
+    pts.clear();
+    for (int i = 0; i <= 10; i++)
+        pts.push_back(Point2d(tol * i, 0));
+    pts.push_back(Point2d(9.05f * tol * cosf(angle), 9.05f * tol * sinf(angle)));
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 2000;
+    StrokeView view;
+    MgMotion motion;
+    MgCommandManager* cmds = mgCreateCommandManager();
+    MgCommandManager* other = mgCreateCommandManager();
+    int ret = 0;
+
+    motion.view = &view;
+    if (!cmds->setCommand(&motion, "lines") || !other->setCommand(&motion, "lines")) {
+        printf("lines command not found\n");
+        return 1;
+    }
+
+    MgStrokeFilter* filter = mgGetStrokeFilter(cmds->getCommand());
+    MgStrokeFilter* otherFilter = mgGetStrokeFilter(other->getCommand());
+    filter->fastVelocity = 0;                   // 容差不随速度放大
+    float tol = mgDisplayMmToModel(filter->tol, &motion);
+
+    printf("samples: %ld, tol: %g mm (%g model)\n", count, filter->tol, tol);
+    printf("%8s %10s %10s %12s %12s\n", "stroke", "samples", "vertices", "max dist", "dist/tol");
+
+    const char* names[] = { "hand", "hook" };
+    std::vector<Point2d> pts;
+
+    for (int k = 0; k < 2; k++) {
+        if (k == 0)
+            handStroke(view.xf, count, pts);
+        else
+            hookStroke(tol, pts);
+
+        MgShape* sp = drawStroke(cmds, motion, pts);
+        if (!sp) {
+            printf("%s stroke not added\n", names[k]);
+            return 1;
+        }
+
+        float dist = maxDeviation(sp, pts);
+        printf("%8s %10lu %10lu %12.4f %12.4f\n", names[k], (unsigned long)pts.size(),
+               (unsigned long)sp->shapec()->getPointCount(), dist, dist / tol);
+        if (dist > tol * 1.001f)
+            ret = 1;
+    }
+
+    printf("kept: %ld, dropped: %ld; other manager kept: %ld, dropped: %ld\n",
+           filter->kept, filter->dropped, otherFilter->kept, otherFilter->dropped);
+    if (otherFilter->kept != 0 || otherFilter->dropped != 0)
+        ret = 1;
+
+    SameNameCommand sameName;
+    if (mgGetStrokeFilter(&sameName)) {
+        printf("command of the same name taken as lines command\n");
+        ret = 1;
+    }
+
+    cmds->release();
+    other->release();
+
+    return ret;
+}
@@ -0,0 +1,135 @@
+// tilebench.cpp: 比较直接显示与瓦片缓存显示的耗时、生成的瓦片个数和显示结果
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: tilebench [图形个数]，默认为20000个图形
+//       依次按整像素平移、小数像素平移、放大后缩小回原比例显示，每五个图形有一个为虚线。
+//       瓦片显示与直接显示的像素不一致、或回到已显示过的位置时还要生成瓦片时返回1
+
+#include "benchutil.h"
+#include <mgdispcache.h>
+#include <giraster.h>
+#include <stdio.h>
+#include <string.h>
+
+// 设置不透明的颜色，以免瓦片合成时的颜色舍入与直接显示不同
+struct OpaqueVisitor : public MgShapeVisitor
+{
+    long    i;
+
+    bool visit(MgShape* sp) {
+        GiContext* ctx = sp->context();
+        GiColor color(ctx->getLineColor());
+
+        ctx->setLineColor(GiColor(color.r, color.g, color.b));
+        ctx->setLineStyle(i++ % 5 ? kLineSolid : kLineDash);
+        if (sp->shape()->isClosed() && i % 2)
+            ctx->setFillColor(GiColor(color.g, color.b, color.r));
+        else
+            ctx->setNoFillColor();
+        return true;
+    }
+};
+
+// 只显示实线或虚线图形
+struct LayerVisitor : public MgShapeVisitor
+{
+    GiGraphics*     gs;
+    bool            dashed;
+
+    bool visit(MgShape* sp) {
+        if ((sp->contextc()->getLineStyle() != kLineSolid) == dashed)
+            sp->draw(*gs);
+        return true;
+    }
+};
+
+// 在位图画布上显示，tiles不为NULL时用瓦片显示，返回像素数据。
+// 直接显示时与瓦片显示一样先显示实线图形，再显示虚线图形
+static std::vector<UInt8> rasterize(BenchShapes* shapes, const GiTransform& view,
+                                    MgTileLayer* tiles, double& ms, int& rendered)
+{
+    GiTransform xf;
+    GiGraphics gs(&xf);
+    GiCanvasRaster canvas(&gs);
+
+    xf.copy(view);
+    gs.setAntiAliasMode(false);
+    rendered = 0;
+
+    double t = benchNow();
+    canvas.beginPaint();
+    if (tiles) {
+        tiles->draw(shapes, gs, &rendered);
+    }
+    else {
+        LayerVisitor visitor;
+        visitor.gs = &gs;
+        for (int i = 0; i < 2; i++) {
+            visitor.dashed = (i > 0);
+            shapes->queryExtent(gs.getClipModel(), visitor);
+        }
+    }
+    canvas.endPaint();
+    ms = benchNow() - t;
+
+    return std::vector<UInt8>(canvas.getPixels(),
+        canvas.getPixels() + canvas.getWidth() * canvas.getHeight() * 4);
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 20000;
+    BenchShapes shapes;
+    GiTransform xf;
+    MgTileLayer tiles;
+    OpaqueVisitor visitor;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    visitor.i = 0;
+    shapes.traverse(visitor);
+
+    xf.setResolution(96);
+    xf.setWndSize(800, 600);
+    xf.zoomTo(shapes.getExtent() * xf.modelToWorld());
+    xf.zoomByFactor(1.f);                   // 放大一倍，平移时露出新的瓦片
+
+    printf("shapes: %ld, tile size: %d\n", count, tiles.tiles().getTileSize());
+    printf("%14s %10s %10s %10s %12s\n", "view", "direct ms", "tiled ms", "rendered", "diff pixels");
+
+    const char* names[] = { "first", "pan 300", "pan back", "pan 0.3", "pan 0.3 back",
+                            "zoom in", "zoom out" };
+
+    for (int k = 0; k < 7; k++) {
+        switch (k) {
+        case 1: xf.zoomPan(300, 120); break;
+        case 2: xf.zoomPan(-300, -120); break;
+        case 3: xf.zoomPan(0.3f, -0.3f); break;
+        case 4: xf.zoomPan(-0.3f, 0.3f); break;
+        case 5: xf.zoomByFactor(1.f); break;
+        case 6: xf.zoomByFactor(-1.f); break;
+        }
+
+        double directMs, tiledMs;
+        int rendered, unused;
+        std::vector<UInt8> a(rasterize(&shapes, xf, NULL, directMs, unused));
+        std::vector<UInt8> b(rasterize(&shapes, xf, &tiles, tiledMs, rendered));
+        long diff = 0;
+
+        for (size_t i = 0; i < a.size(); i += 4) {
+            if (memcmp(&a[i], &b[i], 4) != 0)
+                diff++;
+        }
+        printf("%14s %10.3f %10.3f %10d %12ld\n", names[k], directMs, tiledMs, rendered, diff);
+
+        if (diff > (long)a.size() / 4 / 1000)   // 允许千分之一的像素因坐标舍入而不同
+            ret = 1;
+        if ((k == 2 || k == 4 || k == 6) && rendered > 0)
+            ret = 1;
+    }
+    printf("tiles: %d, memory: %ld KB\n", tiles.tiles().getTileCount(),
+           tiles.tiles().getMemoryUsed() / 1024);
+
+    return ret;
+}
@@ -0,0 +1,163 @@
+// traversebench.cpp: 比较迭代器遍历、回调遍历和批量获取图形的耗时与堆内存分配次数
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: traversebench [图形个数] [遍历次数]，默认为10000个图形、遍历1000次
+//       每次遍历都收集包络框与图形选择框相交的图形，模拟滑动多选。
+//       回调遍历或批量获取有堆内存分配、或与迭代器遍历的结果不同时返回1
+
+#include "benchutil.h"
+#include <stdio.h>
+#include <new>
+
+static long s_allocs = 0;       // 累计的堆内存分配次数
+
+void* operator new(size_t size)
+{
+    s_allocs++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) throw()
+{
+    free(p);
+}
+#endif
+
+struct TraverseCase : public BenchCase
+{
+    BenchShapes*    shapes;
+    Box2d           box;
+    long            found;
+
+    bool check(MgShape* sp) {
+        return sp->shape()->getExtent().isIntersect(box);
+    }
+};
+
+// 原来的做法: 每次遍历分配一个迭代器
+struct IteratorCase : public TraverseCase
+{
+    void run() {
+        void* it = NULL;
+        for (MgShape* sp = shapes->getFirstShape(it); sp; sp = shapes->getNextShape(it)) {
+            if (check(sp))
+                found++;
+        }
+        shapes->freeIterator(it);
+    }
+};
+
+struct VisitorCase : public TraverseCase, public MgShapeVisitor
+{
+    void run() {
+        shapes->traverse(*this);
+    }
+
+    bool visit(MgShape* sp) {
+        if (check(sp))
+            found++;
+        return true;
+    }
+};
+
+// 一次取出全部图形，数组由调用者预先分配
+struct BatchCase : public TraverseCase
+{
+    std::vector<MgShape*>   buffer;
+
+    void run() {
+        UInt32 n = shapes->getShapes(0, (UInt32)buffer.size(), &buffer.front());
+        for (UInt32 i = 0; i < n; i++) {
+            if (check(buffer[i]))
+                found++;
+        }
+    }
+};
+
+struct Result
+{
+    double  ms;
+    long    allocs;
+    long    found;
+};
+
+static Result runCase(TraverseCase& c, int times)
+{
+    Result ret;
+    long allocs = s_allocs;
+    double t = benchNow();
+
+    c.found = 0;
+    for (int i = 0; i < times; i++)
+        c.run();
+    ret.ms = (benchNow() - t) / times;
+    ret.allocs = s_allocs - allocs;
+    ret.found = c.found;
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 10000;
+    int times = argc > 2 ? atoi(argv[2]) : 1000;
+    BenchShapes shapes;
+    IteratorCase iter;
+    VisitorCase visitor;
+    BatchCase batch;
+    int ret = 0;
+
+    benchRandomShapes(&shapes, count);
+    Box2d extent(shapes.getExtent());
+    Box2d box(extent.center(), extent.width() / 4, extent.height() / 4);
+    TraverseCase* cases[] = { &iter, &visitor, &batch };
+
+    for (int i = 0; i < 3; i++) {
+        cases[i]->shapes = &shapes;
+        cases[i]->box = box;
+    }
+    batch.buffer.resize(shapes.getShapeCount());
+
+    printf("shapes: %ld, traversals: %d\n", count, times);
+    printf("%10s %12s %10s %10s\n", "method", "ms/pass", "allocs", "found");
+
+    const char* names[] = { "iterator", "traverse", "getShapes" };
+    Result results[3];
+
+    for (int i = 0; i < 3; i++) {
+        results[i] = runCase(*cases[i], times);
+        printf("%10s %12.4f %10ld %10ld\n", names[i], results[i].ms,
+               results[i].allocs, results[i].found);
+    }
+    for (int i = 1; i < 3; i++) {
+        if (results[i].allocs > 0 || results[i].found != results[0].found)
+            ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,107 @@
+// xformbench.cpp: 比较逐点与批量坐标变换的性能
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+//
+// 用法: xformbench [点数]，默认为1000000个点
+
+#include "benchutil.h"
+#include <mgbox.h>
+#include <stdio.h>
+
+// 逐点乘以矩阵
+struct ScalarCase : public BenchCase
+{
+    const Matrix2d& mat;
+    const std::vector<Point2d>& src;
+    std::vector<Point2d>& dest;
+    ScalarCase(const Matrix2d& m, const std::vector<Point2d>& s, std::vector<Point2d>& d)
+        : mat(m), src(s), dest(d) {}
+    virtual void run() {
+        int n = (int)src.size();
+        for (int i = 0; i < n; i++)
+            dest[i] = src[i] * mat;
+    }
+};
+
+// 批量变换，可同时计算包络框
+struct BatchCase : public BenchCase
+{
+    const Matrix2d& mat;
+    const std::vector<Point2d>& src;
+    std::vector<Point2d>& dest;
+    Box2d* box;
+    BatchCase(const Matrix2d& m, const std::vector<Point2d>& s,
+              std::vector<Point2d>& d, Box2d* b)
+        : mat(m), src(s), dest(d), box(b) {}
+    virtual void run() {
+        mat.TransformPoints((int)src.size(), &src.front(), &dest.front(), box);
+    }
+};
+
+// 逐点乘以矩阵并计算包络框
+struct ScalarBoxCase : public ScalarCase
+{
+    Box2d& box;
+    ScalarBoxCase(const Matrix2d& m, const std::vector<Point2d>& s,
+                  std::vector<Point2d>& d, Box2d& b)
+        : ScalarCase(m, s, d), box(b) {}
+    virtual void run() {
+        ScalarCase::run();
+        box.set((int)dest.size(), &dest.front());
+    }
+};
+
+static void report(const char* name, double ms, int reps, long count)
+{
+    printf("%-24s %10.3f ms  %8.1f Mpts/s  (%d reps)\n",
+           name, ms, count / ms / 1000.0, reps);
+}
+
+int main(int argc, char* argv[])
+{
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    if (count < 1)
+        count = 1;
+
+    std::vector<Point2d> src(count), dest1(count), dest2(count);
+    Matrix2d mat(Matrix2d::rotation(0.3f, Point2d(10, 20)) * Matrix2d::scaling(2.5f));
+    Box2d box1, box2;
+    int reps;
+    double ms;
+
+    srand(1);
+    for (long i = 0; i < count; i++) {
+        src[i].set(RandomParam::RandF(-1000, 1000), RandomParam::RandF(-1000, 1000));
+    }
+    printf("points: %ld\n", count);
+
+    ScalarCase scalar(mat, src, dest1);
+    ms = benchRepeat(scalar, reps);
+    report("scalar operator*", ms, reps, count);
+
+    BatchCase batch(mat, src, dest2, NULL);
+    ms = benchRepeat(batch, reps);
+    report("batch TransformPoints", ms, reps, count);
+
+    ScalarBoxCase scalarBox(mat, src, dest1, box1);
+    ms = benchRepeat(scalarBox, reps);
+    report("scalar with box", ms, reps, count);
+
+    BatchCase batchBox(mat, src, dest2, &box2);
+    ms = benchRepeat(batchBox, reps);
+    report("batch with box", ms, reps, count);
+
+    for (long i = 0; i < count; i++) {
+        if (dest1[i] != dest2[i]) {
+            printf("mismatch at %ld: (%g, %g) != (%g, %g)\n", i,
+                   dest1[i].x, dest1[i].y, dest2[i].x, dest2[i].y);
+            return 1;
+        }
+    }
+    if (box1 != box2) {
+        printf("box mismatch\n");
+        return 1;
+    }
+
+    return 0;
+}
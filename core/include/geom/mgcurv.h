@@ -160,11 +160,32 @@ GEOMAPI bool mgArcBulge(
     \param[in] c 系数矩阵中的右对角线元素数组，c[0..n-2]
     \param[in,out] vs 输入方程组等号右边的已知n个矢量，输出求解出的未知矢量
     \return 是否求解成功，失败原因可能是参数错误或因系数矩阵非主角占优而出现除零
-    \see mgGaussJordan
+    \see mgGaussJordan, mgCyclicTriEquations
 */
 GEOMAPI bool mgTriEquations(
     Int32 n, float *a, float *b, float *c, Vector2d *vs);
 
+//! 求解循环三对角线方程组
+/*! 循环三对角线方程组如下所示，右上角和左下角各多一个元素: \n
+    　　　| b0　　　c0　　　　　　a[n-1] | \n
+    A　=　| a0　　　b1　　　c1　　　　　 | \n
+    　　　|　　..　　　..　　.. 　　　　 | \n
+    　　　| c[n-1]　　　a[n-2]　　b[n-1] | \n
+    A * (x,y) = (rx,ry) \n
+    采用 Sherman-Morrison 公式化为两个三对角线方程组，时间和空间复杂度都为O(n)。
+
+    \ingroup GEOMAPI_BASIC
+    \param[in] n 方程组阶数，最小为3
+    \param[in] a 系数矩阵中的左对角线元素数组，a[0..n-2]，a[n-1]为右上角元素
+    \param[in,out] b 系数矩阵中的中对角线元素数组，b[0..n-1]，会被修改
+    \param[in] c 系数矩阵中的右对角线元素数组，c[0..n-2]，c[n-1]为左下角元素
+    \param[in,out] vs 输入方程组等号右边的已知n个矢量，输出求解出的未知矢量
+    \return 是否求解成功，失败原因可能是参数错误或因系数矩阵非主角占优而出现除零
+    \see mgTriEquations
+*/
+GEOMAPI bool mgCyclicTriEquations(
+    Int32 n, float *a, float *b, float *c, Vector2d *vs);
+
 //! Gauss-Jordan法求解线性方程组
 /*!
     \ingroup GEOMAPI_BASIC
@@ -284,4 +305,16 @@ GEOMAPI void mgFitClampedSpline(
     const Point2d* knots, Int32 i, float t, float sigma,
     const float* hp, const Vector2d* knotvs, Point2d& fitpt);
 
+//! 用 Douglas-Peucker 算法简化折线，去掉的顶点到简化后折线的距离不超过容差
+/*!
+    \ingroup GEOMAPI_CURVE
+    \param[in] count 顶点数
+    \param[in] points 顶点数组，元素个数为count
+    \param[in] tol 允许偏差，大于0
+    \param[out] indices 保留的顶点序号，按顺序排列，元素个数为count，由外界分配内存
+    \return 保留的顶点数，首末点总是保留
+*/
+GEOMAPI Int32 mgSimplifyLines(
+    Int32 count, const Point2d* points, float tol, Int32* indices);
+
 #endif // __GEOMETRY_FITCURVE_H_
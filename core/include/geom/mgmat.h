@@ -8,6 +8,8 @@
 
 #include "mgpnt.h"
 
+class Box2d;
+
 //! 二维齐次变换矩阵类
 /*!
     \ingroup GEOM_CLASS
@@ -86,6 +88,24 @@ public:
         \param[in,out] vectors 要变换的矢量的数组，元素个数为count
     */
     void TransformVectors(int count, Vector2d* vectors) const;
+
+    //! 对多个点进行矩阵变换，结果放到另一个数组，并计算变换后的包络框
+    /*! 支持SSE2或NEON指令时每次变换两个点，否则逐点变换
+        \param[in] count 点的个数
+        \param[in] points 要变换的点的数组，元素个数为count
+        \param[out] result 变换后的点的数组，元素个数为count，可以与points相同
+        \param[out] box 填充变换后的点的包络框，为NULL时不计算
+    */
+    void TransformPoints(int count, const Point2d* points,
+                         Point2d* result, Box2d* box = NULL) const;
+
+    //! 对多个矢量进行矩阵变换，结果放到另一个数组
+    /*! 对矢量进行矩阵变换时，矩阵的平移分量部分不起作用
+        \param[in] count 矢量的个数
+        \param[in] vectors 要变换的矢量的数组，元素个数为count
+        \param[out] result 变换后的矢量的数组，元素个数为count，可以与vectors相同
+    */
+    void TransformVectors(int count, const Vector2d* vectors, Vector2d* result) const;
     
     //! 行列式值
     float det() const;
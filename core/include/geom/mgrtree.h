@@ -0,0 +1,102 @@
+//! \file mgrtree.h
+//! \brief 定义二维空间索引类 MgRTree
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_RTREE_H_
+#define __GEOMETRY_RTREE_H_
+
+#include "mgbox.h"
+#include <vector>
+
+//! 二维空间索引类(R树)
+/*!
+    \ingroup GEOM_CLASS
+
+    本类按矩形框索引任意对象指针(void*)，用于快速查找与给定矩形框相交的对象。\n
+    采用二次分裂算法插入，删除后将不满的节点重新插入，批量构造采用STR排序打包。
+*/
+class MgRTree
+{
+public:
+    //! 查找结果的回调接口
+    struct Visitor
+    {
+        //! 找到一个与矩形框相交的对象
+        virtual void found(void* item) = 0;
+    };
+
+    MgRTree();
+    ~MgRTree();
+
+    //! 删除所有对象
+    void clear();
+
+    //! 返回对象个数
+    UInt32 getCount() const { return _count; }
+
+    //! 返回所有对象的包络框
+    Box2d getExtent() const;
+
+    //! 添加一个对象
+    /*!
+        \param item 对象指针，不能为NULL
+        \param box 对象的包络框，规范化的矩形框
+    */
+    void insert(void* item, const Box2d& box);
+
+    //! 移除一个对象
+    /*!
+        \param item 对象指针
+        \param box 对象插入时的包络框
+        \return 是否找到并移除了该对象
+    */
+    bool remove(void* item, const Box2d& box);
+
+    //! 批量构造索引，原有对象被清除
+    /*!
+        \param count 对象个数
+        \param items 对象指针数组，元素个数为count
+        \param boxes 对象包络框数组，元素个数为count
+    */
+    void load(UInt32 count, void* const* items, const Box2d* boxes);
+
+    //! 查找与给定矩形框相交的对象
+    /*!
+        \param box 规范化的矩形框
+        \param items 追加找到的对象指针，次序不定
+        \return 找到的对象个数
+    */
+    UInt32 search(const Box2d& box, std::vector<void*>& items) const;
+
+    //! 查找与给定矩形框相交的对象，逐个回调，不分配内存
+    /*!
+        \param box 规范化的矩形框
+        \param visitor 回调找到的对象，次序不定
+        \return 找到的对象个数
+    */
+    UInt32 search(const Box2d& box, Visitor& visitor) const;
+
+private:
+    struct Node;
+    struct Entry;
+
+    Node* insertAt(Node* node, const Entry& entry, int level);
+    Node* splitNode(Node* node);
+    bool removeAt(Node* node, void* item, const Box2d& box,
+        std::vector<Node*>& orphans);
+    void reinsert(Node* node);
+    void freeNode(Node* node, bool freeChildren);
+    void growRoot(Node* sibling);
+    void search(const Node* node, const Box2d& box, std::vector<void*>& items) const;
+    UInt32 search(const Node* node, const Box2d& box, Visitor& visitor) const;
+
+    MgRTree(const MgRTree&);
+    void operator=(const MgRTree&);
+
+private:
+    Node*   _root;
+    UInt32  _count;
+};
+
+#endif // __GEOMETRY_RTREE_H_
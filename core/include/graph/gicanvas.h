@@ -44,7 +44,7 @@ public:
 
 public:
     //! 用当前背景色清除背景
-    /*! 用背景色填充全部显示区域。打印或打印预览时调用无效。
+    /*! 用背景色填充剪裁框内的显示区域。打印或打印预览时调用无效。
         \see getBkColor
     */
     virtual void clearWindow() = 0;
@@ -95,6 +95,18 @@ public:
     */
     virtual bool isBufferedDrawing() const = 0;
 
+    //! 显示像素图像的原语函数，像素坐标，不剪裁
+    /*! 图像将以透明度叠加显示到画布上。
+        \param pixels 像素数据，每个像素为预乘透明度的R、G、B、A四个字节，按行自上而下存放
+        \param width 图像宽度，像素
+        \param height 图像高度，像素
+        \param x 图像左上角的显示坐标X
+        \param y 图像左上角的显示坐标Y
+        \return 是否显示成功，画布不支持时返回false
+    */
+    virtual bool rawImage(const UInt8* /*pixels*/, int /*width*/, int /*height*/,
+        float /*x*/, float /*y*/) { return false; }
+
     //! 返回画布类型
     virtual int getCanvasType() const = 0;
 
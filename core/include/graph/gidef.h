@@ -10,9 +10,11 @@
 #include <libkern/OSAtomic.h>
 inline long giInterlockedIncrement(volatile long *p) { return OSAtomicIncrement32((volatile int32_t *)p); }
 inline long giInterlockedDecrement(volatile long *p) { return OSAtomicDecrement32((volatile int32_t *)p); }
+inline void giMemoryBarrier() { OSMemoryBarrier(); }
 #elif !defined(_WIN32)
-inline long giInterlockedIncrement(volatile long *p) { return ++*p; }
-inline long giInterlockedDecrement(volatile long *p) { return --*p; }
+inline long giInterlockedIncrement(volatile long *p) { return __sync_add_and_fetch(p, 1); }
+inline long giInterlockedDecrement(volatile long *p) { return __sync_sub_and_fetch(p, 1); }
+inline void giMemoryBarrier() { __sync_synchronize(); }
 #else
 #ifndef _WINDOWS_
 #define WIN32_LEAN_AND_MEAN
@@ -20,6 +22,7 @@ inline long giInterlockedDecrement(volatile long *p) { return --*p; }
 #endif
 inline long giInterlockedIncrement(volatile long *p) { return InterlockedIncrement(p); }
 inline long giInterlockedDecrement(volatile long *p) { return InterlockedDecrement(p); }
+inline void giMemoryBarrier() { MemoryBarrier(); }
 #endif
 
 //! 矢量路径节点类型
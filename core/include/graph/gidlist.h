@@ -0,0 +1,120 @@
+//! \file gidlist.h
+//! \brief 定义显示列表类 GiDisplayList
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_DISPLAYLIST_H_
+#define __GEOMETRY_DISPLAYLIST_H_
+
+#include "gigraph.h"
+
+class MgRTree;
+
+//! 显示列表类
+/*! 本类记录 GiGraphics 绘图函数的调用，图元坐标保持为原来的模型坐标或世界坐标，
+    图形属性为调用时的 GiContext，不依赖于显示比例和显示位置。\n
+    用 GiGraphics::beginRecord() 开始记录，记录时按项(例如每个图形为一项)分组，
+    每项有包络框。重放时按当前的坐标系重新转换和剪裁，只显示与剪裁框相交的项，
+    因此平移和放缩显示时不必再调用各个图形的显示函数。
+    \ingroup GRAPH_INTERFACE
+    \see GiGraphics::beginRecord
+*/
+class GiDisplayList
+{
+public:
+    //! 图元类型，对应于 GiGraphics 的各个绘图函数
+    enum kPrimType {
+        kLine, kLines, kBeziers, kArc, kPolygon, kEllipse, kPie, kRoundRect,
+        kSplines, kClosedSplines, kBSplines, kClosedBSplines, kPath
+    };
+
+    GiDisplayList();
+    ~GiDisplayList();
+
+    //! 清除所有记录
+    void clear();
+
+    //! 开始记录一项，例如一个图形
+    /*! 在 endItem() 之前记录的图元都属于该项。
+        不在 beginItem() 和 endItem() 之间记录的图元属于无包络框的项，重放时总是显示。
+        \param box 该项的模型坐标包络框，重放时与剪裁框比较
+    */
+    void beginItem(const Box2d& box);
+
+    //! 结束记录一项，返回该项是否有图元，没有图元的项不保留
+    bool endItem();
+
+    //! 返回项数
+    UInt32 getItemCount() const;
+
+    //! 返回图元个数
+    UInt32 getPrimitiveCount() const;
+
+    //! 返回记录内容所占的字节数
+    UInt32 getMemorySize() const;
+
+    //! 重放显示，返回显示了图元的项数
+    /*! 只显示包络框与当前剪裁框相交的项，按记录的次序显示。
+        须在显示适配类的 beginPaint() 和 endPaint() 之间调用。
+    */
+    int draw(GiGraphics& gs) const;
+
+    //! 记录一个图元，由 GiGraphics 在记录时调用
+    /*!
+        \param type 图元类型, kPrimType
+        \param ctx 绘图参数，为NULL时重放时取为上一个绘图参数
+        \param modelUnit 坐标是模型坐标(true)还是世界坐标(false)
+        \param count 点数
+        \param pts 端点、控制点或型值点，弧线的半径和角度等参数也作为点存放
+        \param vecs 样条曲线的切矢量，元素个数为count
+        \param types 路径的节点类型，元素个数为count
+        \return 是否记录成功
+    */
+    bool addPrimitive(int type, const GiContext* ctx, bool modelUnit,
+        int count, const Point2d* pts,
+        const Vector2d* vecs = NULL, const UInt8* types = NULL);
+
+    //! 设置以后记录的模型坐标图元的附加变换，由 GiGraphics 在记录时调用
+    /*! 用于记录时临时改变了模型坐标系的情况(例如 GiSaveModelTransform)，
+        重放时在当前的模型坐标系基础上施加该变换。
+        \param mat 相对于开始记录时的模型坐标系的附加变换矩阵
+    */
+    void setModelTransform(const Matrix2d& mat);
+
+private:
+    struct Item {
+        Box2d   box;        // 模型坐标包络框，为空表示总是显示
+        UInt32  first;      // 第一个图元的序号
+        UInt32  count;      // 图元个数
+    };
+    struct Prim {
+        UInt8   type;       // 图元类型, kPrimType
+        UInt8   modelUnit;  // 是否为模型坐标
+        Int32   ctx;        // 绘图参数的序号，-1表示NULL
+        Int32   mat;        // 附加变换矩阵的序号，-1表示没有
+        UInt32  first;      // 第一个点在 _points 中的序号
+        UInt32  count;      // 点数
+        UInt32  extra;      // 切矢量或节点类型的起始序号
+    };
+
+    bool drawItem(GiGraphics& gs, const Item& item) const;
+    bool drawPrim(GiGraphics& gs, const Prim& prim) const;
+    void buildIndex() const;
+
+    std::vector<Item>       _items;
+    std::vector<Prim>       _prims;
+    std::vector<Point2d>    _points;
+    std::vector<Vector2d>   _vecs;
+    std::vector<UInt8>      _types;
+    std::vector<GiContext>  _contexts;
+    std::vector<Matrix2d>   _matrices;
+    Int32                   _mat;       // 当前附加变换矩阵的序号
+    bool                    _itemOpen;  // 是否在 beginItem() 之后
+    mutable MgRTree*        _tree;      // 各项的空间索引，重放时才构造
+    mutable std::vector<void*> _unbounded;  // 无包络框的项，与空间索引一起构造
+
+    GiDisplayList(const GiDisplayList&);
+    void operator=(const GiDisplayList&);
+};
+
+#endif // __GEOMETRY_DISPLAYLIST_H_
@@ -7,9 +7,29 @@
 #define __GEOMETRY_GRAPHSYS_H_
 
 #include "gicanvdr.h"
+#include <vector>
 
 class GiGraphicsImpl;
+class GiScratchArena;
 class GiCanvas;
+class GiDisplayList;
+
+//! 图元批量提交的统计
+/*! \ingroup GRAPH_INTERFACE
+    \see GiGraphics::setBatchMode
+*/
+struct GiBatchStats
+{
+    long    primitives;     //!< 图元个数
+    long    calls;          //!< 提交给画布的绘图调用次数
+    long    stateChanges;   //!< 相邻图元的绘图参数不同的次数，即画布需要更新画笔画刷的次数
+    long    savedStates;    //!< 绘图参数与上一个图元相同而不需更新画笔画刷的次数
+
+    GiBatchStats() : primitives(0), calls(0), stateChanges(0), savedStates(0) {}
+
+    //! 返回节省的绘图调用次数
+    long savedCalls() const { return primitives - calls; }
+};
 
 //! 图形系统类
 /*! 本类用于显示各种图形，图元显示原语由外部的 GiCanvas 实现类来实现。
@@ -41,6 +61,22 @@ public:
     //! 返回当前绘图画布对象
     GiCanvas* getCanvas();
 
+    //! 开始记录绘图到显示列表
+    /*! 在 endRecord() 之前调用的各个绘图函数只记录到显示列表中，不显示，
+        可以不在 beginPaint() 和 endPaint() 之间调用。
+        以后用 GiDisplayList::draw() 按当前显示比例和位置重放。
+        有的图形按记录时的显示比例简化顶点，放大显示后应重新记录。
+        \param list 显示列表对象，记录的图元追加到原有内容之后
+        \return 是否开始记录，已在记录中时失败
+    */
+    bool beginRecord(GiDisplayList* list);
+
+    //! 结束记录绘图
+    void endRecord();
+
+    //! 返回是否正在记录绘图到显示列表
+    bool isRecording() const;
+
 public:
     //! 返回剪裁框，模型坐标
     Box2d getClipModel() const;
@@ -75,6 +111,27 @@ public:
         \return 是否成功设置剪裁框，没有处于绘图状态中或计算出的剪裁框为空时失败
     */
     bool setClipWorld(const Box2d& rectWorld);
+
+    //! 添加待重新显示的区域，世界坐标
+    /*! 图形改变后，将其改变前后的显示范围添加为待重新显示的区域，多次添加的区域将合并。
+        下次显示时可调用 beginDirtyDraw() 在后备缓冲位图上只重新显示这些区域。\n
+        放缩显示或清除后备缓冲位图后，待重新显示的区域将清空。
+        \param rectWorld 世界坐标矩形，已包含线宽
+    */
+    void addDirtyWorld(const Box2d& rectWorld);
+
+    //! 返回待重新显示的区域，世界坐标，为空表示没有
+    Box2d getDirtyWorld() const;
+
+    //! 准备在后备缓冲位图上重新显示待重新显示的区域
+    /*! 应在显示后备缓冲位图成功后调用。本函数将剪裁框设置为待重新显示的区域并清除其背景，
+        成功时应重新显示与剪裁框(getClipModel())相交的图形，然后调用 endDirtyDraw()。
+        \return 是否需要局部重新显示，没有待重新显示的区域或区域不在显示范围内时返回false
+    */
+    bool beginDirtyDraw();
+
+    //! 结束局部重新显示，恢复剪裁框并更新后备缓冲位图
+    void endDirtyDraw();
     
 
     //! 颜色模式定义
@@ -125,6 +182,26 @@ public:
 
     //! 设置是否为反走样模式
     bool setAntiAliasMode(bool antiAlias);
+
+    //! 返回是否批量提交图元
+    bool isBatchMode() const;
+
+    //! 设置是否批量提交图元，返回原来的设置
+    /*! 批量提交时，将绘图参数相同(线宽按像素宽度比较)、不透明且不填充的相邻直线、
+        折线、贝塞尔曲线和多边形合为一个路径提交给画布，减少画布的调用次数和画笔更新，
+        其余图元及剪裁框改变、结束绘图等操作前先提交已缓存的图元，因此显示次序不变。\n
+        适合每次调用开销较大的画布，例如经过JNI调用的画布。
+    */
+    bool setBatchMode(bool batch);
+
+    //! 提交已缓存的图元
+    void flushBatch();
+
+    //! 返回图元批量提交的统计
+    const GiBatchStats& getBatchStats() const;
+
+    //! 清除图元批量提交的统计
+    void resetBatchStats();
     
 public:
     //! 绘制直线段，模型坐标或世界坐标
@@ -330,6 +407,9 @@ public:
     //! 在显示适配类的 endPaint() 中调用
     void _endPaint();
 
+    //! 返回绘图用的临时缓冲区，供图形显示时用 GiScratch 按栈的方式分配暂存数据
+    GiScratchArena& _scratch();
+
 public:
     void clearCachedBitmap(bool clearAll = false);
     float getScreenDpi() const;
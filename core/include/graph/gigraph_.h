@@ -5,6 +5,128 @@
 
 #include "gigraph.h"
 #include "gicanvas.h"
+#include "gidlist.h"
+#include <vector>
+
+//! 绘图用的临时缓冲区
+/*! 按栈的方式从若干内存块中分配，由 GiScratch 在析构时归还。
+    内存块在绘图结束后保留，供以后的绘图重用，稳定后绘图时不再分配堆内存。
+*/
+class GiScratchArena
+{
+    struct Block {
+        char*   buf;
+        int     size;
+    };
+    std::vector<Block>  m_blocks;   //!< 已分配的内存块
+    int         m_block;            //!< 当前分配所在的块序号
+    int         m_used;             //!< 当前块中已分配的字节数
+
+public:
+    enum { kBlockSize = 0x20000 };  //!< 内存块的最小字节数
+
+    GiScratchArena() : m_block(0), m_used(0)
+    {
+    }
+
+    ~GiScratchArena()
+    {
+        for (size_t i = 0; i < m_blocks.size(); i++)
+            delete[] m_blocks[i].buf;
+    }
+
+    //! 分配指定字节数的内存，按16字节对齐
+    void* alloc(int bytes)
+    {
+        bytes = (bytes + 15) & ~15;
+        if (m_block < (int)m_blocks.size() && m_used + bytes > m_blocks[m_block].size)
+        {
+            m_block++;                  // 当前块的剩余空间不够，后面的块都未使用
+            m_used = 0;
+        }
+        if (m_block == (int)m_blocks.size())
+        {
+            Block block = { NULL, 0 };
+            m_blocks.push_back(block);
+        }
+
+        Block& block = m_blocks[m_block];
+        if (block.size < bytes)         // 未使用的块太小，换为更大的块
+        {
+            delete[] block.buf;
+            block.size = bytes > kBlockSize ? bytes : kBlockSize;
+            block.buf = new char[block.size];
+        }
+
+        void* p = block.buf + m_used;
+        m_used += bytes;
+        return p;
+    }
+
+    //! 记下当前的分配位置
+    void getMark(int& block, int& used) const
+    {
+        block = m_block;
+        used = m_used;
+    }
+
+    //! 归还到记下的分配位置，之后分配的内存都被归还
+    void release(int block, int used)
+    {
+        m_block = block;
+        m_used = used;
+    }
+
+    //! 归还全部内存，保留内存块
+    void reset()
+    {
+        m_block = 0;
+        m_used = 0;
+    }
+
+private:
+    GiScratchArena(const GiScratchArena&);
+    void operator=(const GiScratchArena&);
+};
+
+//! 从绘图临时缓冲区中分配数组的辅助类，析构时归还
+template <class T>
+class GiScratch
+{
+    GiScratchArena& m_arena;
+    int             m_block;
+    int             m_used;
+    T*              m_arr;
+
+public:
+    //! 构造函数，分配count个元素，元素未初始化
+    GiScratch(GiScratchArena& arena, int count) : m_arena(arena)
+    {
+        arena.getMark(m_block, m_used);
+        m_arr = static_cast<T*>(arena.alloc(count * static_cast<int>(sizeof(T))));
+    }
+
+    ~GiScratch()
+    {
+        m_arena.release(m_block, m_used);
+    }
+
+    //! 返回数组
+    T* get() const
+    {
+        return m_arr;
+    }
+
+    //! 返回元素
+    T& operator[](int index) const
+    {
+        return m_arr[index];
+    }
+
+private:
+    GiScratch(const GiScratch&);
+    void operator=(const GiScratch&);
+};
 
 //! GiGraphics的内部实现类
 class GiGraphicsImpl
@@ -32,8 +154,29 @@ public:
     Box2d       rectDrawW;          //!< 剪裁矩形，世界坐标
     Box2d       rectDrawMaxM;       //!< 最大剪裁矩形，模型坐标
     Box2d       rectDrawMaxW;       //!< 最大剪裁矩形，世界坐标
+    Box2d       rectDirtyW;         //!< 待重新显示的区域，世界坐标
+    RECT_2D     clipBoxDirty;       //!< 局部重新显示前的剪裁框(LP)
+    bool        dirtyDrawing;       //!< 是否正在局部重新显示
+
+    GiScratchArena  scratch;        //!< 绘图用的临时缓冲区
+    std::vector<Point2d> clipBuf1;  //!< 多边形剪裁的交点缓冲
+    std::vector<Point2d> clipBuf2;  //!< 多边形剪裁的交点缓冲
+    GiDisplayList*  recorder;       //!< 正在记录绘图的显示列表
+
+    bool        batchMode;          //!< 是否批量提交图元
+    int         batchType;          //!< 缓存的第一个图元的类型
+    int         batchCount;         //!< 缓存的图元个数
+    GiContext   batchCtx;           //!< 缓存图元的绘图参数，不填充
+    float       batchPenWidth;      //!< 缓存图元的像素线宽
+    std::vector<Point2d> batchPts;  //!< 缓存图元的点
+    std::vector<UInt8> batchTypes;  //!< 缓存图元的节点类型
+    GiContext   lastCtx;            //!< 上一个图元的绘图参数
+    float       lastPenWidth;       //!< 上一个图元的像素线宽
+    bool        hasLastCtx;         //!< 是否有上一个图元
+    GiBatchStats batchStats;        //!< 批量提交的统计
+    Matrix2d    recordW2M;          //!< 开始记录时的世界坐标到模型坐标的变换
 
-    GiGraphicsImpl(GiTransform* x) : xform(x), canvas(NULL)
+    GiGraphicsImpl(GiTransform* x) : xform(x), canvas(NULL), recorder(NULL)
     {
         drawRefcnt = 0;
         drawColors = 0;
@@ -42,6 +185,13 @@ public:
         maxPenWidth = 100;
         minPenWidth = 1;
         antiAlias = true;
+        dirtyDrawing = false;
+        batchMode = false;
+        batchType = 0;
+        batchCount = 0;
+        batchPenWidth = 0;
+        lastPenWidth = 0;
+        hasLastCtx = false;
     }
 
     ~GiGraphicsImpl()
@@ -55,6 +205,7 @@ public:
         rectDrawMaxM = rect * xform->displayToModel();
         rectDrawW = rectDrawM * xform->modelToWorld();
         rectDrawMaxW = rectDrawMaxM * xform->modelToWorld();
+        rectDirtyW.empty();
         if (canvas)
             canvas->clearCachedBitmap(true);
     }
@@ -0,0 +1,108 @@
+//! \file giraster.h
+//! \brief 定义软件光栅化画布类 GiCanvasRaster
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_CANVAS_RASTER_H_
+#define __GEOMETRY_CANVAS_RASTER_H_
+
+#include "gicanvas.h"
+
+class GiCanvasRasterImpl;
+
+//! 软件光栅化画布类
+/*! 本类将图元光栅化到内存中的像素缓冲，不依赖平台绘图库，
+    可用于生成瓦片位图、后台绘图和性能测试。\n
+    像素缓冲的大小为坐标系的显示窗口大小，每个像素为预乘透明度的R、G、B、A四个字节，
+    按行自上而下存放。填充采用非零环绕规则，线条按线宽展开为多边形后填充。\n
+    反走样模式(GiGraphics::setAntiAliasMode)下每个像素行取4条子扫描线，按覆盖率混合颜色。\n
+    支持后备缓冲位图，可保存为PNG或PPM文件，可用于服务端生成缩略图。
+    \ingroup GRAPH_INTERFACE
+*/
+class GiCanvasRaster : public GiCanvas
+{
+public:
+    //! 构造函数，图形系统对象必须有效
+    /*!
+        \param gs 图形系统对象
+        \param dpi 显示分辨率，为0时取屏幕分辨率
+    */
+    GiCanvasRaster(GiGraphics* gs, float dpi = 0);
+
+    //! 析构函数
+    virtual ~GiCanvasRaster();
+
+    //! 设置屏幕分辨率，默认为96
+    static void setScreenDpi(float dpi);
+
+    //! 准备开始绘图
+    /*! 按坐标系的显示窗口大小准备像素缓冲并清除其内容。
+        如果调用成功，则在绘图完成或停止时，必须调用 endPaint()。
+        \param transparent 是否清除为透明色，否则用背景色清除
+        \return 是否初始化成功，失败原因为先前绘图还未结束
+    */
+    bool beginPaint(bool transparent = false);
+
+    //! 结束绘图
+    void endPaint();
+
+    //! 返回像素缓冲，在下次 beginPaint() 前有效
+    const UInt8* getPixels() const;
+
+    //! 返回像素缓冲的宽度，像素
+    int getWidth() const;
+
+    //! 返回像素缓冲的高度，像素
+    int getHeight() const;
+
+    //! 返回自 beginPaint() 以来是否绘制过像素
+    bool isPainted() const;
+
+    //! 保存像素缓冲到PNG文件，RGBA格式，数据不压缩
+    bool savePNG(const char* filename) const;
+
+    //! 保存像素缓冲到PPM文件，RGB格式，透明部分按背景色合成
+    bool savePPM(const char* filename) const;
+
+public:
+    virtual void clearWindow();
+    virtual bool drawCachedBitmap(float x = 0, float y = 0, bool secondBmp = false);
+    virtual bool drawCachedBitmap2(const GiCanvas* p,
+        float x = 0, float y = 0, bool secondBmp = false);
+    virtual void saveCachedBitmap(bool secondBmp = false);
+    virtual bool hasCachedBitmap(bool secondBmp = false) const;
+    virtual bool isBufferedDrawing() const;
+    virtual int getCanvasType() const { return 20; }
+    virtual const GiContext* getCurrentContext() const;
+    virtual void _clipBoxChanged(const RECT_2D& clipBox);
+    virtual void _antiAliasModeChanged(bool antiAlias);
+    virtual bool rawImage(const UInt8* pixels, int width, int height, float x, float y);
+
+    virtual void clearCachedBitmap(bool clearAll = false);
+    virtual float getScreenDpi() const;
+    virtual GiColor getBkColor() const;
+    virtual GiColor setBkColor(const GiColor& color);
+    virtual bool rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2);
+    virtual bool rawLines(const GiContext* ctx, const Point2d* pxs, int count);
+    virtual bool rawBeziers(const GiContext* ctx, const Point2d* pxs, int count);
+    virtual bool rawPolygon(const GiContext* ctx, const Point2d* pxs, int count);
+    virtual bool rawRect(const GiContext* ctx, float x, float y, float w, float h);
+    virtual bool rawEllipse(const GiContext* ctx, float x, float y, float w, float h);
+    virtual bool rawPath(const GiContext* ctx,
+        int count, const Point2d* pxs, const UInt8* types);
+    virtual bool rawBeginPath();
+    virtual bool rawEndPath(const GiContext* ctx, bool fill);
+    virtual bool rawMoveTo(float x, float y);
+    virtual bool rawLineTo(float x, float y);
+    virtual bool rawBezierTo(const Point2d* pxs, int count);
+    virtual bool rawClosePath();
+
+private:
+    GiCanvasRaster();
+    GiCanvasRaster(const GiCanvasRaster&);
+    void operator=(const GiCanvasRaster&);
+
+    GiCanvasRasterImpl*   m_draw;
+};
+
+#endif // __GEOMETRY_CANVAS_RASTER_H_
@@ -0,0 +1,99 @@
+//! \file gitiles.h
+//! \brief 定义静态图形的瓦片位图缓存类 GiTileCache
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_TILE_CACHE_H_
+#define __GEOMETRY_TILE_CACHE_H_
+
+#include "gigraph.h"
+
+class GiTileCacheImpl;
+
+//! 瓦片的绘图回调接口
+/*! \ingroup GRAPH_INTERFACE
+    \interface GiTilePainter
+    \see GiTileCache
+*/
+struct GiTilePainter
+{
+    //! 显示的图形类别
+    enum {
+        kPaintAll,          //!< 全部图形，画布不支持显示位图时直接显示
+        kPaintTiled,        //!< 可分块生成瓦片的图形
+        kPaintOverlay       //!< 不能分块的图形，例如虚线在瓦片边界处会重新开始线型，贴瓦片后直接显示
+    };
+
+    virtual ~GiTilePainter() {}
+
+    //! 在给定图形系统上显示静态图形，返回显示的图形个数
+    /*! 生成瓦片时图形系统的剪裁框为一个瓦片的范围，可按 GiGraphics::getClipModel() 剪裁。
+        \param gs 图形系统
+        \param pass 显示的图形类别，为 kPaintAll 等值
+    */
+    virtual int paint(GiGraphics& gs, int pass) = 0;
+};
+
+//! 静态图形的瓦片位图缓存类
+/*! 将世界坐标平面按显示比例划分为固定像素大小的瓦片，
+    每个瓦片由软件光栅化画布(GiCanvasRaster)生成位图后缓存，按显示比例和瓦片坐标索引。\n
+    平移显示或缩放后又回到原来的显示比例时，直接使用已缓存的瓦片，
+    只有新露出的瓦片才需要重新绘制图形。缓存按最近最少使用的次序淘汰，总字节数不超过限定值。\n
+    瓦片按整像素贴到画布上，平移量的像素小数部分(相位)不同时另作一级生成瓦片，
+    以便与直接显示的像素位置一致。虚线等不能分块的图形不生成瓦片，在贴瓦片后直接显示。\n
+    图形改变后应调用 invalidate() 使其所在的瓦片失效。\n
+    显示时画布需支持 GiCanvas::rawImage()，否则直接在画布上绘图。
+    \ingroup GRAPH_INTERFACE
+    \see GiTilePainter, GiCanvasRaster
+*/
+class GiTileCache
+{
+public:
+    //! 构造函数
+    /*!
+        \param tileSize 瓦片的宽高，像素
+        \param maxBytes 瓦片位图占用的最大字节数
+    */
+    GiTileCache(int tileSize = 256, long maxBytes = 32*1024*1024);
+
+    //! 析构函数
+    ~GiTileCache();
+
+    //! 返回瓦片的宽高，像素
+    int getTileSize() const;
+
+    //! 设置瓦片位图占用的最大字节数
+    void setMemoryLimit(long maxBytes);
+
+    //! 返回瓦片位图占用的字节数
+    long getMemoryUsed() const;
+
+    //! 返回缓存的瓦片个数，包括没有图形的空瓦片
+    int getTileCount() const;
+
+    //! 清除所有瓦片
+    void clear();
+
+    //! 使与给定模型坐标矩形框相交的瓦片失效
+    /*! 矩形框将按各显示比例放大几个像素，以包含线宽。
+        \param rectModel 改变的图形的包络框(改变前后的包络框的并集)，模型坐标
+    */
+    void invalidate(const Box2d& rectModel);
+
+    //! 在图形系统的当前剪裁框内显示瓦片，没有缓存的瓦片将调用 painter 生成
+    /*! 只能在图形系统的绘图状态(GiGraphics::isDrawing())中调用。
+        \param gs 图形系统，其画布用于显示瓦片位图
+        \param painter 绘图回调对象，用于生成瓦片
+        \param[out] rendered 填充本次生成的瓦片个数，可为NULL
+        \return 是否使用了瓦片显示，为false时画布不支持显示位图，已直接在画布上绘图
+    */
+    bool draw(GiGraphics& gs, GiTilePainter* painter, int* rendered = NULL);
+
+private:
+    GiTileCache(const GiTileCache&);
+    void operator=(const GiTileCache&);
+
+    GiTileCacheImpl*    m_impl;
+};
+
+#endif // __GEOMETRY_TILE_CACHE_H_
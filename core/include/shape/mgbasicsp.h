@@ -171,6 +171,8 @@ protected:
     float      _ry;
 };
 
+struct MgLinesLod;
+
 //! 折线基类
 /*! \ingroup GEOM_SHAPE
 */
@@ -199,6 +201,13 @@ public:
     //! 删除一个顶点
     bool removePoint(UInt32 index);
 
+    //! 曲线段查找的回调接口
+    /*! \see _findSegments */
+    struct SegmentVisitor {
+        //! 找到一个包络框与矩形框相交的曲线段
+        virtual void visit(UInt32 segment) = 0;
+    };
+
 protected:
     MgBaseLines();
     virtual ~MgBaseLines();
@@ -218,11 +227,61 @@ protected:
     bool _save(MgStorage* s) const;
     bool _load(MgStorage* s);
 
+    //! 返回适合当前显示比例的简化顶点，没有合适的简化级别时返回原顶点
+    /*! 按图形大小分几级容差简化顶点(mgSimplifyLines)，选用偏差不超过半个像素的最简级别。
+        对于样条曲线简化的是型值点，容差只限定去掉的型值点到保留的型值点连线的距离，
+        由保留的型值点重新计算的曲线与原曲线的偏差可能超过容差。\n
+        记录显示列表时也按当前显示比例简化，放缩后由 MgDisplayCache 重新记录。\n
+        各级简化顶点在首次用到时计算并缓存，可在多个线程中同时显示；
+        update() 或 transform() 后清除，此时不能有其他线程在显示本图形。
+        \param gs 图形系统，用于取显示比例
+        \param[out] pts 填充顶点数组
+        \param[out] knotvs 不为NULL时填充简化顶点的样条曲线切矢量，返回原顶点时为NULL
+        \return 顶点数
+    */
+    UInt32 _getLodPoints(const GiGraphics& gs, const Point2d*& pts,
+                         const Vector2d** knotvs = NULL) const;
+    
+    //! 逐个回调包络框与给定矩形框相交的曲线段，次序不定，不分配内存
+    /*! 段数较多时首次调用构造各段包络框的空间索引(MgRTree)并缓存，update() 或 transform() 后清除。
+        \param rect 规范化的矩形框
+        \param visitor 回调找到的曲线段序号
+        \param knotvs 不为NULL时为样条曲线的切矢量，各段包络框取为Bezier控制点的包络框
+        \return 是否使用了空间索引，为false时段数较少，应逐段检查
+    */
+    bool _findSegments(const Box2d& rect, SegmentVisitor& visitor,
+                       const Vector2d* knotvs = NULL) const;
+    
+    //! 图形部分可见时查找可见的曲线段，用于只显示这些部分
+    /*! 只用于不闭合的图形，需要有曲线段空间索引(_findSegments)。
+        \param gs 图形系统，用于取剪裁框
+        \param[out] segs 填充可见曲线段的序号，从小到大排列，元素个数至少为顶点数，
+            可从 GiGraphics::_scratch() 分配
+        \param knotvs 不为NULL时为样条曲线的切矢量
+        \return 可见的段数，为-1时应整体显示
+        \see _nextRun
+    */
+    Int32 _findVisibleSegments(const GiGraphics& gs, UInt32* segs,
+                               const Vector2d* knotvs = NULL) const;
+    
+    //! 从排好序的曲线段序号中取出下一段连续部分
+    /*!
+        \param segs 曲线段的序号，从小到大排列
+        \param count 段数
+        \param[in,out] index 从segs的此位置开始找，返回时为下一段连续部分的位置
+        \param[out] start 连续部分的起始顶点序号
+        \return 连续部分的顶点数，没有更多时为0
+    */
+    static UInt32 _nextRun(const UInt32* segs, Int32 count, Int32& index, UInt32& start);
+    MgLinesLod* _getLod() const;
+    void _clearLod();
+
 protected:
     Point2d*    _points;
     UInt32      _maxCount;
     UInt32      _count;
     bool        _closed;
+    MgLinesLod* volatile _lod;
 };
 
 //! 折线图形类
@@ -242,16 +301,35 @@ class MgSplines : public MgBaseLines
     MG_INHERIT_CREATE(MgSplines, MgBaseLines, 16)
 public:
     //! 去掉多余点，同时仍然光滑
-    void smooth(float tol);
+    /*! 去掉点后原来各点到新曲线的距离都小于tol，且保留点的切线方向变化不超过45度。
+        \param tol 距离公差，模型坐标
+        \param window 为0时每次去点都重新计算整条曲线，耗时为O(n^2)；
+            大于0时只在候选点前后各 window 个点的局部范围内重新拟合，
+            最后对整条曲线校验距离，补回超差的点后再校验，最多校验4次，仍有超差的点时不去点，
+            因此耗时为O(n*window)。保留的点与为0时不一定相同，个数相近。一般取4~8即可
+    */
+    void smooth(float tol, UInt32 window = 0);
+    
+    //! 设置是否为只在末尾添加点的增量计算方式
+    /*! 交互绘制曲线时，在增量计算方式下 update() 只重新计算末尾几个型值点的切矢量和包络框，
+        耗时与点数无关。此时只能改变末尾几个点或添加点，删除点时会整体重新计算。\n
+        取消增量计算方式时将整体重新计算切矢量。
+    */
+    void setIncremental(bool incremental);
     
 protected:
     void _update();
     float _hitTest(const Point2d& pt, float tol, Point2d& nearpt, Int32& segment) const;
     bool _hitTestBox(const Box2d& rect) const;
+    bool _updateTail();
 
 protected:
     Vector2d*   _knotvs;
     UInt32      _bzcount;
+    bool        _incremental;   //!< 是否为增量计算方式
+    UInt32      _solved;        //!< 增量计算方式下已计算切矢量的点数
+    UInt32      _frozen;        //!< 增量计算方式下切矢量不再改变的点数
+    Box2d       _frozenBox;     //!< 切矢量不再改变的曲线段的包络框
 };
 
 #endif // __GEOMETRY_BASICSHAPE_H_
@@ -11,6 +11,11 @@
 
 struct MgSelection;
 
+//! 返回图形的显示范围，即包络框加上线宽和反走样边缘，模型坐标
+/*! \ingroup GEOM_SHAPE
+*/
+Box2d mgShapeDisplayBox(const MgShape* shape, GiGraphics* gs);
+
 //! 图形视图接口
 /*! \ingroup GEOM_SHAPE
     \interface MgView
@@ -21,6 +26,8 @@ struct MgView {
     virtual GiGraphics* graph() = 0;            //!< 得到图形显示对象
     virtual void regen() = 0;                   //!< 标记视图待重新构建显示
     virtual void redraw(bool fast) = 0;         //!< 标记视图待更新显示
+    virtual void regenRect(const Box2d& rectM) {        //!< 标记视图的局部区域待重新构建显示，模型坐标
+        if (!rectM.isNull()) regen(); }
     
     virtual GiContext* context() {              //!< 得到当前绘图属性
         return shapes()->context(); }
@@ -29,7 +36,7 @@ struct MgView {
     virtual bool shapeWillAdded(MgShape* shape) {       //!< 通知将添加图形
         return !!shape; }
     virtual void shapeAdded(MgShape* shape) {           //!< 通知已添加图形，由视图重新构建显示
-        if (shape) regen(); }
+        if (shape) regenRect(mgShapeDisplayBox(shape, graph())); }
     virtual bool shapeWillDeleted(MgShape* shape) {     //!< 通知将删除图形
         return !!shape; }
     virtual bool shapeCanRotated(MgShape* shape) {      //!< 通知是否能旋转图形
@@ -134,17 +141,31 @@ struct MgCommandManager {
     
     //! 返回选择集对象
     virtual MgSelection* getSelection(MgView* view) = 0;
+    
+    //! 返回本命令管理器的动态图形锁，用于 MgDynShapeLock
+    virtual MgLockRW* getDynamicShapeLock() = 0;
+    
+    //! 销毁由 mgCreateCommandManager() 创建的对象，对 mgGetCommandManager() 无效
+    virtual void release() = 0;
 };
 
-//! 返回命令管理器
+//! 返回默认的命令管理器
 /*! \ingroup GEOM_SHAPE
 */
 MgCommandManager* mgGetCommandManager();
 
+//! 创建一个命令管理器，由调用者 release()
+/*! 每个视图或会话可使用自己的命令管理器，其当前命令、注册的命令和动态图形锁
+    与其他命令管理器无关，因此多个文档可在各自的线程中同时编辑和显示。
+    \ingroup GEOM_SHAPE
+*/
+MgCommandManager* mgCreateCommandManager();
+
 //! 注册图形实体类型
 /*! \ingroup GEOM_SHAPE
     \param type MgBaseShape 派生图形类的 Type()，或 MgShapeT(图形类)的 Type()
     \param factory 图形类的创建函数，例如 MgShapeT(图形类)的 create, 为NULL则取消注册
+    \note 可在多线程中调用，注册时不影响其他线程中 mgCreateShape() 创建图形
 */
 void mgRegisterShapeCreator(UInt32 type, MgShape* (*factory)());
 
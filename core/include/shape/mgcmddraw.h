@@ -16,6 +16,27 @@ float mgLineHalfWidthModel(const MgShape* shape, const MgMotion* sender);
 float mgDisplayMmToModel(float mm, GiGraphics* gs);
 float mgDisplayMmToModel(float mm, const MgMotion* sender);
 
+//! 徒手绘制折线时在线去点的参数和统计
+/*! 采样点到简化后折线的偏差不超过容差，移动越快容差越大。
+    \see mgGetStrokeFilter
+*/
+struct MgStrokeFilter {
+    float   tol;            //!< 偏差容差，屏幕毫米，为0时保留所有采样点
+    float   maxTol;         //!< 快速移动时放大后的最大容差，屏幕毫米
+    float   fastVelocity;   //!< 移动速度达到此值时容差放大到 maxTol，像素每秒，为0时不按速度放大
+    long    kept;           //!< 累计保留的采样点数
+    long    dropped;        //!< 累计去掉的采样点数
+    
+    MgStrokeFilter() : tol(0.2f), maxTol(0.6f), fastVelocity(1000), kept(0), dropped(0) {}
+};
+
+//! 返回折线绘图命令的在线去点参数和统计，可修改参数或清零统计
+/*! 每个命令管理器有自己的折线绘图命令对象，其参数和统计互不影响。
+    \param cmd 命令对象，例如启动折线命令后的 MgCommandManager::getCommand()
+    \return 去点参数和统计，不是内置的折线绘图命令时返回NULL
+*/
+MgStrokeFilter* mgGetStrokeFilter(MgCommand* cmd);
+
 //! 绘图命令基类
 /*! example: mgGetCommandManager()->registerCommand(YourCmd::Name(), YourCmd::Create);
     \ingroup GEOM_SHAPE
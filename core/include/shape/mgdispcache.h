@@ -0,0 +1,93 @@
+//! \file mgdispcache.h
+//! \brief 定义图形列表的显示缓存类 MgDisplayCache
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGDISPLAYCACHE_H_
+#define __GEOMETRY_MGDISPLAYCACHE_H_
+
+#include <mgshapes.h>
+#include <gidlist.h>
+#include <gitiles.h>
+
+//! 图形列表的显示缓存类
+/*! \ingroup GEOM_SHAPE
+    将图形列表的各个图形记录到显示列表中，每个图形为一项。
+    平移显示时直接重放显示列表，不再调用各个图形的显示函数；
+    图形列表改变(getChangeCount()或图形个数变化)后自动重新记录。\n
+    点数多的折线和曲线按记录时的显示比例简化，因此放大显示后、或缩小到四分之一以下时也重新记录，
+    以免简化后的偏差超过半个像素，或缩小后仍输出过多的点。\n
+    如果图形改变后未调用 MgShapes::afterChanged()，需调用 invalidate()。
+*/
+class MgDisplayCache
+{
+public:
+    MgDisplayCache();
+    ~MgDisplayCache();
+
+    //! 显示图形列表，返回显示的图形个数
+    /*! 须在显示适配类的 beginPaint() 和 endPaint() 之间调用。
+        \param shapes 图形列表，与上次不同或有改变时重新记录
+        \param gs 图形系统
+    */
+    int draw(MgShapes* shapes, GiGraphics& gs);
+
+    //! 标记需要重新记录
+    void invalidate();
+
+    //! 返回显示列表
+    const GiDisplayList& getDisplayList() const { return _list; }
+
+private:
+    void record(MgShapes* shapes, GiGraphics& gs);
+
+    GiDisplayList   _list;
+    MgShapes*       _shapes;        // 记录的图形列表
+    UInt32          _changeCount;   // 记录时的改变次数
+    UInt32          _shapeCount;    // 记录时的图形个数
+    float           _pixel;         // 记录时一个像素对应的模型长度
+    bool            _valid;
+};
+
+//! 图形列表的瓦片显示缓存类
+/*! \ingroup GEOM_SHAPE
+    用 GiTileCache 缓存图形列表的瓦片位图，平移显示或回到已缓存的显示比例时直接贴瓦片，
+    只有新露出的瓦片才显示图形。虚线等不能分块显示的图形不生成瓦片，贴瓦片后再直接显示，
+    因此这些图形总显示在其他图形之上。\n
+    图形改变后应调用 invalidate() 使其所在的瓦片失效；图形列表已改变(getChangeCount())
+    但上次显示后没有调用 invalidate() 时，清除所有瓦片。
+*/
+class MgTileLayer : private GiTilePainter
+{
+public:
+    //! 构造函数，参数同 GiTileCache
+    MgTileLayer(int tileSize = 256, long maxBytes = 32*1024*1024);
+    ~MgTileLayer();
+
+    //! 用瓦片显示图形列表，返回是否用了瓦片，为false时已直接显示
+    /*! 须在显示适配类的 beginPaint() 和 endPaint() 之间调用。
+        \param shapes 图形列表，与上次不同时清除所有瓦片
+        \param gs 图形系统，其画布需支持 GiCanvas::rawImage()
+        \param[out] rendered 填充本次生成的瓦片个数，可为NULL
+    */
+    bool draw(MgShapes* shapes, GiGraphics& gs, int* rendered = NULL);
+
+    //! 使与给定模型坐标矩形框相交的瓦片失效
+    void invalidate(const Box2d& rectM);
+
+    //! 清除所有瓦片
+    void clear();
+
+    //! 返回瓦片缓存
+    GiTileCache& tiles() { return _tiles; }
+
+private:
+    virtual int paint(GiGraphics& gs, int pass);
+
+    GiTileCache     _tiles;
+    MgShapes*       _shapes;        // 正在显示的图形列表
+    UInt32          _changeCount;   // 上次显示时的改变次数
+    bool            _invalidated;   // 上次显示后是否调用过 invalidate()
+};
+
+#endif // __GEOMETRY_MGDISPLAYCACHE_H_
@@ -0,0 +1,108 @@
+//! \file mgregion.h
+//! \brief 定义区域查找条件 MgRegionQuery 和增量区域选择类 MgRegionSelection
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGREGION_H_
+#define __GEOMETRY_MGREGION_H_
+
+#include <mgshapes.h>
+#include <vector>
+
+//! 区域查找条件，区域为矩形框或套索多边形
+/*! \ingroup GEOM_SHAPE
+    \see MgShapes::queryRegion
+*/
+struct MgRegionQuery
+{
+    Box2d           box;        //!< 模型坐标的选择框，有套索时为套索的包络框
+    bool            contains;   //!< 图形是否须完全在区域内，为false时与区域相交即可
+    Int32           count;      //!< 套索多边形的顶点数，小于3时只用选择框
+    const Point2d*  lasso;      //!< 套索多边形的顶点，由调用者保持有效
+
+    //! 给定矩形框构造
+    MgRegionQuery(const Box2d& rect, bool containsMode = false)
+        : box(rect), contains(containsMode), count(0), lasso(NULL) {}
+
+    //! 给定套索多边形构造
+    MgRegionQuery(Int32 n, const Point2d* pts, bool containsMode = false)
+        : box((int)n, pts), contains(containsMode), count(n), lasso(pts) {}
+
+    //! 返回是否为套索多边形区域
+    bool isLasso() const { return lasso && count > 2; }
+
+    //! 判断图形是否与区域相交或在区域内
+    /*! 矩形框区域时同框选命令：相交时用 MgBaseShape::hitTestBox()，
+        在区域内时判断包络框。套索区域按图形的控制点折线近似判断。
+    */
+    bool match(const MgBaseShape* shape) const;
+};
+
+//! 拖动选择框时的增量区域选择类
+/*! \ingroup GEOM_SHAPE
+    每次拖动时用 update() 传入新的区域。与上次都是矩形框、查找方式相同且图形列表未改变时，
+    只重新判断包络框与新旧矩形框之差(最多8个条带)相交的图形，其余图形的结果不会改变；
+    新框多出的条带只判断未选中的图形，旧框去掉的条带只判断已选中的图形。
+    套索区域或其他情况下重新查找全部图形；条带内的图形超过总数的四分之一时(例如多为贯穿全图的长直线)，
+    直到 reset() 都改为遍历全部图形，不用空间索引，但按显示次序缓存图形的包络框和选中状态，
+    仍只判断包络框与条带相交的图形，且新选中的相交图形只与新框多出的条带判断。
+    \see MgRegionQuery, MgShapes::queryExtent
+*/
+class MgRegionSelection
+{
+public:
+    MgRegionSelection();
+
+    //! 清除选择结果，下次 update() 时重新查找
+    void reset();
+
+    //! 按新的区域更新选择结果，返回选择结果是否改变
+    bool update(MgShapes* shapes, const MgRegionQuery& query);
+
+    //! 返回选中的图形ID，按ID从小到大排列
+    const std::vector<UInt32>& getIDs() const { return _ids; }
+
+    //! 返回选中图形中显示在最上面的图形ID，没有选中图形时返回0
+    UInt32 getTopID() const { return _topID; }
+
+    //! 返回上次 update() 时判断过的图形个数
+    UInt32 getTestedCount() const { return _tested; }
+
+    //! 返回上次 update() 是否为增量查找
+    bool isIncremental() const { return _incremental; }
+
+private:
+    void queryAll(MgShapes* shapes, const MgRegionQuery& query);
+    void queryDelta(MgShapes* shapes, const MgRegionQuery& query, const Box2d& delta, bool grow);
+    void scanDelta(MgShapes* shapes, const MgRegionQuery& query, const Box2d* strips,
+                   int grows, int count);
+    void mergeChanges();
+    void checkTop(const MgShape* shape);
+    void findTop();
+    static int subtractBox(const Box2d& a, const Box2d& b, Box2d* strips);
+
+private:
+    friend struct MgRegionDeltaVisitor;
+    friend struct MgRegionCacheVisitor;
+
+    std::vector<UInt32> _ids;       // 已选中的图形ID，有序
+    std::vector<UInt32> _added;     // 增量查找时新选中的图形ID
+    std::vector<UInt32> _removed;   // 增量查找时不再选中的图形ID
+    MgShapes*   _shapes;            // 上次查找的图形列表
+    UInt32      _changeCount;       // 上次查找时图形列表的改变计数
+    Box2d       _box;               // 上次的矩形框
+    bool        _contains;
+    bool        _valid;             // 上次为矩形框查找
+    bool        _scanAll;           // 增量查找的候选图形太多，直到 reset() 都遍历全部图形
+    bool        _changed;
+    bool        _incremental;
+    UInt32      _tested;
+    UInt32      _candidates;        // 增量查找时条带内的图形个数
+    UInt32      _topID;             // 显示在最上面的选中图形
+    UInt32      _topOrder;          // 该图形的显示次序
+    std::vector<MgShape*>   _items;     // 遍历全部图形时按显示次序缓存的图形
+    std::vector<Box2d>      _extents;   // 对应图形的包络框
+    std::vector<bool>       _flags;     // 对应图形是否选中
+};
+
+#endif // __GEOMETRY_MGREGION_H_
@@ -136,9 +136,13 @@ public:
     
     //! 移动图形, segment 由 hitTest() 得到
     virtual bool offset(const Vector2d& vec, Int32 segment) = 0;
+    
+    //! 返回修改标记，图形每次 update() 等改变后取新值，各个图形的标记不重复
+    UInt32 getChangeCount() const { return _changeCount; }
 
 protected:
     Box2d   _extent;
+    UInt32  _changeCount;
 
 protected:
     void _copy(const MgBaseShape& src);
@@ -0,0 +1,155 @@
+//! \file mgshapeidx.h
+//! \brief 定义图形索引类 MgShapeIndex
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGSHAPE_INDEX_H_
+#define __GEOMETRY_MGSHAPE_INDEX_H_
+
+#include <mgshape.h>
+#include <vector>
+
+//! 图形索引类，供图形列表按ID、标识和区域快速查找图形
+/*! \ingroup GEOM_SHAPE
+    按ID和标识(非0)建立散列索引；图形个数较多时再按包络框建立空间索引，
+    区域查找结果按图形加入次序排列，以保持显示的上下层次不变。\n
+    图形的包络框或标识改变后需调用 updateShape() 或 sync() 同步。\n
+    延迟加载时可先记录待加载图形的类型、ID和包络框(addPending)，
+    在显示或选中时再取出(takePending)并创建图形。
+*/
+class MgShapeIndex
+{
+public:
+    //! 图形个数达到此数量后才建立空间索引
+    enum { kMinShapes = 64 };
+
+    //! 待加载的图形
+    struct Pending {
+        UInt32  type;       //!< 图形类型
+        UInt32  id;         //!< 图形ID
+        UInt32  order;      //!< 加入次序
+        UInt32  mark;       //!< 在存取对象中的读取位置，见 MgStorage::tellRead()
+        Box2d   box;        //!< 包络框
+    };
+
+    MgShapeIndex();
+    ~MgShapeIndex();
+
+    //! 删除所有图形的索引，ID重新从1开始分配
+    void clear();
+
+    //! 返回索引的图形个数
+    UInt32 getCount() const;
+
+    //! 添加一个图形，其次序在已有图形之后
+    /*!
+        \param shape 已设置ID的图形
+        \param deferSpatial 是否暂不更新空间索引，批量添加后再调用 buildSpatial()
+    */
+    void addShape(MgShape* shape, bool deferSpatial = false);
+
+    //! 移除一个图形的索引
+    bool removeShape(MgShape* shape);
+
+    //! 如果图形的包络框、ID或标识改变了则更新索引，返回是否改变
+    /*!
+        \param shape 图形
+        \param deferSpatial 是否暂不更新空间索引，之后须调用 flushSpatial()，
+            flushSpatial() 前可多次暂缓更新同一图形，也可移除该图形
+    */
+    bool updateShape(MgShape* shape, bool deferSpatial = false);
+
+    //! 更新暂缓的空间索引，改变的图形较多时重新构造空间索引
+    void flushSpatial();
+
+    //! 同步所有图形的索引，Container 为包含(MgShape*)的容器
+    /*! 耗时与图形个数成正比，已知改变了哪些图形时应只对这些图形调用 updateShape()
+    */
+    template <typename Container>
+    void sync(const Container& shapes) {
+        for (typename Container::const_iterator it = shapes.begin();
+             it != shapes.end(); ++it) {
+            updateShape(*it, true);
+        }
+        flushSpatial();
+    }
+
+    //! 图形(含待加载的图形)足够多时重新构造空间索引
+    void buildSpatial();
+
+    //! 返回是否已建立空间索引
+    bool hasSpatial() const;
+
+    //! 查找指定ID的图形
+    MgShape* findShape(UInt32 nID) const;
+
+    //! 查找指定标识(非0)的图形，有多个时返回最先加入索引的图形
+    MgShape* findShapeByTag(UInt32 tag) const;
+
+    //! 返回可用的新图形ID
+    /*! 如果给定ID非0且未被使用则返回该ID，否则返回比已分配过的ID都大的新ID，
+        删除图形后其ID不再重用。
+    */
+    UInt32 getNewID(UInt32 nID) const;
+
+    //! 返回图形的加入次序
+    UInt32 getOrder(const MgShape* shape) const;
+
+    //! 添加一个待加载的图形，占用加入次序和ID，返回分配的图形ID
+    UInt32 addPending(UInt32 type, UInt32 id, const Box2d& box, UInt32 mark);
+
+    //! 返回待加载的图形个数
+    UInt32 getPendingCount() const;
+
+    //! 返回待加载图形的包络框，只读取不计算，取出图形后需先调用 updatePendingExtent()
+    Box2d getPendingExtent() const;
+
+    //! 返回是否取出了包络框边上的待加载图形，需调用 updatePendingExtent()
+    bool isPendingExtentDirty() const;
+
+    //! 重新计算待加载图形的包络框，调用者需与取出图形互斥
+    void updatePendingExtent();
+
+    //! 取出与给定矩形框相交的待加载图形，按加入次序排列，返回个数
+    UInt32 takePending(const Box2d& box, std::vector<Pending>& items);
+
+    //! 取出所有待加载的图形，按加入次序排列，返回个数
+    UInt32 takePending(std::vector<Pending>& items);
+
+    //! 取出指定ID的待加载图形
+    bool takePending(UInt32 nID, Pending& item);
+
+    //! 添加由待加载图形创建的图形，使用其原来的加入次序
+    void addShape(MgShape* shape, const Pending& item);
+
+    //! 查找与给定矩形框相交的图形，需已建立空间索引
+    /*!
+        \param box 模型坐标的矩形框
+        \param shapes 填充找到的图形，按图形加入次序排列
+        \return 找到的图形个数
+    */
+    UInt32 query(const Box2d& box, std::vector<MgShape*>& shapes) const;
+
+    //! 查找与给定矩形框相交的图形项，需已建立空间索引
+    /*! 结果数组在查找前清空，可重用该数组以免每次查找都分配内存
+        \param box 模型坐标的矩形框
+        \param items 填充找到的图形项，按图形加入次序排列，用 getShape() 取图形
+        \return 找到的图形个数
+    */
+    UInt32 query(const Box2d& box, std::vector<void*>& items) const;
+
+    //! 返回 query() 找到的图形项对应的图形
+    static MgShape* getShape(const void* item);
+
+private:
+    void addItem(MgShape* shape, UInt32 order, bool deferSpatial);
+
+private:
+    struct Impl;
+    Impl*   _impl;
+
+    MgShapeIndex(const MgShapeIndex&);
+    void operator=(const MgShapeIndex&);
+};
+
+#endif // __GEOMETRY_MGSHAPE_INDEX_H_
@@ -9,6 +9,18 @@
 #include <mgshape.h>
 
 class MgLockRW;
+struct MgRegionQuery;
+
+//! 图形遍历的回调接口
+/*! \ingroup GEOM_SHAPE
+    \interface MgShapeVisitor
+    \see MgShapes::traverse
+*/
+struct MgShapeVisitor
+{
+    //! 访问一个图形，返回false则停止遍历
+    virtual bool visit(MgShape* shape) = 0;
+};
 
 //! 图形列表接口
 /*! \ingroup GEOM_SHAPE
@@ -20,22 +32,78 @@ struct MgShapes : public MgObject
     
     virtual UInt32 getShapeCount() const = 0;
 
+    //! 开始遍历，须与 freeIterator() 配对使用，每次遍历要分配迭代器，建议用 traverse() 或 getShapes()
     virtual MgShape* getFirstShape(void*& it) const = 0;
     virtual MgShape* getNextShape(void*& it) const = 0;
     virtual void freeIterator(void*& it) = 0;
+    
+    //! 按显示次序遍历图形，不分配内存，返回访问的图形个数
+    /*! 回调函数返回false时停止遍历，此时返回值包含该图形。
+        遍历时不能添加或删除图形。
+    */
+    virtual UInt32 traverse(MgShapeVisitor& visitor) const = 0;
+    
+    //! 按显示次序批量获取图形，不分配内存
+    /*! 链表容器定位到起始序号要逐个移动，遍历全部图形时用 traverse() 更快。
+        \param start 起始序号
+        \param count 最多获取多少个图形，为0时返回从起始序号开始的实际个数
+        \param shapes 填充图形对象，元素个数至少为count
+        \return 获取多少个图形，或实际个数
+    */
+    virtual UInt32 getShapes(UInt32 start, UInt32 count, MgShape** shapes) const = 0;
 
     virtual MgShape* getLastShape() const = 0;
     virtual MgShape* findShape(UInt32 nID) const = 0;
     virtual MgShape* findShapeByTag(UInt32 tag) const = 0;
+    
+    //! 返回图形的显示次序，越大越显示在上面，不是本列表的图形时返回0
+    virtual UInt32 getShapeOrder(const MgShape* shape) const = 0;
     virtual Box2d getExtent() const = 0;
     
     virtual MgShape* hitTest(const Box2d& limits, Point2d& nearpt, Int32& segment) const = 0;
+    
+    //! 按显示次序回调包络框与给定矩形框相交的图形，返回回调的图形个数
+    /*! 图形较多时用空间索引查找，回调函数返回false时停止查找。
+        \see traverse, queryRegion
+    */
+    virtual UInt32 queryExtent(const Box2d& box, MgShapeVisitor& visitor) const = 0;
+    
+    //! 按显示次序回调与区域相交或在区域内的图形，返回回调的图形个数
+    /*! 先用 queryExtent() 按区域的包络框筛选，再用 MgRegionQuery::match() 判断。
+        拖动选择框时用 MgRegionSelection 增量查找。
+        \see MgRegionQuery, MgRegionSelection
+    */
+    virtual UInt32 queryRegion(const MgRegionQuery& query, MgShapeVisitor& visitor) const = 0;
+    
     virtual int draw(GiGraphics& gs, const GiContext *ctx = NULL) const = 0;
     virtual UInt32 getChangeCount() = 0;
+    
+    //! 写锁定结束时调用，增加改变次数并批量更新 shapeChanged() 登记的图形的空间索引
     virtual void afterChanged() = 0;
+    
+    //! 登记图形的包络框、ID或标识已改变，在写锁定期间修改图形后调用
+    /*! 立即更新该图形的散列索引，空间索引到 afterChanged() 时再批量更新。
+        \see syncIndex
+    */
+    virtual void shapeChanged(MgShape* shape) = 0;
+    
+    //! 按所有图形的当前内容同步索引，用于修改了图形但未调用 shapeChanged() 的情况
+    /*! 耗时与图形个数成正比，应在写锁定期间调用。
+    */
+    virtual void syncIndex() = 0;
+    
     virtual bool save(MgStorage* s, UInt32 startIndex = 0) const = 0;
     virtual bool load(MgStorage* s, bool addOnly = false) = 0;
     
+    //! 延迟加载图形，先只读取各图形的类型、ID和包络框，显示或选中时再读取图形
+    /*! 存取对象须支持 MgStorage::tellRead()，否则同 load()；
+        存取对象须保持有效，直到调用 loadPending() 或 clear()。
+    */
+    virtual bool loadLazy(MgStorage* s, bool addOnly = false) = 0;
+    
+    //! 读取所有延迟加载的图形，此后不再使用延迟加载的存取对象
+    virtual void loadPending() = 0;
+    
     //! 删除所有图形
     virtual void clear() = 0;
     
@@ -66,14 +134,47 @@ struct MgShapes : public MgObject
 
 #ifndef SWIG
 
-//! 读写锁定数据类
+//! 读写锁定的统计数据，时间单位为毫秒
 /*! \ingroup GEOM_SHAPE
+    \see MgLockRW::getStats
+*/
+struct MgLockStats
+{
+    long    locks;          //!< 锁定成功的次数
+    long    writeLocks;     //!< 其中写锁定的次数
+    long    contended;      //!< 需要等待其他锁定者的次数
+    long    timeouts;       //!< 超时未锁定的次数
+    double  waitTime;       //!< 累计等待时间
+    double  maxWait;        //!< 最长的一次等待时间
+    double  holdTime;       //!< 累计占用时间，读锁定按有读者的时段计
+    double  maxHold;        //!< 最长的一次占用时间
+
+    MgLockStats() : locks(0), writeLocks(0), contended(0), timeouts(0)
+        , waitTime(0), maxWait(0), holdTime(0), maxHold(0) {}
+};
+
+struct MgLockRWImpl;
+
+//! 读写锁定数据类
+/*! 允许多个读者或一个写者，锁定不了时阻塞等待到其他锁定者解锁或超时。
+    有写者在等待时新的读者也等待，以免写者被连续的读者饿死，
+    因此同一线程在已读锁定时不要在其他线程等待写锁定期间再次读锁定，否则只能等到超时。
+    \ingroup GEOM_SHAPE
 */
 class MgLockRW
 {
 public:
     MgLockRW();
+    ~MgLockRW();
+    
+    //! 锁定，返回是否锁定成功
+    /*!
+        \param forWrite 是写锁定还是读锁定
+        \param timeout 最长等待的毫秒数，为0时不等待
+    */
     bool lock(bool forWrite, int timeout = 200);
+    
+    //! 解锁，返回剩余的锁定者个数
     long unlock(bool forWrite);
     
     bool firstLocked();
@@ -85,9 +186,20 @@ public:
         _editFlags = flags ? (_editFlags | flags) : 0;
     }
     
+    //! 返回等待、占用和超时的统计数据
+    MgLockStats getStats() const;
+    
+    //! 清除统计数据
+    void resetStats();
+    
 private:
+    friend class MgShapesLock;              // 访问图形列表的锁定观察者
+    MgLockRWImpl*   _impl;
     volatile long _counts[3];
     int     _editFlags;
+    
+    MgLockRW(const MgLockRW&);
+    void operator=(const MgLockRW&);
 };
 
 //! 图形列表锁定辅助类
@@ -110,8 +222,14 @@ public:
     void resetEditFlags() { shapes->getLockData()->setEditFlags(0); }
     
     typedef void (*ShapesLocked)(MgShapes* sp, void* obj, bool locked);
+    
+    //! 登记所有图形列表的写锁定观察者
     static void registerObserver(ShapesLocked func, void* obj);
     static void unregisterObserver(ShapesLocked func, void* obj);
+    
+    //! 登记指定图形列表的写锁定观察者，只在该图形列表写锁定和解锁时通知
+    static void registerObserver(MgShapes* sp, ShapesLocked func, void* obj);
+    static void unregisterObserver(MgShapes* sp, ShapesLocked func, void* obj);
 };
 
 //! 动态图形锁定辅助类
@@ -120,13 +238,24 @@ public:
 class MgDynShapeLock
 {
     int         m_mode;
+    MgLockRW*   m_lock;
 public:
+    //! 锁定默认命令管理器 mgGetCommandManager() 的动态图形
     MgDynShapeLock(bool forWrite = true, int timeout = 200);
+    
+    //! 锁定指定的动态图形锁，例如 MgCommandManager::getDynamicShapeLock()
+    MgDynShapeLock(MgLockRW* lock, bool forWrite = true, int timeout = 200);
     ~MgDynShapeLock();
     
     bool locked();
     static bool lockedForRead();
     static bool lockedForWrite();
+    
+    //! 返回默认动态图形锁的统计数据
+    static MgLockStats getStats();
+    
+    //! 清除默认动态图形锁的统计数据
+    static void resetStats();
 };
 
 #endif // SWIG
@@ -8,7 +8,11 @@
 
 #include <mgshapes.h>
 #include <mgstorage.h>
+#include <mgshapeidx.h>
+#include <mgregion.h>
 #include <gigraph.h>
+#include <algorithm>
+#include <iterator>
 
 MgShape* mgCreateShape(UInt32 type);
 
@@ -25,7 +29,7 @@ class MgShapesT : public MgShapes
     typedef typename Container::iterator iterator;
 public:
     MgShapesT(bool hasContext = true) : _context(hasContext ? new ContextT() : NULL)
-        , _scale(1), _changeCount(0)
+        , _scale(1), _changeCount(0), _queryBusy(0), _lazyStorage(NULL)
     {
     }
 
@@ -82,6 +86,8 @@ public:
         for (; it != _shapes.end(); ++it)
             (*it)->release();
         _shapes.clear();
+        _index.clear();
+        _lazyStorage = NULL;
     }
 
     MgShape* addShape(const MgShape& src)
@@ -89,28 +95,32 @@ public:
         MgShape* p = (MgShape*)src.clone();
         if (p)
         {
-            p->setParent(this, getNewID(src.getID()));
+            p->setParent(this, _index.getNewID(src.getID()));
             _shapes.push_back(p);
+            _index.addShape(p);
         }
         return p;
     }
     
     MgShape* removeShape(UInt32 nID)
     {
-        for (iterator it = _shapes.begin(); it != _shapes.end(); ++it)
-        {
-            MgShape* shape = *it;
-            if (shape->getID() == nID) {
-                _shapes.erase(it);
-                return shape;
-            }
+        MgShape* shape = findShape(nID);
+        iterator it = _shapes.end();
+
+        if (shape)
+            it = std::find(_shapes.begin(), _shapes.end(), shape);
+        if (it != _shapes.end()) {
+            _shapes.erase(it);
+            _index.removeShape(shape);
+            return shape;
         }
         return NULL;
     }
 
     UInt32 getShapeCount() const
     {
-        return _shapes.size();
+        LazyReader reader(this);
+        return _shapes.size() + _index.getPendingCount();
     }
 
     void freeIterator(void*& it)
@@ -121,6 +131,8 @@ public:
 
     MgShape* getFirstShape(void*& it) const
     {
+        loadAllPending();
+        LazyReader reader(this);
         it = (void*)(new const_iterator(_shapes.begin()));
         return _shapes.empty() ? NULL : _shapes.front();
     }
@@ -136,23 +148,76 @@ public:
         return NULL;
     }
     
+    UInt32 traverse(MgShapeVisitor& visitor) const
+    {
+        UInt32 n = 0;
+
+        loadAllPending();
+        LazyReader reader(this);
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+        {
+            n++;
+            if (!visitor.visit(*it))
+                break;
+        }
+        return n;
+    }
+
+    UInt32 getShapes(UInt32 start, UInt32 count, MgShape** shapes) const
+    {
+        loadAllPending();
+        LazyReader reader(this);
+
+        UInt32 size = (UInt32)_shapes.size();
+        if (start >= size)
+            return 0;
+        if (count == 0 || !shapes)
+            return size - start;
+
+        const_iterator it = _shapes.begin();
+        UInt32 n = 0;
+
+        std::advance(it, start);
+        for (; n < count && it != _shapes.end(); ++it)
+            shapes[n++] = *it;
+        return n;
+    }
+    
     MgShape* getLastShape() const
     {
+        loadAllPending();
+        LazyReader reader(this);
         return _shapes.empty() ? NULL : _shapes.back();
     }
 
     MgShape* findShape(UInt32 nID) const
     {
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+        MgShape* shape;
+
         {
-            if ((*it)->getID() == nID)
-                return *it;
+            LazyReader reader(this);
+            shape = _index.findShape(nID);
         }
-        return NULL;
+        if (!shape && _index.getPendingCount() > 0) {
+            ThisClass* self = const_cast<ThisClass*>(this);
+            std::vector<MgShapeIndex::Pending> items(1);
+
+            if (self->_lazyLock.lock(true)) {
+                if (self->_index.takePending(nID, items.front()))
+                    shape = loadPendingItems(items);
+                self->_lazyLock.unlock(true);
+            }
+        }
+        return shape;
     }
 
     MgShape* findShapeByTag(UInt32 tag) const
     {
+        loadAllPending();
+        LazyReader reader(this);
+        if (tag != 0)
+            return _index.findShapeByTag(tag);
+
         for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
         {
             if ((*it)->getTag() == tag)
@@ -161,9 +226,20 @@ public:
         return NULL;
     }
 
+    UInt32 getShapeOrder(const MgShape* shape) const
+    {
+        LazyReader reader(this);
+        return shape ? _index.getOrder(shape) : 0;
+    }
+
     Box2d getExtent() const
     {
+        updatePendingExtent();
+        LazyReader reader(this);
         Box2d extent;
+
+        if (_index.getPendingCount() > 0)
+            extent = _index.getPendingExtent();
         for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
         {
             extent.unionWith((*it)->shape()->getExtent());
@@ -177,27 +253,20 @@ public:
         MgShape* retshape = NULL;
         float distMin = _FLT_MAX;
 
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
-        {
-            const MgBaseShape* shape = (*it)->shape();
-            Box2d extent(shape->getExtent());
-
-            if (extent.isIntersect(limits))
-            {
-                Point2d tmpNear;
-                Int32   tmpSegment;
-                float  tol = !(*it)->context()->hasFillColor() ?
-                    limits.width() / 2 : mgMax(extent.width(), extent.height());
-                float  dist = shape->hitTest(limits.center(), tol, tmpNear, tmpSegment);
-
-                if (distMin > dist) {
-                    distMin = dist;
-                    segment = tmpSegment;
-                    nearpt = tmpNear;
-                    retshape = *it;
-                }
+        loadPending(limits);
+        LazyReader reader(this);
+        if (_index.hasSpatial()) {
+            std::vector<MgShape*> found;
+            _index.query(limits, found);
+            for (std::vector<MgShape*>::const_iterator it = found.begin();
+                 it != found.end(); ++it) {
+                hitTestShape(*it, limits, distMin, nearpt, segment, retshape);
             }
         }
+        else {
+            for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+                hitTestShape(*it, limits, distMin, nearpt, segment, retshape);
+        }
         if (retshape && distMin > limits.width()
             && !retshape->context()->hasFillColor())
         {
@@ -207,16 +276,76 @@ public:
         return retshape;
     }
 
+    UInt32 queryExtent(const Box2d& box, MgShapeVisitor& visitor) const
+    {
+        ThisClass* self = const_cast<ThisClass*>(this);
+        std::vector<void*> local;
+        bool reuse = (giInterlockedIncrement(&self->_queryBusy) == 1);
+        std::vector<void*>& found = reuse ? self->_queryItems : local;  // 回调中或其他线程再查找时用临时缓冲
+        UInt32 n = 0;
+
+        loadPending(box);
+        {
+            LazyReader reader(this);        // 只在收集图形时锁定，回调中可再调用本对象的函数
+            if (_index.hasSpatial()) {
+                _index.query(box, found);
+                for (size_t i = 0; i < found.size(); i++)
+                    found[i] = MgShapeIndex::getShape(found[i]);
+            }
+            else {
+                found.assign(_shapes.begin(), _shapes.end());
+            }
+        }
+        for (size_t i = 0; i < found.size(); i++) {
+            MgShape* sp = (MgShape*)found[i];
+            if (sp->shape()->getExtent().isIntersect(box)) {
+                n++;
+                if (!visitor.visit(sp))
+                    break;
+            }
+        }
+        giInterlockedDecrement(&self->_queryBusy);
+
+        return n;
+    }
+
+    UInt32 queryRegion(const MgRegionQuery& query, MgShapeVisitor& visitor) const
+    {
+        RegionVisitor filter(query, visitor);
+        queryExtent(query.box, filter);
+        return filter.count;
+    }
+
     int draw(GiGraphics& gs, const GiContext *ctx = NULL) const
     {
         Box2d clip(gs.getClipModel());
         int count = 0;
         
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
-        {
-            if ((*it)->shape()->getExtent().isIntersect(clip)) {
-                if ((*it)->draw(gs, ctx))
-                    count++;
+        loadPending(clip);
+        LazyReader reader(this);
+        if (_index.hasSpatial()) {
+            ThisClass* self = const_cast<ThisClass*>(this);
+            std::vector<void*> local;
+            bool reuse = (giInterlockedIncrement(&self->_queryBusy) == 1);
+            std::vector<void*>& found = reuse ? self->_queryItems : local;  // 嵌套显示或其他线程同时显示时用临时缓冲
+
+            _index.query(clip, found);
+            for (size_t i = 0; i < found.size(); i++) {
+                MgShape* sp = MgShapeIndex::getShape(found[i]);
+                if (sp->shape()->getExtent().isIntersect(clip)) {
+                    if (sp->draw(gs, ctx))
+                        count++;
+                }
+            }
+            giInterlockedDecrement(&self->_queryBusy);
+        }
+        else {
+            for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+            {
+                if ((*it)->shape()->getExtent().isIntersect(clip)) {
+                    if ((*it)->draw(gs, ctx))
+                        count++;
+                }
             }
         }
         
@@ -231,6 +360,18 @@ public:
     void afterChanged()
     {
         giInterlockedIncrement(&_changeCount);
+        _index.flushSpatial();
+    }
+    
+    void shapeChanged(MgShape* shape)
+    {
+        if (shape && shape->getParent() == this)
+            _index.updateShape(shape, true);
+    }
+    
+    void syncIndex()
+    {
+        _index.sync(_shapes);
     }
     
     bool save(MgStorage* s, UInt32 startIndex = 0) const
@@ -239,6 +380,8 @@ public:
         Box2d rect;
         UInt32 index = 0;
         
+        loadAllPending();
+        LazyReader reader(this);
         if (_context) {
             if (!s->writeNode("shapedoc", -1, false))
                 return false;
@@ -284,6 +427,75 @@ public:
     }
     
     bool load(MgStorage* s, bool addOnly = false)
+    {
+        return loadShapes(s, addOnly, false);
+    }
+
+    bool loadLazy(MgStorage* s, bool addOnly = false)
+    {
+        return loadShapes(s, addOnly, true);
+    }
+
+    void loadPending()
+    {
+        loadAllPending();
+    }
+
+    GiContext* context()
+    {
+        return _context;
+    }
+    
+    Matrix2d& modelTransform()
+    {
+        return _xf;
+    }
+    
+    float getViewScale() const
+    {
+        return _scale;
+    }
+    
+    Point2d getViewCenterW() const
+    {
+        return _centerW;
+    }
+    
+    void setZoomState(float scale, const Point2d& centerW)
+    {
+        _scale = scale;
+        _centerW = centerW;
+    }
+    
+    virtual MgLockRW* getLockData()
+    {
+        return &_lock;
+    }
+
+private:
+    // 还有延迟加载的图形时读锁定 _lazyLock，以免其他读者同时加载图形而改变图形容器和索引
+    /* 图形列表的读锁定允许多个读者，而读取时可能加载图形，因此读取图形容器和索引时要与加载互斥。
+       全部加载后不再锁定。
+    */
+    class LazyReader
+    {
+    public:
+        LazyReader(const ThisClass* owner) : _lock(NULL) {
+            if (owner->_lazyStorage) {
+                MgLockRW* lock = &const_cast<ThisClass*>(owner)->_lazyLock;
+                if (lock->lock(false, 2000))
+                    _lock = lock;
+            }
+        }
+        ~LazyReader() {
+            if (_lock)
+                _lock->unlock(false);
+        }
+    private:
+        MgLockRW*   _lock;
+    };
+
+    bool loadShapes(MgStorage* s, bool addOnly, bool lazy)
     {
         bool ret = false;
         Box2d rect;
@@ -307,18 +519,29 @@ public:
             
             if (!addOnly)
                 clear();
+            else if (lazy && _lazyStorage != s)
+                loadAllPending();
             
-            while (ret && s->readNode("shape", index, false)) {
+            for (;;) {
+                UInt32 mark = lazy ? s->tellRead() : 0;
+                if (!ret || !s->readNode("shape", index, false))
+                    break;
+                
                 UInt32 type = s->readUInt32("type");
                 UInt32 id = s->readUInt32("id");
-                MgShape* shape = mgCreateShape(type);
+                MgShape* shape = mark ? NULL : mgCreateShape(type);
                 
                 s->readFloatArray("extent", &rect.xmin, 4);
-                if (shape) {
-                    shape->setParent(this, id);
+                if (mark) {
+                    _index.addPending(type, id, rect, mark);
+                    _lazyStorage = s;
+                }
+                else if (shape) {
+                    shape->setParent(this, _index.getNewID(id));
                     ret = shape->load(s);
                     if (ret) {
                         _shapes.push_back(shape);
+                        _index.addShape(shape, true);
                     }
                     else {
                         shape->release();
@@ -327,6 +550,7 @@ public:
                 s->readNode("shape", index++, true);
             }
             s->readNode("shapes", _context ? 0 : -1, true);
+            _index.buildSpatial();
         }
         
         if (_context) {
@@ -336,48 +560,146 @@ public:
         return ret;
     }
 
-    GiContext* context()
+    // 读取与给定矩形框相交的延迟加载图形
+    void loadPending(const Box2d& box) const
     {
-        return _context;
+        if (_index.getPendingCount() > 0) {
+            ThisClass* self = const_cast<ThisClass*>(this);
+            std::vector<MgShapeIndex::Pending> items;
+            
+            if (self->_lazyLock.lock(true)) {
+                if (self->_index.takePending(box, items) > 0)
+                    loadPendingItems(items);
+                self->_lazyLock.unlock(true);
+            }
+        }
     }
-    
-    Matrix2d& modelTransform()
+
+    // 取出过待加载图形后重新计算其包络框，写锁定以免多个读者同时计算
+    void updatePendingExtent() const
     {
-        return _xf;
+        if (_index.getPendingCount() > 0 && _index.isPendingExtentDirty()) {
+            ThisClass* self = const_cast<ThisClass*>(this);
+            
+            if (self->_lazyLock.lock(true)) {
+                self->_index.updatePendingExtent();
+                self->_lazyLock.unlock(true);
+            }
+        }
     }
-    
-    float getViewScale() const
+
+    // 读取所有延迟加载的图形
+    void loadAllPending() const
     {
-        return _scale;
+        if (_index.getPendingCount() > 0) {
+            ThisClass* self = const_cast<ThisClass*>(this);
+            std::vector<MgShapeIndex::Pending> items;
+            
+            if (self->_lazyLock.lock(true)) {
+                if (self->_index.takePending(items) > 0)
+                    loadPendingItems(items);
+                self->_lazyLock.unlock(true);
+            }
+        }
     }
-    
-    Point2d getViewCenterW() const
+
+    // 创建并读取已从索引中取出的延迟加载图形，返回最后一个图形
+    /*! 须已写锁定 _lazyLock。图形按原来的加入次序插入，以保持显示次序和保存次序不变。
+    */
+    MgShape* loadPendingItems(const std::vector<MgShapeIndex::Pending>& items) const
     {
-        return _centerW;
+        ThisClass* self = const_cast<ThisClass*>(this);
+        MgStorage* s = _lazyStorage;
+        MgShape* shape = NULL;
+        UInt32 lastOrder = _shapes.empty() ? 0 : _index.getOrder(_shapes.back());
+        bool unordered = false;
+        
+        for (std::vector<MgShapeIndex::Pending>::const_iterator it = items.begin();
+             it != items.end(); ++it) {
+            shape = s && s->seekRead(it->mark) ? mgCreateShape(it->type) : NULL;
+            if (shape && s->readNode("shape", -1, false)) {
+                shape->setParent(self, it->id);
+                if (shape->load(s)) {
+                    self->_shapes.push_back(shape);
+                    self->_index.addShape(shape, *it);
+                    unordered = unordered || it->order < lastOrder;
+                }
+                else {
+                    shape->release();
+                    shape = NULL;
+                }
+                s->readNode("shape", -1, true);
+            }
+            else if (shape) {
+                shape->release();
+                shape = NULL;
+            }
+        }
+        if (unordered)                          // 在已加载图形之前的图形
+            sortShapes();
+        if (_index.getPendingCount() == 0) {
+            giMemoryBarrier();                  // 此后读者不再锁定
+            self->_lazyStorage = NULL;
+        }
+        
+        return shape;
     }
-    
-    void setZoomState(float scale, const Point2d& centerW)
+
+    // 按加入次序重排图形，先加载了后面的图形时在容器中的次序不对
+    void sortShapes() const
     {
-        _scale = scale;
-        _centerW = centerW;
+        ThisClass* self = const_cast<ThisClass*>(this);
+        std::vector<std::pair<UInt32, MgShape*> > arr;
+        
+        arr.reserve(_shapes.size());
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+            arr.push_back(std::pair<UInt32, MgShape*>(_index.getOrder(*it), *it));
+        std::sort(arr.begin(), arr.end());
+        
+        iterator dest = self->_shapes.begin();
+        for (size_t i = 0; i < arr.size(); ++i, ++dest)
+            *dest = arr[i].second;
     }
-    
-    virtual MgLockRW* getLockData()
+
+    // 只回调符合区域条件的图形
+    struct RegionVisitor : public MgShapeVisitor
     {
-        return &_lock;
-    }
+        const MgRegionQuery&    query;
+        MgShapeVisitor&         visitor;
+        UInt32                  count;
+        
+        RegionVisitor(const MgRegionQuery& q, MgShapeVisitor& v)
+            : query(q), visitor(v), count(0) {}
+        
+        bool visit(MgShape* sp) {
+            if (!query.match(sp->shapec()))
+                return true;
+            count++;
+            return visitor.visit(sp);
+        }
+    };
 
-private:
-    UInt32 getNewID(UInt32 nID)
+    void hitTestShape(MgShape* sp, const Box2d& limits, float& distMin,
+                      Point2d& nearpt, Int32& segment, MgShape*& retshape) const
     {
-        if (0 == nID || findShape(nID)) {
-            nID = 1;
-            if (!_shapes.empty())
-                nID = _shapes.back()->getID() + 1;
-            while (findShape(nID))
-                nID++;
+        const MgBaseShape* shape = sp->shape();
+        Box2d extent(shape->getExtent());
+
+        if (extent.isIntersect(limits))
+        {
+            Point2d tmpNear;
+            Int32   tmpSegment;
+            float  tol = !sp->context()->hasFillColor() ?
+                limits.width() / 2 : mgMax(extent.width(), extent.height());
+            float  dist = shape->hitTest(limits.center(), tol, tmpNear, tmpSegment);
+
+            if (distMin > dist) {
+                distMin = dist;
+                segment = tmpSegment;
+                nearpt = tmpNear;
+                retshape = sp;
+            }
         }
-        return nID;
     }
 
 protected:
@@ -388,6 +710,11 @@ protected:
     Point2d                 _centerW;
     long                    _changeCount;
     MgLockRW                _lock;
+    MgShapeIndex            _index;
+    std::vector<void*>      _queryItems;    // queryExtent() 和 draw() 的查找结果缓冲，不是每次都分配内存
+    volatile long           _queryBusy;     // 正在使用查找结果缓冲的次数
+    MgStorage* volatile     _lazyStorage;   // 延迟加载的存取对象，全部加载后为NULL
+    MgLockRW                _lazyLock;      // 读取延迟加载图形时锁定
 };
 
 #endif // __GEOMETRY_MGSHAPES_TEMPL_H_
@@ -0,0 +1,156 @@
+//! \file mgsnapshot.h
+//! \brief 定义图形列表的只读快照类 MgShapesSnapshot 和快照发布类 MgSnapshotStore
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGSNAPSHOT_H_
+#define __GEOMETRY_MGSNAPSHOT_H_
+
+#include <mgshapes.h>
+#include <mgmat.h>
+#include <vector>
+
+class MgSnapshotStore;
+struct MgSnapshotPublisher;
+
+//! 图形列表的只读快照
+/*! \ingroup GEOM_SHAPE
+    快照中的图形是发布时复制的图形，此后不再改变，与图形列表后来的编辑无关。
+    相邻版本中未改变的图形共用同一个复制图形。\n
+    快照只能读取，由 MgSnapshotStore 发布和释放。\n
+    同一版本或共用图形的多个版本可同时在多个线程中显示(每个线程用各自的 GiGraphics)，
+    图形在显示时延迟构造的内部缓存(例如折线的简化点)已加锁发布。
+    但复制图形的 update()、transform() 等改变函数会清除这些缓存，
+    因此在引用该图形的任一版本显示时都不能改变它。
+    \see MgSnapshotStore
+*/
+class MgShapesSnapshot
+{
+public:
+    //! 返回版本号，每次发布时加1
+    UInt32 getVersion() const { return _version; }
+
+    //! 返回图形个数
+    UInt32 getShapeCount() const { return (UInt32)_nodes.size(); }
+
+    //! 返回指定序号的图形，按图形列表中的显示次序
+    const MgShape* getShape(UInt32 index) const;
+
+    //! 返回所有图形的包络框
+    Box2d getExtent() const { return _extent; }
+
+    //! 返回发布时图形列表的模型变换矩阵
+    const Matrix2d& modelTransform() const { return _xf; }
+
+    //! 显示与剪裁框相交的图形，返回显示的图形个数
+    int draw(GiGraphics& gs, const GiContext *ctx = NULL) const;
+
+private:
+    friend class MgSnapshotStore;
+    friend struct MgSnapshotPublisher;
+
+    struct Node {
+        MgShape*        shape;          // 复制的图形
+        const MgShape*  source;         // 图形列表中的原图形
+        UInt32          changeCount;    // 复制时原图形的修改标记
+        Box2d           extent;
+        long            refcount;       // 引用该图形的快照个数，只在发布线程中改变
+    };
+
+    MgShapesSnapshot() : _version(0), _retiredEpoch(0) {}
+
+    std::vector<Node*>  _nodes;
+    UInt32              _version;
+    Box2d               _extent;
+    Matrix2d            _xf;
+    long                _retiredEpoch;  // 被新版本替换时的纪元
+};
+
+//! 图形列表快照的发布类
+/*! \ingroup GEOM_SHAPE
+    编辑线程在图形列表改变后调用 publish() 发布新版本，未改变的图形与上一版本共用。
+    显示线程先用 registerReader() 取得读者序号，每次显示前用 acquire() 取得当前版本，
+    显示后 release()，取得和释放快照都不用锁定，也不会等待编辑线程。\n
+    被替换的版本按纪元回收：只有当所有正在读取的读者都是在替换之后开始读取的，
+    才释放该版本及不再被引用的图形。publish() 和 reclaim() 只能在同一个线程(编辑线程)中调用。
+    \see MgSnapshotReader
+*/
+class MgSnapshotStore
+{
+public:
+    enum { kMaxReaders = 16 };              //!< 最多的读者个数
+
+    MgSnapshotStore();
+    ~MgSnapshotStore();
+
+    //! 发布图形列表的新版本，返回新版本
+    /*! 在编辑线程中图形列表改变后调用，调用时图形列表不能被其他线程改写。
+        图形的修改标记(MgBaseShape::getChangeCount())、图形属性和标记号不变的图形不再复制。
+    */
+    const MgShapesSnapshot* publish(MgShapes* shapes);
+
+    //! 释放不再被读者使用的旧版本，返回释放的版本数，publish() 时自动调用
+    int reclaim();
+
+    //! 返回最新发布的版本，只在编辑线程中使用
+    const MgShapesSnapshot* current() const { return _current; }
+
+    //! 返回等待回收的旧版本个数
+    UInt32 getRetiredCount() const { return (UInt32)_retired.size(); }
+
+    //! 返回上次发布时共用和复制的图形个数
+    void getPublishStats(UInt32& shared, UInt32& copied) const {
+        shared = _shared; copied = _copied;
+    }
+
+    //! 登记一个读者(显示线程)，返回读者序号，读者已满时返回-1
+    int registerReader();
+
+    //! 注销读者，须在 release() 之后调用
+    void unregisterReader(int reader);
+
+    //! 读者取得当前版本，在 release() 之前保持有效
+    const MgShapesSnapshot* acquire(int reader);
+
+    //! 读者释放 acquire() 取得的版本
+    void release(int reader);
+
+private:
+    void freeSnapshot(MgShapesSnapshot* snapshot);
+
+    MgShapesSnapshot* volatile  _current;
+    volatile long   _epoch;                 // 当前纪元，每次替换版本后加1
+    volatile long   _readerEpochs[kMaxReaders]; // 各读者开始读取时的纪元，0表示未读取
+    bool            _registered[kMaxReaders];
+    MgLockRW        _readersLock;           // 登记读者时锁定
+    std::vector<MgShapesSnapshot*> _retired;    // 等待回收的旧版本
+    UInt32          _version;
+    UInt32          _shared;
+    UInt32          _copied;
+
+    MgSnapshotStore(const MgSnapshotStore&);
+    void operator=(const MgSnapshotStore&);
+};
+
+//! 读取快照的辅助类
+/*! \ingroup GEOM_SHAPE
+    构造时取得当前版本，析构时释放。
+*/
+class MgSnapshotReader
+{
+public:
+    MgSnapshotReader(MgSnapshotStore* store, int reader)
+        : _store(store), _reader(reader)
+        , _snapshot(store && reader >= 0 ? store->acquire(reader) : NULL) {}
+    ~MgSnapshotReader() { if (_store && _reader >= 0) _store->release(_reader); }
+
+    //! 返回取得的版本，可能为NULL
+    const MgShapesSnapshot* snapshot() const { return _snapshot; }
+
+private:
+    MgSnapshotStore*        _store;
+    int                     _reader;
+    const MgShapesSnapshot* _snapshot;
+};
+
+#endif // __GEOMETRY_MGSNAPSHOT_H_
@@ -52,6 +52,13 @@ struct MgStorage
     //! 给定字段名称，取出字符串内容，不含0结束符. 传入缓冲为空时返回所需个
     virtual int readString(const char* name, char* value, int count) = 0;
     
+    //! 返回当前读取位置，不支持时返回0
+    /*! 在取出开始节点前调用，以后可用 seekRead() 回到此处再取出该节点，用于延迟加载图形。
+    */
+    virtual UInt32 tellRead() { return 0; }
+    //! 回到 tellRead() 返回的读取位置，返回是否支持
+    virtual bool seekRead(UInt32) { return false; }
+    
     //! 添加一个给定节点名称的开始节点或结束节点
     /*! 一个节点会调用两次本函数。
         \param name 节点名称
@@ -0,0 +1,72 @@
+//! \file mgstoragebin.h
+//! \brief 定义二进制图形存取类 MgStorageBin
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGSTORAGEBIN_H_
+#define __GEOMETRY_MGSTORAGEBIN_H_
+
+#include "mgstorage.h"
+
+//! 二进制图形存取类
+/*! \ingroup GEOM_SHAPE
+    字段按写入次序顺序存放，每个字段只记录字段名在名称表中的序号，
+    读取时按字段名字符串的地址缓存其序号，不再逐个比较字段名。\n
+    节点记录了内容长度，结束节点时跳过未读的内容；浮点数数组直接复制到目标缓冲。\n
+    支持 tellRead() 和 seekRead()，可延迟加载图形。\n
+    读取时可映射文件(open)或使用调用者的内存数据(attach)，写入后用 save() 保存到文件。\n
+    字段名应为常量字符串。
+*/
+class MgStorageBin : public MgStorage
+{
+public:
+    MgStorageBin();
+    virtual ~MgStorageBin();
+
+    //! 映射文件以便读取
+    bool open(const char* filename);
+
+    //! 使用已有内存数据以便读取，数据在读取期间须保持有效
+    bool attach(const void* data, UInt32 size);
+
+    //! 结束读取，解除文件映射
+    void close();
+
+    //! 将已写入的内容保存到文件
+    bool save(const char* filename);
+
+    //! 返回已写入的内容，在下次写入前有效
+    const void* getWrittenData(UInt32& size);
+
+    //! 清除已写入的内容，以便重新写入
+    void resetWriting();
+
+public:
+    virtual bool readNode(const char* name, int index, bool ended);
+    virtual bool readBool(const char* name, bool defvalue);
+    virtual float readFloat(const char* name, float defvalue = 0);
+    virtual int readFloatArray(const char* name, float* values, int count);
+    virtual int readString(const char* name, char* value, int count);
+    virtual UInt32 tellRead();
+    virtual bool seekRead(UInt32 pos);
+
+    virtual bool writeNode(const char* name, int index, bool ended);
+    virtual void writeBool(const char* name, bool value);
+    virtual void writeFloat(const char* name, float value);
+    virtual void writeFloatArray(const char* name, const float* values, int count);
+    virtual void writeString(const char* name, const char* value);
+
+protected:
+    virtual int readInt(const char* name, int defvalue = 0);
+    virtual void writeInt(const char* name, int value);
+
+private:
+    MgStorageBin(const MgStorageBin&);
+    void operator=(const MgStorageBin&);
+
+private:
+    struct Impl;
+    Impl*   _impl;
+};
+
+#endif // __GEOMETRY_MGSTORAGEBIN_H_
@@ -118,5 +118,6 @@ void RandomParam::initShapes(MgShapes* shapes)
         }
 
         sp->shape()->update();
+        shapes->shapeChanged(sp);
     }
 }
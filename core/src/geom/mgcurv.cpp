@@ -389,6 +389,77 @@ GEOMAPI bool mgTriEquations(
     return true;
 }
 
+GEOMAPI bool mgCyclicTriEquations(
+    Int32 n, float *a, float *b, float *c, Vector2d *vs)
+{
+    if (!a || !b || !c || !vs || n < 3)
+        return false;
+    
+    // A = A' + u * v^T, u = (g, 0, ..., 0, c[n-1]), v = (1, 0, ..., 0, a[n-1]/g)
+    // A' 为三对角阵，分别求解 A' * x = vs 和 A' * z = u
+    float g = -b[0];
+    float p = a[n-1];
+    float q = c[n-1];
+    float w, f;
+    Int32 i;
+    
+    if (mgIsZero(g))
+        return false;
+    b[0] -= g;
+    b[n-1] -= q * p / g;
+    
+    float* z = new float[n];
+    bool ret = true;
+    
+    w = 1 / b[0];
+    vs[0].x = vs[0].x * w;
+    vs[0].y = vs[0].y * w;
+    z[0] = g * w;
+    
+    for (i = 0; i <= n-2; i++)
+    {
+        b[i] = c[i] * w;
+        w = b[i+1] - a[i] * b[i];
+        if (mgIsZero(w)) {
+            ret = false;
+            break;
+        }
+        w = 1 / w;
+        vs[i+1].x = (vs[i+1].x - a[i] * vs[i].x) * w;
+        vs[i+1].y = (vs[i+1].y - a[i] * vs[i].y) * w;
+        z[i+1] = ((i+1 == n-1 ? q : 0) - a[i] * z[i]) * w;
+    }
+    
+    if (ret)
+    {
+        for (i = n-2; i >= 0; i--)
+        {
+            vs[i].x -= b[i] * vs[i+1].x;
+            vs[i].y -= b[i] * vs[i+1].y;
+            z[i] -= b[i] * z[i+1];
+        }
+        
+        // x = x - z * (v・x) / (1 + v・z)
+        w = 1 + z[0] + p * z[n-1] / g;
+        ret = !mgIsZero(w);
+    }
+    if (ret)
+    {
+        w = 1 / w;
+        Vector2d vx((vs[0].x + p * vs[n-1].x / g) * w,
+                    (vs[0].y + p * vs[n-1].y / g) * w);
+        for (i = 0; i < n; i++)
+        {
+            f = z[i];
+            vs[i].x -= vx.x * f;
+            vs[i].y -= vx.y * f;
+        }
+    }
+    
+    delete[] z;
+    return ret;
+}
+
 GEOMAPI bool mgGaussJordan(Int32 n, float *mat, Vector2d *vs)
 {
     Int32 i, j, k, m;
@@ -453,19 +524,17 @@ GEOMAPI bool mgGaussJordan(Int32 n, float *mat, Vector2d *vs)
 }
 
 static bool CalcCubicClosed(
-    Int32 n, float* a, Vector2d* vecs, const Point2d* knots)
+    Int32 n, const Point2d* knots, 
+    float* a, float* b, float* c, Vector2d* vecs)
 {
     Int32 i, n1 = n - 1;
 
-    for (i = n*n - 1; i >= 0; i--)
-        a[i] = 0.f;
-    
-    a[n1] = 1.0;
-    a[0]  = 4.0;
-    a[1]  = 1.0;
-    a[n1*n+n1 - 1] = 1.0;
-    a[n1*n+n1]   = 4.0;
-    a[n1*n+0]    = 1.0;
+    for (i = 0; i < n; i++)
+    {
+        a[i] = 1.0;         // a[n-1]为右上角元素
+        b[i] = 4.0;
+        c[i] = 1.0;         // c[n-1]为左下角元素
+    }
     vecs[0].x  = 3 * (knots[1].x-knots[n1].x);
     vecs[0].y  = 3 * (knots[1].y-knots[n1].y);
     vecs[n1].x = 3 * (knots[0].x-knots[n1 - 1].x);
@@ -473,14 +542,14 @@ static bool CalcCubicClosed(
     
     for (i = 1; i < n1; i++)
     {
-        a[i*n+i-1] = 1.0;
-        a[i*n+i]   = 4.0;
-        a[i*n+i+1] = 1.0;
         vecs[i].x = 3 * (knots[i+1].x-knots[i-1].x);
         vecs[i].y = 3 * (knots[i+1].y-knots[i-1].y);
     }
     
-    return mgGaussJordan(n, a, vecs);
+    if (n < 3)              // 两点闭合时无循环元素，切矢量为零
+        return mgTriEquations(n, a, b, c, vecs);
+    
+    return mgCyclicTriEquations(n, a, b, c, vecs);
 }
 
 static bool CalcCubicUnclosed(
@@ -550,19 +619,19 @@ GEOMAPI bool mgCubicSplines(
     if (!knots || !knotvs || n < 2)
         return false;
     
-    if ((flag & kCubicLoop) && n <= 512)    // 闭合
+    float* a = new float[n * 3];
+    
+    if (flag & kCubicLoop)                  // 闭合
     {
-        float* a = new float[n * n];
-        ret = a && CalcCubicClosed(n, a, knotvs, knots);
-        delete[] a;
+        ret = a && CalcCubicClosed(n, knots, 
+            a, a+n, a+2*n, knotvs);
     }
     else
     {
-        float* a = new float[n * 3];
         ret = a && CalcCubicUnclosed(flag, n, knots, 
             a, a+n, a+2*n, knotvs);
-        delete[] a;
     }
+    delete[] a;
     
     if (!mgIsZero(tension - 1.f))
     {
@@ -801,3 +870,70 @@ GEOMAPI void mgFitClampedSpline(
     fitpt.x = (knotvs[i].x * s1 + knotvs[i+1].x * s2) *s3 + tx1*(hp[i] - t) + tx2*t;
     fitpt.y = (knotvs[i].y * s1 + knotvs[i+1].y * s2) *s3 + ty1*(hp[i] - t) + ty2*t;
 }
+
+// 点到线段距离的平方
+static float ptToSegmentSqrd(const Point2d& a, const Point2d& b, const Point2d& pt)
+{
+    Vector2d ab(b - a);
+    Vector2d ap(pt - a);
+    float len2 = ab.lengthSqrd();
+    float t = len2 > _MGZERO ? ap.dotProduct(ab) / len2 : 0.f;
+
+    t = mgMax(0.f, mgMin(1.f, t));
+    return (ap - ab * t).lengthSqrd();
+}
+
+GEOMAPI Int32 mgSimplifyLines(
+    Int32 count, const Point2d* points, float tol, Int32* indices)
+{
+    Int32 i, n = 0;
+
+    if (count < 3) {
+        for (i = 0; i < count; i++)
+            indices[i] = i;
+        return count;
+    }
+
+    bool* keep = new bool[count];
+    Int32* stack = new Int32[count * 2];    // 待检查的分段，各分段互不重叠
+    Int32 top = 0;
+    float tol2 = tol * tol;
+
+    for (i = 0; i < count; i++)
+        keep[i] = false;
+    keep[0] = keep[count - 1] = true;
+    stack[top++] = 0;
+    stack[top++] = count - 1;
+
+    while (top > 0) {
+        Int32 last = stack[--top];
+        Int32 first = stack[--top];
+        Int32 index = 0;
+        float distMax = 0;
+
+        for (i = first + 1; i < last; i++) {        // 找离首末点连线最远的点
+            float dist = ptToSegmentSqrd(points[first], points[last], points[i]);
+            if (distMax < dist) {
+                distMax = dist;
+                index = i;
+            }
+        }
+        if (distMax > tol2) {                       // 保留最远点，分两段再检查
+            keep[index] = true;
+            stack[top++] = first;
+            stack[top++] = index;
+            stack[top++] = index;
+            stack[top++] = last;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (keep[i])
+            indices[n++] = i;
+    }
+
+    delete[] keep;
+    delete[] stack;
+
+    return n;
+}
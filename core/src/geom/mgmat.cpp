@@ -3,6 +3,15 @@
 // License: LGPL, https://github.com/rhcad/touchvg
 
 #include "mgmat.h"
+#include "mgbox.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MG_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MG_SIMD_NEON
+#include <arm_neon.h>
+#endif
 
 // 构造为单位矩阵
 Matrix2d::Matrix2d()
@@ -74,15 +83,124 @@ Point2d Point2d::transform(const Matrix2d& m) const
 // 对多个点进行矩阵变换
 void Matrix2d::TransformPoints(int count, Point2d* points) const
 {
-    for (int i = 0; i < count; i++)
-        points[i] *= (*this);
+    TransformPoints(count, points, points);
 }
 
 // 对多个矢量进行矩阵变换
 void Matrix2d::TransformVectors(int count, Vector2d* vectors) const
 {
-    for (int i = 0; i < count; i++)
-        vectors[i] *= (*this);
+    TransformVectors(count, vectors, vectors);
+}
+
+// 变换多个坐标对(x,y)，bounds 为NULL或填充 xmin,ymin,xmax,ymax
+static void transformPairs(int count, const float* src, float* dest,
+                          const Matrix2d& m, bool translate, float* bounds)
+{
+    int i = 0;
+    float tx = translate ? m.dx : 0.f;
+    float ty = translate ? m.dy : 0.f;
+
+#if defined(MG_SIMD_SSE2)
+    __m128 a = _mm_setr_ps(m.m11, m.m12, m.m11, m.m12);
+    __m128 b = _mm_setr_ps(m.m21, m.m22, m.m21, m.m22);
+    __m128 d = _mm_setr_ps(tx, ty, tx, ty);
+    __m128 vmin = _mm_set1_ps(_FLT_MAX);
+    __m128 vmax = _mm_set1_ps(-_FLT_MAX);
+
+    for (; i + 1 < count; i += 2) {
+        __m128 v = _mm_loadu_ps(src + i * 2);                       // x0 y0 x1 y1
+        __m128 xx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));  // x0 x0 x1 x1
+        __m128 yy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));  // y0 y0 y1 y1
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, a), _mm_mul_ps(yy, b)), d);
+
+        _mm_storeu_ps(dest + i * 2, r);
+        if (bounds) {
+            vmin = _mm_min_ps(vmin, r);
+            vmax = _mm_max_ps(vmax, r);
+        }
+    }
+    if (bounds && i > 0) {
+        float lo[4], hi[4];
+        _mm_storeu_ps(lo, vmin);
+        _mm_storeu_ps(hi, vmax);
+        bounds[0] = mgMin(lo[0], lo[2]);
+        bounds[1] = mgMin(lo[1], lo[3]);
+        bounds[2] = mgMax(hi[0], hi[2]);
+        bounds[3] = mgMax(hi[1], hi[3]);
+    }
+#elif defined(MG_SIMD_NEON)
+    const float va[4] = { m.m11, m.m12, m.m11, m.m12 };
+    const float vb[4] = { m.m21, m.m22, m.m21, m.m22 };
+    const float vd[4] = { tx, ty, tx, ty };
+    float32x4_t a = vld1q_f32(va);
+    float32x4_t b = vld1q_f32(vb);
+    float32x4_t d = vld1q_f32(vd);
+    float32x4_t vmin = vdupq_n_f32(_FLT_MAX);
+    float32x4_t vmax = vdupq_n_f32(-_FLT_MAX);
+
+    for (; i + 1 < count; i += 2) {
+        float32x4_t v = vld1q_f32(src + i * 2);                     // x0 y0 x1 y1
+        float32x4x2_t t = vtrnq_f32(v, v);                          // x0 x0 x1 x1, y0 y0 y1 y1
+        float32x4_t r = vaddq_f32(vaddq_f32(vmulq_f32(t.val[0], a),
+                                            vmulq_f32(t.val[1], b)), d);
+
+        vst1q_f32(dest + i * 2, r);
+        if (bounds) {
+            vmin = vminq_f32(vmin, r);
+            vmax = vmaxq_f32(vmax, r);
+        }
+    }
+    if (bounds && i > 0) {
+        float lo[4], hi[4];
+        vst1q_f32(lo, vmin);
+        vst1q_f32(hi, vmax);
+        bounds[0] = mgMin(lo[0], lo[2]);
+        bounds[1] = mgMin(lo[1], lo[3]);
+        bounds[2] = mgMax(hi[0], hi[2]);
+        bounds[3] = mgMax(hi[1], hi[3]);
+    }
+#endif
+
+    for (; i < count; i++) {                    // 剩余的点或没有SIMD指令时逐点变换
+        float x = src[i * 2];
+        float y = src[i * 2 + 1];
+
+        dest[i * 2] = x * m.m11 + y * m.m21 + tx;
+        dest[i * 2 + 1] = x * m.m12 + y * m.m22 + ty;
+        if (bounds) {
+            if (i == 0) {
+                bounds[0] = bounds[2] = dest[0];
+                bounds[1] = bounds[3] = dest[1];
+            }
+            else {
+                bounds[0] = mgMin(bounds[0], dest[i * 2]);
+                bounds[1] = mgMin(bounds[1], dest[i * 2 + 1]);
+                bounds[2] = mgMax(bounds[2], dest[i * 2]);
+                bounds[3] = mgMax(bounds[3], dest[i * 2 + 1]);
+            }
+        }
+    }
+}
+
+void Matrix2d::TransformPoints(int count, const Point2d* points,
+                               Point2d* result, Box2d* box) const
+{
+    float bounds[4];
+
+    if (count < 1 || !points || !result) {
+        if (box)
+            box->empty();
+        return;
+    }
+    transformPairs(count, &points[0].x, &result[0].x, *this, true, box ? bounds : NULL);
+    if (box)
+        box->set(bounds[0], bounds[1], bounds[2], bounds[3]);
+}
+
+void Matrix2d::TransformVectors(int count, const Vector2d* vectors, Vector2d* result) const
+{
+    if (count > 0 && vectors && result)
+        transformPairs(count, &vectors[0].x, &result[0].x, *this, false, NULL);
 }
 
 // 矩阵乘法
@@ -0,0 +1,403 @@
+// mgrtree.cpp: 实现二维空间索引类 MgRTree
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include "mgrtree.h"
+#include <algorithm>
+#include <math.h>
+
+static const int kMaxEntries = 16;              // 每个节点的最大子项数
+static const int kMinEntries = kMaxEntries * 2 / 5;  // 每个节点的最小子项数
+
+struct MgRTree::Entry
+{
+    Box2d   box;
+    void*   ptr;                                // 叶节点中为对象，否则为子节点
+};
+
+struct MgRTree::Node
+{
+    int     level;                              // 0表示叶节点
+    int     count;
+    Entry   entries[kMaxEntries + 1];           // 多一个以便分裂前暂存
+
+    Node(int lv) : level(lv), count(0) {}
+
+    Box2d bound() const
+    {
+        Box2d box(entries[0].box);
+        for (int i = 1; i < count; i++)
+            box.unionWith(entries[i].box);
+        return box;
+    }
+};
+
+static inline bool overlaps(const Box2d& a, const Box2d& b)
+{
+    return a.xmin <= b.xmax && b.xmin <= a.xmax
+        && a.ymin <= b.ymax && b.ymin <= a.ymax;
+}
+
+static inline float area(const Box2d& box)
+{
+    return (box.xmax - box.xmin) * (box.ymax - box.ymin);
+}
+
+static inline Box2d unionOf(const Box2d& a, const Box2d& b)
+{
+    return Box2d(mgMin(a.xmin, b.xmin), mgMin(a.ymin, b.ymin),
+                 mgMax(a.xmax, b.xmax), mgMax(a.ymax, b.ymax));
+}
+
+MgRTree::MgRTree() : _root(NULL), _count(0)
+{
+}
+
+MgRTree::~MgRTree()
+{
+    clear();
+}
+
+void MgRTree::clear()
+{
+    if (_root) {
+        freeNode(_root, true);
+        _root = NULL;
+    }
+    _count = 0;
+}
+
+void MgRTree::freeNode(Node* node, bool freeChildren)
+{
+    if (freeChildren && node->level > 0) {
+        for (int i = 0; i < node->count; i++)
+            freeNode((Node*)node->entries[i].ptr, true);
+    }
+    delete node;
+}
+
+Box2d MgRTree::getExtent() const
+{
+    return (_root && _root->count > 0) ? _root->bound() : Box2d();
+}
+
+void MgRTree::insert(void* item, const Box2d& box)
+{
+    Entry entry;
+    entry.box = box;
+    entry.ptr = item;
+
+    if (!_root)
+        _root = new Node(0);
+    growRoot(insertAt(_root, entry, 0));
+    _count++;
+}
+
+void MgRTree::growRoot(Node* sibling)
+{
+    if (sibling) {
+        Node* root = new Node(_root->level + 1);
+
+        root->entries[0].box = _root->bound();
+        root->entries[0].ptr = _root;
+        root->entries[1].box = sibling->bound();
+        root->entries[1].ptr = sibling;
+        root->count = 2;
+        _root = root;
+    }
+}
+
+// 将子项插入到指定层次的节点中，如果节点分裂则返回新的兄弟节点
+MgRTree::Node* MgRTree::insertAt(Node* node, const Entry& entry, int level)
+{
+    if (node->level == level) {
+        node->entries[node->count++] = entry;
+    }
+    else {
+        int best = 0;
+        float bestGrow = _FLT_MAX;
+        float bestArea = _FLT_MAX;
+
+        for (int i = 0; i < node->count; i++) {     // 选择面积增长最小的子节点
+            float a = area(node->entries[i].box);
+            float grow = area(unionOf(node->entries[i].box, entry.box)) - a;
+
+            if (grow < bestGrow || (grow == bestGrow && a < bestArea)) {
+                bestGrow = grow;
+                bestArea = a;
+                best = i;
+            }
+        }
+
+        Entry& e = node->entries[best];
+        Node* sibling = insertAt((Node*)e.ptr, entry, level);
+
+        if (sibling) {
+            e.box = ((Node*)e.ptr)->bound();
+            node->entries[node->count].box = sibling->bound();
+            node->entries[node->count].ptr = sibling;
+            node->count++;
+        }
+        else {
+            e.box.unionWith(entry.box);
+        }
+    }
+
+    return node->count > kMaxEntries ? splitNode(node) : NULL;
+}
+
+// 二次分裂算法
+MgRTree::Node* MgRTree::splitNode(Node* node)
+{
+    Entry all[kMaxEntries + 1];
+    const int n = node->count;
+    int i, j, seed1 = 0, seed2 = 1;
+    float worst = -_FLT_MAX;
+
+    for (i = 0; i < n; i++)
+        all[i] = node->entries[i];
+
+    for (i = 0; i < n - 1; i++) {           // 选择合并后浪费面积最大的两项为种子
+        for (j = i + 1; j < n; j++) {
+            float d = area(unionOf(all[i].box, all[j].box))
+                - area(all[i].box) - area(all[j].box);
+            if (d > worst) {
+                worst = d;
+                seed1 = i;
+                seed2 = j;
+            }
+        }
+    }
+
+    Node* sibling = new Node(node->level);
+    bool assigned[kMaxEntries + 1] = { false };
+    Box2d box1(all[seed1].box);
+    Box2d box2(all[seed2].box);
+
+    node->count = 0;
+    node->entries[node->count++] = all[seed1];
+    sibling->entries[sibling->count++] = all[seed2];
+    assigned[seed1] = assigned[seed2] = true;
+
+    for (int remain = n - 2; remain > 0; remain--) {
+        if (node->count + remain == kMinEntries
+            || sibling->count + remain == kMinEntries)
+        {
+            Node* target = (node->count + remain == kMinEntries) ? node : sibling;
+            Box2d& tbox = (target == node) ? box1 : box2;
+
+            for (i = 0; i < n; i++) {       // 剩余项全部给不足最小数的节点
+                if (!assigned[i]) {
+                    assigned[i] = true;
+                    target->entries[target->count++] = all[i];
+                    tbox.unionWith(all[i].box);
+                }
+            }
+            break;
+        }
+
+        int next = -1;
+        float maxDiff = -1.f, d1 = 0, d2 = 0;
+
+        for (i = 0; i < n; i++) {           // 选择对两组偏好差别最大的项
+            if (!assigned[i]) {
+                float g1 = area(unionOf(box1, all[i].box)) - area(box1);
+                float g2 = area(unionOf(box2, all[i].box)) - area(box2);
+                float diff = (float)fabs(g1 - g2);
+
+                if (diff > maxDiff) {
+                    maxDiff = diff;
+                    next = i;
+                    d1 = g1;
+                    d2 = g2;
+                }
+            }
+        }
+
+        bool toFirst = d1 < d2 || (d1 == d2 && (area(box1) < area(box2)
+            || (area(box1) == area(box2) && node->count <= sibling->count)));
+
+        assigned[next] = true;
+        if (toFirst) {
+            node->entries[node->count++] = all[next];
+            box1.unionWith(all[next].box);
+        }
+        else {
+            sibling->entries[sibling->count++] = all[next];
+            box2.unionWith(all[next].box);
+        }
+    }
+
+    return sibling;
+}
+
+bool MgRTree::remove(void* item, const Box2d& box)
+{
+    std::vector<Node*> orphans;
+
+    if (!_root || !removeAt(_root, item, box, orphans))
+        return false;
+
+    _count--;
+    for (std::vector<Node*>::iterator it = orphans.begin(); it != orphans.end(); ++it)
+        reinsert(*it);
+
+    while (_root->level > 0 && _root->count == 1) {     // 降低树高
+        Node* child = (Node*)_root->entries[0].ptr;
+        delete _root;
+        _root = child;
+    }
+    if (0 == _count) {
+        clear();
+    }
+
+    return true;
+}
+
+bool MgRTree::removeAt(Node* node, void* item, const Box2d& box,
+                       std::vector<Node*>& orphans)
+{
+    int i;
+
+    if (0 == node->level) {
+        for (i = 0; i < node->count && node->entries[i].ptr != item; i++) ;
+        if (i == node->count)
+            return false;
+        node->entries[i] = node->entries[--node->count];
+        return true;
+    }
+
+    for (i = 0; i < node->count; i++) {
+        Entry& e = node->entries[i];
+        Node* child = (Node*)e.ptr;
+
+        if (overlaps(e.box, box) && removeAt(child, item, box, orphans)) {
+            if (child->count < kMinEntries) {   // 子节点不满，摘下后重新插入其子项
+                orphans.push_back(child);
+                node->entries[i] = node->entries[--node->count];
+            }
+            else {
+                e.box = child->bound();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MgRTree::reinsert(Node* node)
+{
+    for (int i = 0; i < node->count; i++)
+        growRoot(insertAt(_root, node->entries[i], node->level));
+    delete node;
+}
+
+// STR(Sort-Tile-Recursive)批量构造
+struct RTreeLessX {
+    template <class T> bool operator()(const T& a, const T& b) const {
+        return a.box.xmin + a.box.xmax < b.box.xmin + b.box.xmax;
+    }
+};
+struct RTreeLessY {
+    template <class T> bool operator()(const T& a, const T& b) const {
+        return a.box.ymin + a.box.ymax < b.box.ymin + b.box.ymax;
+    }
+};
+
+void MgRTree::load(UInt32 count, void* const* items, const Box2d* boxes)
+{
+    clear();
+    if (0 == count)
+        return;
+
+    std::vector<Entry> level(count);
+    int lv = 0;
+
+    for (UInt32 i = 0; i < count; i++) {
+        level[i].box = boxes[i];
+        level[i].ptr = items[i];
+    }
+
+    for (;;) {
+        const size_t n = level.size();
+        const size_t nodes = (n + kMaxEntries - 1) / kMaxEntries;
+        const size_t slices = (size_t)ceil(sqrt((double)nodes));
+        const size_t sliceSize = slices * kMaxEntries;
+        std::vector<Entry> upper;
+
+        std::sort(level.begin(), level.end(), RTreeLessX());
+        for (size_t s = 0; s < n; s += sliceSize) {
+            size_t send = mgMin(s + sliceSize, n);
+
+            std::sort(level.begin() + s, level.begin() + send, RTreeLessY());
+            for (size_t k = s; k < send; k += kMaxEntries) {
+                Node* node = new Node(lv);
+                size_t kend = mgMin(k + kMaxEntries, send);
+
+                for (size_t m = k; m < kend; m++)
+                    node->entries[node->count++] = level[m];
+
+                Entry e;
+                e.box = node->bound();
+                e.ptr = node;
+                upper.push_back(e);
+            }
+        }
+
+        lv++;
+        if (upper.size() == 1) {
+            _root = (Node*)upper[0].ptr;
+            break;
+        }
+        level.swap(upper);
+    }
+    _count = count;
+}
+
+UInt32 MgRTree::search(const Box2d& box, std::vector<void*>& items) const
+{
+    size_t n = items.size();
+
+    if (_root)
+        search(_root, box, items);
+
+    return (UInt32)(items.size() - n);
+}
+
+void MgRTree::search(const Node* node, const Box2d& box, std::vector<void*>& items) const
+{
+    for (int i = 0; i < node->count; i++) {
+        const Entry& e = node->entries[i];
+        if (overlaps(e.box, box)) {
+            if (0 == node->level)
+                items.push_back(e.ptr);
+            else
+                search((const Node*)e.ptr, box, items);
+        }
+    }
+}
+
+UInt32 MgRTree::search(const Box2d& box, Visitor& visitor) const
+{
+    return _root ? search(_root, box, visitor) : 0;
+}
+
+UInt32 MgRTree::search(const Node* node, const Box2d& box, Visitor& visitor) const
+{
+    UInt32 n = 0;
+
+    for (int i = 0; i < node->count; i++) {
+        const Entry& e = node->entries[i];
+        if (overlaps(e.box, box)) {
+            if (0 == node->level) {
+                visitor.found(e.ptr);
+                n++;
+            }
+            else
+                n += search((const Node*)e.ptr, box, visitor);
+        }
+    }
+
+    return n;
+}
@@ -0,0 +1,266 @@
+// gidlist.cpp: 实现显示列表类 GiDisplayList
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include "gidlist.h"
+#include "gigraph_.h"
+#include <mgrtree.h>
+#include <algorithm>
+
+static const size_t kTreeMinItems = 64;     // 项数较多时才用空间索引查找
+
+GiDisplayList::GiDisplayList() : _mat(-1), _itemOpen(false), _tree(NULL)
+{
+}
+
+GiDisplayList::~GiDisplayList()
+{
+    delete _tree;
+}
+
+void GiDisplayList::clear()
+{
+    _items.clear();
+    _prims.clear();
+    _points.clear();
+    _vecs.clear();
+    _types.clear();
+    _contexts.clear();
+    _matrices.clear();
+    _unbounded.clear();
+    _mat = -1;
+    _itemOpen = false;
+    delete _tree;
+    _tree = NULL;
+}
+
+void GiDisplayList::beginItem(const Box2d& box)
+{
+    Item item;
+
+    endItem();
+    item.box = box;
+    item.first = (UInt32)_prims.size();
+    item.count = 0;
+    _items.push_back(item);
+    _itemOpen = true;
+
+    delete _tree;                               // 项有变化，重放时重新构造索引
+    _tree = NULL;
+}
+
+bool GiDisplayList::endItem()
+{
+    if (!_itemOpen)
+        return false;
+
+    _itemOpen = false;
+    if (_items.back().count == 0) {             // 没有图元的项不保留
+        _items.pop_back();
+        return false;
+    }
+
+    return true;
+}
+
+UInt32 GiDisplayList::getItemCount() const
+{
+    return (UInt32)_items.size();
+}
+
+UInt32 GiDisplayList::getPrimitiveCount() const
+{
+    return (UInt32)_prims.size();
+}
+
+UInt32 GiDisplayList::getMemorySize() const
+{
+    return (UInt32)(_items.size() * sizeof(Item)
+        + _prims.size() * sizeof(Prim)
+        + _points.size() * sizeof(Point2d)
+        + _vecs.size() * sizeof(Vector2d)
+        + _types.size() * sizeof(UInt8)
+        + _contexts.size() * sizeof(GiContext)
+        + _matrices.size() * sizeof(Matrix2d));
+}
+
+bool GiDisplayList::addPrimitive(int type, const GiContext* ctx, bool modelUnit,
+                                 int count, const Point2d* pts,
+                                 const Vector2d* vecs, const UInt8* types)
+{
+    if (count < 1 || !pts)
+        return false;
+
+    if (!_itemOpen) {                           // 不在 beginItem() 之后，单独作为无包络框的一项
+        beginItem(Box2d());
+        _itemOpen = false;
+    }
+
+    Prim prim;
+
+    prim.type = (UInt8)type;
+    prim.modelUnit = modelUnit ? 1 : 0;
+    prim.ctx = -1;
+    if (ctx) {                                  // 相邻图元的绘图参数相同时共用
+        if (_contexts.empty() || _contexts.back() != *ctx)
+            _contexts.push_back(*ctx);
+        prim.ctx = (Int32)_contexts.size() - 1;
+    }
+    prim.mat = modelUnit ? _mat : -1;
+    prim.first = (UInt32)_points.size();
+    prim.count = (UInt32)count;
+    prim.extra = 0;
+    _points.insert(_points.end(), pts, pts + count);
+
+    if (vecs) {
+        prim.extra = (UInt32)_vecs.size();
+        _vecs.insert(_vecs.end(), vecs, vecs + count);
+    }
+    else if (types) {
+        prim.extra = (UInt32)_types.size();
+        _types.insert(_types.end(), types, types + count);
+    }
+
+    _prims.push_back(prim);
+    _items.back().count++;
+
+    return true;
+}
+
+void GiDisplayList::setModelTransform(const Matrix2d& mat)
+{
+    if (mat.isIdentity())
+        _mat = -1;
+    else {
+        if (_matrices.empty() || !(_matrices.back() == mat))
+            _matrices.push_back(mat);
+        _mat = (Int32)_matrices.size() - 1;
+    }
+}
+
+void GiDisplayList::buildIndex() const
+{
+    std::vector<void*> items;
+    std::vector<Box2d> boxes;
+
+    _unbounded.clear();
+    items.reserve(_items.size());
+    boxes.reserve(_items.size());
+
+    for (size_t i = 0; i < _items.size(); i++) {
+        void* item = const_cast<Item*>(&_items[i]);
+        if (_items[i].box.isEmpty())
+            _unbounded.push_back(item);
+        else {
+            items.push_back(item);
+            boxes.push_back(_items[i].box);
+        }
+    }
+
+    _tree = new MgRTree;
+    if (!items.empty())
+        _tree->load((UInt32)items.size(), &items.front(), &boxes.front());
+}
+
+// 收集空间索引找到的项
+struct ItemCollector : public MgRTree::Visitor
+{
+    void**  items;
+    int     count;
+
+    ItemCollector(void** buf) : items(buf), count(0) {}
+    void found(void* item) { items[count++] = item; }
+};
+
+int GiDisplayList::draw(GiGraphics& gs) const
+{
+    Box2d clip(gs.getClipModel());
+    int count = 0;
+
+    if (_items.size() < kTreeMinItems) {
+        for (size_t i = 0; i < _items.size(); i++) {
+            const Item& item = _items[i];
+            if ((item.box.isEmpty() || item.box.isIntersect(clip))
+                && drawItem(gs, item)) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    if (!_tree)
+        buildIndex();
+
+    // 从绘图临时缓冲区分配，显示图元时嵌套显示其他显示列表也不会相互覆盖
+    GiScratch<void*> found(gs._scratch(), (int)(_tree->getCount() + _unbounded.size()));
+    ItemCollector collector(found.get());
+
+    _tree->search(clip, collector);
+    for (size_t i = 0; i < _unbounded.size(); i++)
+        found[collector.count++] = _unbounded[i];
+    std::sort(found.get(), found.get() + collector.count);  // 项在数组中连续存放，按地址排序即为记录次序
+
+    for (int i = 0; i < collector.count; i++) {
+        if (drawItem(gs, *(const Item*)found[i]))
+            count++;
+    }
+
+    return count;
+}
+
+bool GiDisplayList::drawItem(GiGraphics& gs, const Item& item) const
+{
+    bool ret = false;
+
+    for (UInt32 i = 0; i < item.count; i++)
+        ret = drawPrim(gs, _prims[item.first + i]) || ret;
+
+    return ret;
+}
+
+bool GiDisplayList::drawPrim(GiGraphics& gs, const Prim& prim) const
+{
+    const GiContext* ctx = prim.ctx < 0 ? NULL : &_contexts[prim.ctx];
+    const Point2d* pts = &_points[prim.first];
+    int n = (int)prim.count;
+    bool mu = prim.modelUnit != 0;
+
+    if (prim.mat >= 0) {                        // 记录时临时改变了模型坐标系
+        GiSaveModelTransform xf(&gs.xf(), _matrices[prim.mat]);
+        Prim prim2(prim);
+        prim2.mat = -1;
+        return drawPrim(gs, prim2);
+    }
+
+    switch (prim.type)
+    {
+    case kLine:
+        return gs.drawLine(ctx, pts[0], pts[1], mu);
+    case kLines:
+        return gs.drawLines(ctx, n, pts, mu);
+    case kBeziers:
+        return gs.drawBeziers(ctx, n, pts, mu);
+    case kArc:      // 中心点、半径、起始角度和转角
+        return gs.drawArc(ctx, pts[0], pts[1].x, pts[1].y, pts[2].x, pts[2].y, mu);
+    case kPolygon:
+        return gs.drawPolygon(ctx, n, pts, mu);
+    case kEllipse:  // 中心点、半径
+        return gs.drawEllipse(ctx, pts[0], pts[1].x, pts[1].y, mu);
+    case kPie:      // 中心点、半径、起始角度和转角
+        return gs.drawPie(ctx, pts[0], pts[1].x, pts[1].y, pts[2].x, pts[2].y, mu);
+    case kRoundRect:    // 矩形的两个角点、圆角半径
+        return gs.drawRoundRect(ctx, Box2d(pts[0], pts[1]), pts[2].x, pts[2].y, mu);
+    case kSplines:
+        return gs.drawSplines(ctx, n, pts, &_vecs[prim.extra], mu);
+    case kClosedSplines:
+        return gs.drawClosedSplines(ctx, n, pts, &_vecs[prim.extra], mu);
+    case kBSplines:
+        return gs.drawBSplines(ctx, n, pts, mu);
+    case kClosedBSplines:
+        return gs.drawClosedBSplines(ctx, n, pts, mu);
+    case kPath:
+        return gs.drawPath(ctx, n, pts, &_types[prim.extra], mu);
+    }
+
+    return false;
+}
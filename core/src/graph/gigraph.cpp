@@ -55,7 +55,8 @@ void GiGraphics::_beginPaint(const RECT_2D& clipBox)
         m_impl->zoomChanged();
         m_impl->lastZoomTimes = xf().getZoomTimes();
     }
-    giInterlockedIncrement(&m_impl->drawRefcnt);
+    if (giInterlockedIncrement(&m_impl->drawRefcnt) == 1)
+        m_impl->scratch.reset();            // 复位绘图用的临时缓冲区
 
     if (!Box2d(clipBox).isEmpty())
     {
@@ -72,9 +73,39 @@ void GiGraphics::_beginPaint(const RECT_2D& clipBox)
 
 void GiGraphics::_endPaint()
 {
+    flushBatch();
     giInterlockedDecrement(&m_impl->drawRefcnt);
 }
 
+GiScratchArena& GiGraphics::_scratch()
+{
+    return m_impl->scratch;
+}
+
+bool GiGraphics::beginRecord(GiDisplayList* list)
+{
+    if (!list || m_impl->recorder)
+        return false;
+    m_impl->recorder = list;
+    m_impl->recordW2M = xf().worldToModel();
+    list->setModelTransform(Matrix2d::kIdentity());
+    return true;
+}
+
+void GiGraphics::endRecord()
+{
+    if (m_impl->recorder)
+    {
+        m_impl->recorder->endItem();
+        m_impl->recorder = NULL;
+    }
+}
+
+bool GiGraphics::isRecording() const
+{
+    return m_impl->recorder != NULL;
+}
+
 bool GiGraphics::isDrawing() const
 {
     return m_impl->drawRefcnt > 0;
@@ -87,6 +118,7 @@ bool GiGraphics::isPrint() const
 
 GiCanvas* GiGraphics::getCanvas()
 {
+    flushBatch();                           // 外部可能直接在画布上显示
     return m_impl->canvas;
 }
 
@@ -123,6 +155,7 @@ bool GiGraphics::setClipBox(const RECT_2D& rc)
             m_impl->rectDraw.inflate(GiGraphicsImpl::CLIP_INFLATE);
             m_impl->rectDrawM = m_impl->rectDraw * xf().displayToModel();
             m_impl->rectDrawW = m_impl->rectDrawM * xf().modelToWorld();
+            flushBatch();
             SafeCall(m_impl->canvas, _clipBoxChanged(m_impl->clipBox));
         }
         ret = true;
@@ -149,6 +182,7 @@ bool GiGraphics::setClipWorld(const Box2d& rectWorld)
                 m_impl->rectDraw.inflate(GiGraphicsImpl::CLIP_INFLATE);
                 m_impl->rectDrawM = m_impl->rectDraw * xf().displayToModel();
                 m_impl->rectDrawW = m_impl->rectDrawM * xf().modelToWorld();
+                flushBatch();
                 SafeCall(m_impl->canvas, _clipBoxChanged(m_impl->clipBox));
             }
 
@@ -159,6 +193,46 @@ bool GiGraphics::setClipWorld(const Box2d& rectWorld)
     return ret;
 }
 
+void GiGraphics::addDirtyWorld(const Box2d& rectWorld)
+{
+    if (!rectWorld.isEmpty())
+        m_impl->rectDirtyW.unionWith(rectWorld);
+}
+
+Box2d GiGraphics::getDirtyWorld() const
+{
+    return m_impl->rectDirtyW;
+}
+
+bool GiGraphics::beginDirtyDraw()
+{
+    if (!isDrawing() || m_impl->dirtyDrawing || m_impl->rectDirtyW.isEmpty())
+        return false;
+
+    Box2d rectWorld (m_impl->rectDirtyW);
+
+    m_impl->rectDirtyW.empty();
+    getClipBox(m_impl->clipBoxDirty);
+    if (!setClipWorld(rectWorld))           // 不在显示范围内
+        return false;
+
+    m_impl->dirtyDrawing = true;
+    SafeCall(m_impl->canvas, clearWindow());
+
+    return true;
+}
+
+void GiGraphics::endDirtyDraw()
+{
+    if (m_impl->dirtyDrawing)
+    {
+        m_impl->dirtyDrawing = false;
+        setClipBox(m_impl->clipBoxDirty);
+        flushBatch();
+        SafeCall(m_impl->canvas, saveCachedBitmap());
+    }
+}
+
 bool GiGraphics::isAntiAliasMode() const
 {
     return m_impl->antiAlias;
@@ -167,11 +241,36 @@ bool GiGraphics::isAntiAliasMode() const
 bool GiGraphics::setAntiAliasMode(bool antiAlias)
 {
     bool old = m_impl->antiAlias;
+    flushBatch();
     m_impl->antiAlias = antiAlias;
     SafeCall(m_impl->canvas, _antiAliasModeChanged(antiAlias));
     return old;
 }
 
+bool GiGraphics::isBatchMode() const
+{
+    return m_impl->batchMode;
+}
+
+bool GiGraphics::setBatchMode(bool batch)
+{
+    bool old = m_impl->batchMode;
+    flushBatch();
+    m_impl->batchMode = batch;
+    m_impl->hasLastCtx = false;
+    return old;
+}
+
+const GiBatchStats& GiGraphics::getBatchStats() const
+{
+    return m_impl->batchStats;
+}
+
+void GiGraphics::resetBatchStats()
+{
+    m_impl->batchStats = GiBatchStats();
+}
+
 int GiGraphics::getColorMode() const
 {
     return m_impl->colorMode;
@@ -267,10 +366,25 @@ static inline const Box2d& DRAW_MAXR(const GiGraphicsImpl* p, bool modelUnit)
     return modelUnit ? p->rectDrawMaxM : p->rectDrawMaxW;
 }
 
+// 记录一个图元到显示列表，记下记录时临时改变的模型坐标系
+static bool RECORD(GiGraphicsImpl* p, int type, const GiContext* ctx, bool modelUnit,
+                   int count, const Point2d* pts,
+                   const Vector2d* vecs = NULL, const UInt8* types = NULL)
+{
+    if (modelUnit)
+        p->recorder->setModelTransform(p->recordW2M * p->xform->modelToWorld());
+    return p->recorder->addPrimitive(type, ctx, modelUnit, count, pts, vecs, types);
+}
+
 bool GiGraphics::drawLine(const GiContext* ctx, 
                           const Point2d& startPt, const Point2d& endPt, 
                           bool modelUnit)
 {
+    if (m_impl->recorder)
+    {
+        Point2d pts[2] = { startPt, endPt };
+        return RECORD(m_impl, GiDisplayList::kLine, ctx, modelUnit, 2, pts);
+    }
     if (m_impl->drawRefcnt == 0)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
@@ -286,194 +400,263 @@ bool GiGraphics::drawLine(const GiContext* ctx,
     return rawLine(ctx, pts[0].x, pts[0].y, pts[1].x, pts[1].y);
 }
 
-//! 折线绘制辅助类，用于将显示与环境设置分离
+//! 折线或Bezier曲线的输出辅助类，用于将显示与环境设置分离
+/*! 一段连续的线的点数不超过缓冲区容量时直接输出，否则累积为一个路径后输出，
+    以免线型和拐角在分块处重新开始。
+*/
 class PolylineAux
 {
-    GiGraphics* m_gs;
-    const GiContext* m_pContext;
+    GiGraphics*         m_gs;
+    const GiContext*    m_pContext;
+    Point2d*            m_pxs;          // 缓冲区
+    int                 m_maxn;         // 缓冲区容量，Bezier曲线时至少为4
+    int                 m_n;            // 缓冲区中的点数
+    bool                m_beziers;      // 是否为Bezier曲线
+    bool                m_path;         // 是否已开始路径
+    bool                m_ret;
 public:
-    PolylineAux(GiGraphics* gs, const GiContext* ctx)
-        : m_gs(gs), m_pContext(ctx)
+    PolylineAux(GiGraphics* gs, const GiContext* ctx, Point2d* buf, int maxn, 
+                bool beziers = false)
+        : m_gs(gs), m_pContext(ctx), m_pxs(buf), m_maxn(maxn), m_n(0)
+        , m_beziers(beziers), m_path(false), m_ret(false)
     {
     }
-    bool draw(const Point2d* pxs, int n) const
+
+    //! 返回是否没有正在收集的线
+    bool empty() const
     {
-        return pxs && n > 1 && m_gs->rawLines(m_pContext, pxs, n);
+        return m_n == 0 && !m_path;
     }
-};
 
-static bool DrawEdge(int count, int &i, Point2d* pts, Point2d &ptLast, 
-                     const PolylineAux& aux, const Box2d& rectDraw)
-{
-    int n, si, ei;
-    Point2d pt1, pt2;
+    //! 结束上一段线，从给定点开始新的一段
+    void moveTo(const Point2d& pt)
+    {
+        end();
+        m_pxs[m_n++] = pt;
+    }
 
-    pt1 = ptLast;
-    ptLast = pts[i+1];
-    pt2 = ptLast;
-    if (!mgClipLine(pt1, pt2, rectDraw))    // 该边不可见
-        return false;
+    //! 折线添加一点，与上一点重合时跳过
+    void lineTo(const Point2d& pt)
+    {
+        const Point2d& last = m_pxs[m_n - 1];
+        if (fabs(last.x - pt.x) > 2 || fabs(last.y - pt.y) > 2)
+        {
+            if (m_n == m_maxn)
+                flush();
+            m_pxs[m_n++] = pt;
+        }
+    }
 
-    si = i;                                 // 收集第一条可见边
-    ei = i+1;
-    pts[i] = pt1;                           // 收集起点
-    if (pt2 != ptLast)                      // 如果该边终点不可见
+    //! Bezier曲线添加一段的后三个控制点
+    void bezierTo(const Point2d* pxs)
     {
-        pts[i+1] = pt2;                     // 收集交点
+        if (m_n + 3 > m_maxn)
+            flush();
+        m_pxs[m_n++] = pxs[0];
+        m_pxs[m_n++] = pxs[1];
+        m_pxs[m_n++] = pxs[2];
     }
-    else                                    // 否则继续收集后续点
+
+    //! 输出正在收集的线，返回是否显示了内容
+    bool end()
     {
-        i++;                                // 下一边的起点可见，跳过
-        for (; i < count - 1; i++)          // 依次处理后续可见边
+        if (m_path)
         {
-            pt1 = ptLast;
-            ptLast = pts[i+1];
-            pt2 = ptLast;
-            if (!mgClipLine(pt1, pt2, rectDraw)) // 该边不可见
-                break;
-            ei++;
-            if (pt2 != ptLast)              // 该边起点可见，终点不可见
-            {
-                pts[i+1] = pt2;             // 收集交点
-                break;
-            }
+            flush();
+            m_ret = m_gs->rawEndPath(m_pContext, false) || m_ret;
+            m_path = false;
         }
+        else if (m_n > 1)
+        {
+            m_ret = (m_beziers ? m_gs->rawBeziers(m_pContext, m_pxs, m_n)
+                     : m_gs->rawLines(m_pContext, m_pxs, m_n)) || m_ret;
+        }
+        m_n = 0;
+        return m_ret;
     }
 
-    // 显示找到的多条线段
-    n = ei - si + 1;
-    if (n > 1)
+private:
+    // 缓冲区已满时累积到路径中，保留最后一点以便接续
+    void flush()
     {
-        vector<Point2d> pxpoints;
-        pxpoints.resize(n);
-        Point2d* pxs = &pxpoints.front();
-        n = 0;
-        for (int j = si; j <= ei; j++)
+        if (!m_path)
         {
-            // 记下第一个点，其他点如果和上一点不重合则记下，否则跳过
-            if (j == si || fabs(pt1.x - pts[j].x) > 2
-                || fabs(pt1.y - pts[j].y) > 2)
-            {
-                pt1 = pts[j];
-                pxs[n++] = pt1;
-            }
+            m_path = true;
+            m_gs->rawBeginPath();
+            m_gs->rawMoveTo(m_pxs[0].x, m_pxs[0].y);
+        }
+        if (m_beziers)
+        {
+            m_gs->rawBezierTo(m_pxs + 1, m_n - 1);
         }
+        else
+        {
+            for (int i = 1; i < m_n; i++)
+                m_gs->rawLineTo(m_pxs[i].x, m_pxs[i].y);
+        }
+        m_pxs[0] = m_pxs[m_n - 1];
+        m_n = 1;
+    }
+};
 
-        return aux.draw(pxs, n);
+static const int kChunkEdges = 64;          // 折线按块检查可见性的边数
+static const int kMaxChunkPoints = 0x2000;  // 分块转换和输出到画布的最多点数
+static const int kMaxChunkSegs = (kMaxChunkPoints - 1) / 3; // 每块最多的Bezier段数
+
+// 剪裁一条边，可见部分接续到正在收集的线，或开始新的一段线
+static void DrawEdge(PolylineAux& aux, const Point2d& from, const Point2d& to, 
+                     const Box2d& rectDraw)
+{
+    Point2d pt1 (from);
+    Point2d pt2 (to);
+
+    if (!mgClipLine(pt1, pt2, rectDraw))    // 该边不可见
+    {
+        aux.end();
+        return;
     }
+    if (aux.empty() || pt1 != from)         // 该边起点不可见，收集交点
+        aux.moveTo(pt1);
+    aux.lineTo(pt2);
+    if (pt2 != to)                          // 该边终点不可见，结束本段线
+        aux.end();
+}
 
-    return false;
+// 按块检查模型坐标范围，只转换和剪裁与显示区域相交的连续多块，可见的连续边输出为一段线
+static bool DrawClippedLines(PolylineAux& aux, const Box2d& rectM, const Box2d& rectDraw, 
+                             const Matrix2d& matD, int count, const Point2d* points, 
+                             Point2d* pts, bool closed)
+{
+    int i, si, ei, ei2;
+
+    for (si = 0; si < count - 1; si = ei)
+    {
+        ei = mgMin(si + kChunkEdges, count - 1);    // 本块为第si到ei点
+        if (!rectM.isIntersect(Box2d(ei - si + 1, points + si)))
+        {
+            aux.end();                          // 本块全部不可见
+            continue;
+        }
+        while (ei < count - 1)                  // 合并后续可见块，总点数有上限
+        {
+            ei2 = mgMin(ei + kChunkEdges, count - 1);
+            if (ei2 - si >= kMaxChunkPoints
+                || !rectM.isIntersect(Box2d(ei2 - ei + 1, points + ei)))
+                break;
+            ei = ei2;
+        }
+
+        matD.TransformPoints(ei - si + 1, points + si, pts);   // 转换到像素坐标
+        for (i = 0; i < ei - si; i++)
+            DrawEdge(aux, pts[i], pts[i + 1], rectDraw);
+    }
+    if (closed)                                 // 多边形的闭合边
+        DrawEdge(aux, points[count - 1] * matD, points[0] * matD, rectDraw);
+
+    return aux.end();
 }
 
 bool GiGraphics::drawLines(const GiContext* ctx, int count, 
                            const Point2d* points, bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 1 && RECORD(m_impl,
+            GiDisplayList::kLines, ctx, modelUnit, count, points);
     if (m_impl->drawRefcnt == 0 || count < 2 || points == NULL)
         return false;
-    if (count > 0x2000)
-        count = 0x2000;
     GiLock lock (&m_impl->drawRefcnt);
 
-    int i;
-    Point2d pt1, pt2, ptLast;
-    vector<Point2d> pxpoints;
-    vector<Point2d> pointBuf;
-    bool ret = false;
+    int i, si, n;
     Matrix2d matD(S2D(xf(), modelUnit));
 
     const Box2d extent (count, points);                 // 模型坐标范围
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(extent))  // 全部在显示区域外
         return false;
 
-    if (DRAW_MAXR(m_impl, modelUnit).contains(extent))  // 全部在显示区域内
+    int maxn = mgMin(count, kMaxChunkPoints);
+    GiScratch<Point2d> pointBuf (m_impl->scratch, maxn);
+    GiScratch<Point2d> lineBuf (m_impl->scratch, maxn);
+    PolylineAux aux(this, ctx, lineBuf.get(), maxn);
+
+    if (!DRAW_MAXR(m_impl, modelUnit).contains(extent)) // 部分在显示区域内
     {
-        pxpoints.resize(count);
-        Point2d* pxs = &pxpoints.front();
-        int n = 0;
-        for (i = 0; i < count; i++)
-        {
-            pt2 = points[i] * matD;
-            if (i == 0 || fabs(pt1.x - pt2.x) > 2 || fabs(pt1.y - pt2.y) > 2)
-            {
-                pt1 = pt2;
-                pxs[n++] = pt2;
-            }
-        }
-        ret = rawLines(ctx, pxs, n);
+        return DrawClippedLines(aux, DRAW_RECT(m_impl, modelUnit), m_impl->rectDraw, 
+            matD, count, points, pointBuf.get(), false);
     }
-    else                                            // 部分在显示区域内
-    {
-        pointBuf.resize(count);
-        for (i = 0; i < count; i++)                 // 转换到像素坐标
-            pointBuf[i] = points[i] * matD;
-        Point2d* pts = &pointBuf.front();
 
-        ptLast = pts[0];
-        PolylineAux aux(this, ctx);
-        for (i = 0; i < count - 1; i++)
+    // 全部在显示区域内，点数多时分块转换，连续收集到一段线中
+    Point2d* pxs = pointBuf.get();
+
+    for (si = 0; si < count; si += n)
+    {
+        n = mgMin(count - si, kMaxChunkPoints);
+        matD.TransformPoints(n, points + si, pxs);
+        for (i = 0; i < n; i++)
         {
-            ret = DrawEdge(count, i, pts, ptLast, aux, m_impl->rectDraw) || ret;
+            if (si + i == 0)
+                aux.moveTo(pxs[i]);
+            else
+                aux.lineTo(pxs[i]);
         }
     }
 
-    return ret;
+    return aux.end();
 }
 
 bool GiGraphics::drawBeziers(const GiContext* ctx, int count, 
                              const Point2d* points, bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 3 && RECORD(m_impl,
+            GiDisplayList::kBeziers, ctx, modelUnit, count, points);
     if (m_impl->drawRefcnt == 0 || count < 4 || points == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    if (count > 0x2000)
-        count = 0x2000;
     count = 1 + (count - 1) / 3 * 3;
 
-    bool ret = false;
-    vector<Point2d> pxpoints;
-    vector<Point2d> pointBuf;
-    int i, j, n, si, ei;
-    Point2d * pxs;
+    int i, n, si, ei;
     Matrix2d matD(S2D(xf(), modelUnit));
 
     const Box2d extent (count, points);                 // 模型坐标范围
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(extent))  // 全部在显示区域外
         return false;
 
-    if (DRAW_MAXR(m_impl, modelUnit).contains(extent))  // 全部在显示区域内
+    // 点数多时按整段分块转换，相邻块共用一个端点
+    int maxn = 1 + mgMin((count - 1) / 3, kMaxChunkSegs) * 3;
+    GiScratch<Point2d> pxpoints (m_impl->scratch, maxn);
+    Point2d* pts = pxpoints.get();
+    bool inside = DRAW_MAXR(m_impl, modelUnit).contains(extent);
+
+    if (inside && count == maxn)                        // 全部在显示区域内且不用分块
     {
-        pxpoints.resize(count);
-        pxs = &pxpoints.front();
-        for (i = 0; i < count; i++)
-            pxs[i] = points[i] * matD;
-        ret = rawBeziers(ctx, pxs, count);
+        matD.TransformPoints(count, points, pts);
+        return rawBeziers(ctx, pts, count);
     }
-    else
-    {        
-        pointBuf.resize(count);
-        for (i = 0; i < count; i++)                 // 转换到像素坐标
-            pointBuf[i] = points[i] * matD;
-        Point2d* pts = &pointBuf.front();
-
-        si = ei = 0;
-        for (i = 3; i < count; i += 3)
+
+    // 可见的连续曲线段收集为一段曲线，跨块时累积为一个路径
+    GiScratch<Point2d> curveBuf (m_impl->scratch, maxn);
+    PolylineAux aux(this, ctx, curveBuf.get(), maxn, true);
+
+    for (si = 0; si < count - 1; si = ei)
+    {
+        ei = mgMin(si + kMaxChunkSegs * 3, count - 1);
+        n = ei - si + 1;
+        matD.TransformPoints(n, points + si, pts);  // 转换到像素坐标
+
+        for (i = 0; i < n - 1; i += 3)
         {
-            for ( ; i < count
-                && m_impl->rectDraw.isIntersect(Box2d(4, &pts[ei])); i += 3)
-                ei = i;
-            n = ei - si + 1;
-            if (n > 1)
+            if (!inside && !m_impl->rectDraw.isIntersect(Box2d(4, pts + i)))
             {
-                pxpoints.resize(n);
-                pxs = &pxpoints.front();
-                for (j=0; j<n; j++)
-                    pxs[j] = pts[si + j];
-                ret = rawBeziers(ctx, pxs, n);
+                aux.end();                          // 该段不可见
+                continue;
             }
-            si = ei = i;
+            if (aux.empty())
+                aux.moveTo(pts[i]);
+            aux.bezierTo(pts + i + 1);
         }
     }
-    return ret;
+
+    return aux.end();
 }
 
 bool GiGraphics::drawArc(const GiContext* ctx, 
@@ -481,6 +664,11 @@ bool GiGraphics::drawArc(const GiContext* ctx,
                          float startAngle, float sweepAngle, 
                          bool modelUnit)
 {
+    if (m_impl->recorder)
+    {
+        Point2d pts[3] = { center, Point2d(rx, ry), Point2d(startAngle, sweepAngle) };
+        return RECORD(m_impl, GiDisplayList::kArc, ctx, modelUnit, 3, pts);
+    }
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO || fabs(sweepAngle) < 1e-5f)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
@@ -518,45 +706,224 @@ static inline int findInvisibleEdge(const PolygonClip& clip, int i, int end)
     return i;
 }
 
-static bool drawPolygonEdge(const PolylineAux& aux, 
-                            int count, const PolygonClip& clip, 
-                            int ienter)
+static bool drawPolygonEdge(GiScratchArena& scratch, GiGraphics* gs, 
+                            const GiContext* ctx, int count, 
+                            const PolygonClip& clip, int ienter)
 {
-    bool ret = false;
-    vector<Point2d> pxpoints;
-    Point2d pt1, pt2;
-    int si, ei, n, i;
+    int maxn = mgMin(count + 1, kMaxChunkPoints);
+    GiScratch<Point2d> pxpoints (scratch, maxn);
+    PolylineAux aux(gs, ctx, pxpoints.get(), maxn);
+    int si, ei, i;
 
     for (si = ei = ienter + 1; (ei - ienter) % count != 0; )
     {
         si = findVisibleEdge(clip, ei, ienter);
         ei = findInvisibleEdge(clip, si, ienter);
-        n = ei - si + 1;
-        if (n > 1)
+        if (ei > si)
         {
-            pxpoints.resize(n);
-            Point2d *pxs = &pxpoints.front();
-            n = 0;
-            for (i = si; i <= ei; i++)
-            {
-                pt2 = clip.getPoint(i);
-                if (i == si || fabs(pt1.x - pt2.x) > 2
-                    || fabs(pt1.y - pt2.y) > 2)
-                {
-                    pt1 = pt2;
-                    pxs[n++] = pt1;
-                }
-            }
+            aux.moveTo(clip.getPoint(si));
+            for (i = si + 1; i <= ei; i++)
+                aux.lineTo(clip.getPoint(i));
+            aux.end();
+        }
+    }
+
+    return aux.end();
+}
+
+//! 逐点剪裁多边形的辅助类，用于点数多的多边形
+/*! 依次按剪裁矩形的左、上、右、下边剪裁，每级只记下首点和上一点，
+    剪裁结果去掉重合点后累积到路径中，不需要与点数成正比的剪裁缓冲区。
+*/
+class PolygonClipPath
+{
+    GiGraphics*     m_gs;
+    const Box2d     m_rect;             // 剪裁矩形
+    Point2d         m_first[4];         // 每级剪裁的首点
+    Point2d         m_last[4];          // 每级剪裁的上一点
+    bool            m_started[4];       // 每级剪裁是否已有首点
+    Point2d         m_out;              // 上一个输出点
+    int             m_n;                // 输出点数
+public:
+    PolygonClipPath(GiGraphics* gs, const Box2d& rect) : m_gs(gs), m_rect(rect), m_n(0)
+    {
+        for (int k = 0; k < 4; k++)
+            m_started[k] = false;
+    }
+
+    //! 添加一个顶点(像素坐标)
+    void addPoint(const Point2d& pt)
+    {
+        add(0, pt);
+    }
+
+    //! 处理各级的闭合边，结束路径并填充
+    bool end(const GiContext* ctx)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            if (m_started[k])
+                clipEdge(k, m_last[k], m_first[k]);
+        }
+        m_gs->rawClosePath();
+        return m_gs->rawEndPath(ctx, true) && m_n > 2;
+    }
+
+private:
+    bool inside(int k, const Point2d& pt) const
+    {
+        switch (k)
+        {
+        case 0: return pt.x >= m_rect.xmin;
+        case 1: return pt.y <= m_rect.ymax;
+        case 2: return pt.x <= m_rect.xmax;
+        default: return pt.y >= m_rect.ymin;
+        }
+    }
 
-            ret = aux.draw(pxs, n) || ret;
+    Point2d cross(int k, const Point2d& a, const Point2d& b) const
+    {
+        if (k % 2 == 0)
+        {
+            float x = (k == 0) ? m_rect.xmin : m_rect.xmax;
+            return Point2d(x, a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x));
         }
+        float y = (k == 1) ? m_rect.ymax : m_rect.ymin;
+        return Point2d(a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y);
+    }
+
+    void add(int k, const Point2d& pt)
+    {
+        if (k == 4)
+        {
+            output(pt);
+            return;
+        }
+        if (m_started[k])
+        {
+            clipEdge(k, m_last[k], pt);
+        }
+        else
+        {
+            m_started[k] = true;
+            m_first[k] = pt;
+        }
+        m_last[k] = pt;
+    }
+
+    void clipEdge(int k, const Point2d& a, const Point2d& b)
+    {
+        bool ina = inside(k, a);
+        bool inb = inside(k, b);
+
+        if (ina != inb)                         // 边与剪裁边相交，输出交点
+            add(k + 1, cross(k, a, b));
+        if (inb)                                // 终点在剪裁边内侧，输出终点
+            add(k + 1, b);
+    }
+
+    void output(const Point2d& pt)
+    {
+        if (m_n == 0)
+        {
+            m_gs->rawMoveTo(pt.x, pt.y);
+        }
+        else if (fabs(m_out.x - pt.x) > 2 || fabs(m_out.y - pt.y) > 2)
+        {
+            m_gs->rawLineTo(pt.x, pt.y);
+        }
+        else
+        {
+            return;
+        }
+        m_out = pt;
+        m_n++;
+    }
+};
+
+// 点数多且部分可见的多边形，填充区域逐点剪裁，边线按折线剪裁，缓冲区不随点数增大
+static bool DrawClippedPolygon(GiGraphics* gs, GiGraphicsImpl* p, const GiContext* ctx, 
+                               int count, const Point2d* points, const Box2d& rectM, 
+                               const Matrix2d& matD)
+{
+    GiScratch<Point2d> pxpoints (p->scratch, kMaxChunkPoints);
+    Point2d* pxs = pxpoints.get();
+    bool ret = false;
+    int si, n, i;
+
+    if (ctx->hasFillColor() && gs->rawBeginPath())
+    {
+        GiContext context (*ctx);
+        PolygonClipPath clip (gs, p->rectDraw);
+
+        context.setNullLine();
+        for (si = 0; si < count; si += n)
+        {
+            n = mgMin(count - si, kMaxChunkPoints);
+            matD.TransformPoints(n, points + si, pxs);
+            for (i = 0; i < n; i++)
+                clip.addPoint(pxs[i]);
+        }
+        ret = clip.end(&context);
+    }
+    if (!ctx->isNullLine())
+    {
+        GiContext context (*ctx);
+        GiScratch<Point2d> lineBuf (p->scratch, kMaxChunkPoints);
+        PolylineAux aux(gs, &context, lineBuf.get(), kMaxChunkPoints);
+
+        context.setNoFillColor();
+        ret = DrawClippedLines(aux, rectM, p->rectDraw, matD, 
+            count, points, pxs, true) || ret;
     }
 
     return ret;
 }
 
-static bool _DrawPolygon(GiCanvas* cv, const GiContext* ctx, 
-                         int count, const Point2d* points, 
+// 点数多的多边形分块转换和去掉重合点，累积为一个闭合路径后显示
+static bool drawPolygonPath(GiScratchArena& scratch, GiCanvas* cv, 
+                            const GiContext* ctx, int count, 
+                            const Point2d* points, const Matrix2d* matD)
+{
+    GiScratch<Point2d> pxpoints (scratch, matD ? mgMin(count, kMaxChunkPoints) : 0);
+    GiGraphics* gs = cv->owner2();          // 经过 GiGraphics 输出，以便批量提交
+    Point2d pt1, pt2;
+    int si, n, i;
+
+    if (!gs->rawBeginPath())
+        return false;
+
+    for (si = 0; si < count; si += n)
+    {
+        n = mgMin(count - si, kMaxChunkPoints);
+        const Point2d* pxs = points + si;
+        if (matD)
+        {
+            matD->TransformPoints(n, pxs, pxpoints.get());
+            pxs = pxpoints.get();
+        }
+        for (i = 0; i < n; i++)
+        {
+            pt2 = pxs[i];
+            if (si + i == 0)
+            {
+                pt1 = pt2;
+                gs->rawMoveTo(pt1.x, pt1.y);
+            }
+            else if (fabs(pt1.x - pt2.x) > 2 || fabs(pt1.y - pt2.y) > 2)
+            {
+                pt1 = pt2;
+                gs->rawLineTo(pt1.x, pt1.y);
+            }
+        }
+    }
+    gs->rawClosePath();
+
+    return gs->rawEndPath(ctx, true);
+}
+
+static bool _DrawPolygon(GiScratchArena& scratch, GiCanvas* cv, 
+                         const GiContext* ctx, int count, const Point2d* points, 
                          bool bM2D, bool bFill, bool bEdge, bool modelUnit)
 {
     if (!ctx && cv)
@@ -573,18 +940,27 @@ static bool _DrawPolygon(GiCanvas* cv, const GiContext* ctx,
     if (context.isNullLine() && !context.hasFillColor())
         return false;
 
-    vector<Point2d> pxpoints;
+    GiGraphics* gs = cv->owner2();          // 经过 GiGraphics 输出，以便批量提交
     Point2d pt1, pt2;
-    Matrix2d matD(S2D(cv->owner()->xf(), modelUnit));
+    Matrix2d matD(S2D(gs->xf(), modelUnit));
 
-    pxpoints.resize(count);
-    Point2d *pxs = &pxpoints.front();
+    if (count > kMaxChunkPoints)
+    {
+        return drawPolygonPath(scratch, cv, &context, 
+            count, points, bM2D ? &matD : NULL);
+    }
+
+    GiScratch<Point2d> pxpoints (scratch, count);
+    Point2d *pxs = pxpoints.get();
     int n = 0;
+    if (bM2D)
+    {
+        matD.TransformPoints(count, points, pxs);
+        points = pxs;
+    }
     for (int i = 0; i < count; i++)
     {
         pt2 = points[i];
-        if (bM2D)
-            pt2 *= matD;
         if (i == 0 || fabs(pt1.x - pt2.x) > 2
             || fabs(pt1.y - pt2.y) > 2)
         {
@@ -596,21 +972,22 @@ static bool _DrawPolygon(GiCanvas* cv, const GiContext* ctx,
     if (n == 4 && mgIsZero(pxs[0].x - pxs[3].x) && mgIsZero(pxs[1].x - pxs[2].x)
         && mgIsZero(pxs[0].y - pxs[1].y) && mgIsZero(pxs[2].y - pxs[3].y))
     {
-        return cv->rawRect(&context, pxs[0].x, pxs[0].y, 
+        return gs->rawRect(&context, pxs[0].x, pxs[0].y, 
             pxs[2].x - pxs[0].x, pxs[2].y - pxs[0].y);
     }
 
-    return cv->rawPolygon(&context, pxs, n);
+    return gs->rawPolygon(&context, pxs, n);
 }
 
 bool GiGraphics::drawPolygon(const GiContext* ctx, int count, 
                              const Point2d* points, bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 1 && RECORD(m_impl,
+            GiDisplayList::kPolygon, ctx, modelUnit, count, points);
     if (m_impl->drawRefcnt == 0 || count < 2 || points == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    if (count > 0x2000)
-        count = 0x2000;
 
     bool ret = false;
 
@@ -620,29 +997,40 @@ bool GiGraphics::drawPolygon(const GiContext* ctx, int count,
 
     if (DRAW_MAXR(m_impl, modelUnit).contains(extent))  // 全部在显示区域内
     {
-        ret = _DrawPolygon(m_impl->canvas, ctx, 
+        ret = _DrawPolygon(m_impl->scratch, m_impl->canvas, ctx, 
             count, points, true, true, true, modelUnit);
     }
+    else if (count > kMaxChunkPoints)                   // 部分在显示区域内，点数多
+    {
+        if (!ctx && m_impl->canvas)
+            ctx = m_impl->canvas->getCurrentContext();
+        if (ctx)
+        {
+            ret = DrawClippedPolygon(this, m_impl, ctx, count, points, 
+                DRAW_RECT(m_impl, modelUnit), S2D(xf(), modelUnit));
+        }
+    }
     else                                                // 部分在显示区域内
     {
-        PolygonClip clip (m_impl->rectDraw);
+        PolygonClip clip (m_impl->rectDraw, m_impl->clipBuf1, m_impl->clipBuf2);
         if (!clip.clip(count, points, &S2D(xf(), modelUnit)))  // 多边形剪裁
             return false;
         count = clip.getCount();
         points = clip.getPoints();
 
-        ret = _DrawPolygon(m_impl->canvas, ctx, 
+        ret = _DrawPolygon(m_impl->scratch, m_impl->canvas, ctx, 
             count, points, false, true, false, modelUnit);
 
         int ienter = findInvisibleEdge(clip);
         if (ienter == count)
         {
-            ret = _DrawPolygon(m_impl->canvas, ctx, count, points, 
-                false, false, true, modelUnit) || ret;
+            ret = _DrawPolygon(m_impl->scratch, m_impl->canvas, ctx, 
+                count, points, false, false, true, modelUnit) || ret;
         }
         else
         {
-            ret = drawPolygonEdge(PolylineAux(this, ctx), count, clip, ienter) || ret;
+            ret = drawPolygonEdge(m_impl->scratch, this, ctx, 
+                count, clip, ienter) || ret;
         }
     }
 
@@ -657,6 +1045,11 @@ bool GiGraphics::drawEllipse(const GiContext* ctx, const Box2d& rect, bool model
 bool GiGraphics::drawEllipse(const GiContext* ctx, const Point2d& center, 
                              float rx, float ry, bool modelUnit)
 {
+    if (m_impl->recorder)
+    {
+        Point2d pts[2] = { center, Point2d(rx, ry) };
+        return RECORD(m_impl, GiDisplayList::kEllipse, ctx, modelUnit, 2, pts);
+    }
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
@@ -702,6 +1095,11 @@ bool GiGraphics::drawPie(const GiContext* ctx,
                          float startAngle, float sweepAngle, 
                          bool modelUnit)
 {
+    if (m_impl->recorder)
+    {
+        Point2d pts[3] = { center, Point2d(rx, ry), Point2d(startAngle, sweepAngle) };
+        return RECORD(m_impl, GiDisplayList::kPie, ctx, modelUnit, 3, pts);
+    }
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO || fabs(sweepAngle) < 1e-5f)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
@@ -748,6 +1146,11 @@ bool GiGraphics::drawRoundRect(const GiContext* ctx,
                                const Box2d& rect, float rx, float ry, 
                                bool modelUnit)
 {
+    if (m_impl->recorder)
+    {
+        Point2d pts[3] = { rect.leftBottom(), rect.rightTop(), Point2d(rx, ry) };
+        return RECORD(m_impl, GiDisplayList::kRoundRect, ctx, modelUnit, 3, pts);
+    }
     if (m_impl->drawRefcnt == 0 || rect.isEmpty())
         return false;
     GiLock lock (&m_impl->drawRefcnt);
@@ -801,36 +1204,66 @@ bool GiGraphics::drawSplines(const GiContext* ctx, int count,
                              const Point2d* knots, 
                              const Vector2d* knotvs, bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 1 && knotvs && RECORD(m_impl,
+            GiDisplayList::kSplines, ctx, modelUnit, count, knots, knotvs);
     if (m_impl->drawRefcnt == 0 || count < 2 
         || knots == NULL || knotvs == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    count = mgMin(count, static_cast<int>(1 + (0x2000 - 1) / 3));
 
-    int i;
+    int i, si, n;
     Point2d pt;
     Vector2d vec;
-    vector<Point2d> pxpoints;
+    Point2d *pxs;
     Matrix2d matD(S2D(xf(), modelUnit));
+    bool ret = false;
 
-    // 开辟像素坐标数组
-    pxpoints.resize(1 + (count - 1) * 3);
-    Point2d *pxs = &pxpoints.front();
+    // 开辟像素坐标数组，型值点多时分块处理，相邻块共用一个型值点，各块累积为一个路径
+    n = mgMin(count, 1 + kMaxChunkSegs);
+    GiScratch<Point2d> pxpoints (m_impl->scratch, 1 + (n - 1) * 3);
+    GiScratch<Point2d> pxknots (m_impl->scratch, n);
+    GiScratch<Vector2d> pxknotvs (m_impl->scratch, n);
+    bool path = (n < count);
 
-    pt = knots[0] * matD;                       // 第一个Bezier段的起点
-    vec = knotvs[0] * matD / 3.f;               // 第一个Bezier段的起始矢量
-    *pxs++ = pt;                                // 产生Bezier段的起点
-    for (i = 1; i < count; i++)                 // 计算每一个Bezier段
+    if (path && !rawBeginPath())
+        return false;
+    for (si = 0; si < count - 1; si += n - 1)
     {
-        *pxs++ = (pt += vec);                   // 产生Bezier段的第二点
-        pt = knots[i] * matD;                   // Bezier段的终点
-        vec = knotvs[i] * matD / 3.f;           // Bezier段的终止矢量
-        *pxs++ = pt - vec;                      // 产生Bezier段的第三点
-        *pxs++ = pt;                            // 产生Bezier段的终点
+        // 本块的型值点和切矢量先批量转换到像素坐标
+        n = mgMin(count - si, 1 + kMaxChunkSegs);
+        matD.TransformPoints(n, knots + si, pxknots.get());
+        matD.TransformVectors(n, knotvs + si, pxknotvs.get());
+        pxs = pxpoints.get();
+
+        pt = pxknots[0];                        // 第一个Bezier段的起点
+        vec = pxknotvs[0] / 3.f;                // 第一个Bezier段的起始矢量
+        *pxs++ = pt;                            // 产生Bezier段的起点
+        for (i = 1; i < n; i++)                 // 计算每一个Bezier段
+        {
+            *pxs++ = (pt += vec);               // 产生Bezier段的第二点
+            pt = pxknots[i];                    // Bezier段的终点
+            vec = pxknotvs[i] / 3.f;            // Bezier段的终止矢量
+            *pxs++ = pt - vec;                  // 产生Bezier段的第三点
+            *pxs++ = pt;                        // 产生Bezier段的终点
+        }
+
+        // 绘图
+        if (!path)
+        {
+            ret = rawBeziers(ctx, pxpoints.get(), 1 + (n - 1) * 3);
+        }
+        else
+        {
+            if (si == 0)
+                rawMoveTo(pxpoints[0].x, pxpoints[0].y);
+            rawBezierTo(pxpoints.get() + 1, (n - 1) * 3);
+        }
     }
+    if (path)
+        ret = rawEndPath(ctx, false);
 
-    // 绘图
-    return rawBeziers(ctx, &pxpoints.front(), getSize(pxpoints));
+    return ret;
 }
 
 bool GiGraphics::drawClosedSplines(const GiContext* ctx, int count, 
@@ -838,43 +1271,62 @@ bool GiGraphics::drawClosedSplines(const GiContext* ctx, int count,
                                    const Vector2d* knotvs, 
                                    bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 1 && knotvs && RECORD(m_impl,
+            GiDisplayList::kClosedSplines, ctx, modelUnit, count, knots, knotvs);
     if (m_impl->drawRefcnt == 0 || count < 2 || 
         knots == NULL || knotvs == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    count = mgMin(count, static_cast<int>((0x2000 - 1) / 3));
 
-    int i, j = 0;
-    Point2d pt;
-    Vector2d vec;
-    vector<Point2d> pxpoints;
+    int i, si, n;
+    Point2d pt, pt0;
+    Vector2d vec, vec0;
+    Point2d *pxs;
     Matrix2d matD(S2D(xf(), modelUnit));
 
-    // 开辟像素坐标数组
-    pxpoints.resize(1 + count * 3);
-    Point2d *pxs = &pxpoints.front();
+    // 开辟像素坐标数组，型值点多时分块处理，各块的Bezier段累积为一个路径
+    n = mgMin(count, 1 + kMaxChunkSegs);
+    GiScratch<Point2d> pxpoints (m_impl->scratch, (n - 1) * 3);
+    GiScratch<Point2d> pxknots (m_impl->scratch, n);
+    GiScratch<Vector2d> pxknotvs (m_impl->scratch, n);
 
-    pt = knots[0] * matD;                       // 第一个Bezier段的起点
-    vec = knotvs[0] * matD / 3.f;               // 第一个Bezier段的起始矢量
-    pxs[j++] = pt;                              // 产生Bezier段的起点
-    for (i = 1; i < count; i++)                 // 计算每一个Bezier段
+    bool ret = rawBeginPath();
+    for (si = 0; ret && si < count - 1; si += n - 1)
     {
-        pxs[j++] = (pt += vec);                 // 产生Bezier段的第二点
-        pt = knots[i] * matD;                   // Bezier段的终点
-        vec = knotvs[i] * matD / 3.f;           // Bezier段的终止矢量
-        pxs[j++] = pt - vec;                    // 产生Bezier段的第三点
-        pxs[j++] = pt;                          // 产生Bezier段的终点
+        // 本块的型值点和切矢量先批量转换到像素坐标
+        n = mgMin(count - si, 1 + kMaxChunkSegs);
+        matD.TransformPoints(n, knots + si, pxknots.get());
+        matD.TransformVectors(n, knotvs + si, pxknotvs.get());
+        pxs = pxpoints.get();
+
+        pt = pxknots[0];                        // 本块第一个Bezier段的起点
+        vec = pxknotvs[0] / 3.f;                // 本块第一个Bezier段的起始矢量
+        if (si == 0)
+        {
+            pt0 = pt;
+            vec0 = vec;
+            ret = rawMoveTo(pt.x, pt.y);        // 闭合曲线的起点
+        }
+        for (i = 1; i < n; i++)                 // 计算每一个Bezier段
+        {
+            *pxs++ = (pt += vec);               // 产生Bezier段的第二点
+            pt = pxknots[i];                    // Bezier段的终点
+            vec = pxknotvs[i] / 3.f;            // Bezier段的终止矢量
+            *pxs++ = pt - vec;                  // 产生Bezier段的第三点
+            *pxs++ = pt;                        // 产生Bezier段的终点
+        }
+        ret = rawBezierTo(pxpoints.get(), (n - 1) * 3);
     }
-    pxs[j++] = (pt += vec);                     // 产生Bezier段的第二点
-    pxs[j]   = 2 * pxs[0] - pxs[1].asVector();  // 产生Bezier段的第三点
-    pxs[j+1] = pxs[0];                          // 产生Bezier段的终点
-
-    // 绘图
-    bool ret = rawBeginPath();
     if (ret)
     {
-        ret = rawMoveTo(pxs[0].x, pxs[0].y);
-        ret = rawBezierTo(pxs + 1, getSize(pxpoints) - 1);
+        pxs = pxpoints.get();
+        pxs[0] = (pt += vec);                   // 产生闭合段的第二点
+        pxs[1] = pt0 - vec0;                    // 产生闭合段的第三点
+        pxs[2] = pt0;                           // 产生闭合段的终点
+
+        // 绘图
+        ret = rawBezierTo(pxs, 3);
         ret = rawClosePath();
         ret = rawEndPath(ctx, true);
     }
@@ -885,10 +1337,12 @@ bool GiGraphics::drawClosedSplines(const GiContext* ctx, int count,
 bool GiGraphics::drawBSplines(const GiContext* ctx, int count, 
                               const Point2d* ctlpts, bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 3 && RECORD(m_impl,
+            GiDisplayList::kBSplines, ctx, modelUnit, count, ctlpts);
     if (m_impl->drawRefcnt == 0 || count < 4 || ctlpts == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    count = mgMin(count, static_cast<int>(3 + (0x2000 - 1) / 3));
 
     const Box2d extent (count, ctlpts);              // 模型坐标范围
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(extent))  // 全部在显示区域外
@@ -897,12 +1351,14 @@ bool GiGraphics::drawBSplines(const GiContext* ctx, int count,
     int i;
     Point2d pt1, pt2, pt3, pt4;
     float d6 = 1.f / 6.f;
-    vector<Point2d> pxpoints;
     Matrix2d matD(S2D(xf(), modelUnit));
 
-    // 开辟像素坐标数组
-    pxpoints.resize(1 + (count - 3) * 3);
-    Point2d *pxs = &pxpoints.front();
+    // 开辟像素坐标数组，曲线段多时分块累积为一个路径
+    int maxn = 1 + mgMin(count - 3, kMaxChunkSegs) * 3;
+    bool path = (count - 3 > kMaxChunkSegs);
+    GiScratch<Point2d> pxpoints (m_impl->scratch, maxn);
+    Point2d *pxs = pxpoints.get();
+    Point2d *pxend = pxs + maxn;
 
     // 计算第一个曲线段
     pt1 = ctlpts[0] * matD;
@@ -914,9 +1370,22 @@ bool GiGraphics::drawBSplines(const GiContext* ctx, int count,
     (*pxs++).set((2 * pt2.x + 4 * pt3.x)    *d6,  (2 * pt2.y + 4 * pt3.y)   *d6);
     (*pxs++).set((pt2.x + 4 * pt3.x + pt4.x)*d6, (pt2.y + 4 * pt3.y + pt4.y)*d6);
 
+    if (path)
+    {
+        if (!rawBeginPath())
+            return false;
+        rawMoveTo(pxpoints[0].x, pxpoints[0].y);
+    }
+
     // 计算其余曲线段
     for (i = 4; i < count; i++)
     {
+        if (pxs == pxend)                       // 缓冲区已满，累积到路径后以最后一点接续
+        {
+            rawBezierTo(pxpoints.get() + 1, maxn - 1);
+            pxpoints[0] = pxend[-1];
+            pxs = pxpoints.get() + 1;
+        }
         pt1 = pt2;
         pt2 = pt3;
         pt3 = pt4;
@@ -927,7 +1396,13 @@ bool GiGraphics::drawBSplines(const GiContext* ctx, int count,
     }
 
     // 绘图
-    return rawBeziers(ctx, &pxpoints.front(), getSize(pxpoints));
+    if (path)
+    {
+        rawBezierTo(pxpoints.get() + 1, static_cast<int>(pxs - pxpoints.get()) - 1);
+        return rawEndPath(ctx, false);
+    }
+    return rawBeziers(ctx, pxpoints.get(), 
+        static_cast<int>(pxs - pxpoints.get()));
 }
 
 bool GiGraphics::drawClosedBSplines(const GiContext* ctx, 
@@ -935,10 +1410,12 @@ bool GiGraphics::drawClosedBSplines(const GiContext* ctx,
                                     const Point2d* ctlpts, 
                                     bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 2 && RECORD(m_impl,
+            GiDisplayList::kClosedBSplines, ctx, modelUnit, count, ctlpts);
     if (m_impl->drawRefcnt == 0 || count < 3 || ctlpts == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    count = mgMin(count, static_cast<int>((0x2000 - 1) / 3));
 
     const Box2d extent (count, ctlpts);              // 模型坐标范围
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(extent))  // 全部在显示区域外
@@ -947,19 +1424,24 @@ bool GiGraphics::drawClosedBSplines(const GiContext* ctx,
     int i;
     Point2d pt1, pt2, pt3, pt4;
     float d6 = 1.f / 6.f;
-    vector<Point2d> pxpoints;
     Matrix2d matD(S2D(xf(), modelUnit));
 
-    // 开辟像素坐标数组
-    pxpoints.resize(1 + count * 3);
-    Point2d *pxs = &pxpoints.front();
+    // 开辟像素坐标数组，存放起点以外的点，曲线段多时分块累积到路径中
+    int maxn = mgMin(count, kMaxChunkSegs) * 3;
+    GiScratch<Point2d> pxpoints (m_impl->scratch, maxn);
+    Point2d *pxs = pxpoints.get();
+    Point2d *pxend = pxs + maxn;
+
+    bool ret = rawBeginPath();
+    if (!ret)
+        return false;
 
     // 计算第一个曲线段
     pt1 = ctlpts[0] * matD;
     pt2 = ctlpts[1] * matD;
     pt3 = ctlpts[2] * matD;
     pt4 = ctlpts[3 % count] * matD;
-    (*pxs++).set((pt1.x + 4 * pt2.x + pt3.x)*d6, (pt1.y + 4 * pt2.y + pt3.y)*d6);
+    ret = rawMoveTo((pt1.x + 4 * pt2.x + pt3.x)*d6, (pt1.y + 4 * pt2.y + pt3.y)*d6);
     (*pxs++).set((4 * pt2.x + 2 * pt3.x)    *d6, (4 * pt2.y + 2 * pt3.y)    *d6);
     (*pxs++).set((2 * pt2.x + 4 * pt3.x)    *d6, (2 * pt2.y + 4 * pt3.y)    *d6);
     (*pxs++).set((pt2.x + 4 * pt3.x + pt4.x)*d6, (pt2.y + 4 * pt3.y + pt4.y)*d6);
@@ -967,6 +1449,11 @@ bool GiGraphics::drawClosedBSplines(const GiContext* ctx,
     // 计算其余曲线段
     for (i = 4; i < count + 3; i++)
     {
+        if (pxs == pxend)                       // 缓冲区已满，先累积到路径中
+        {
+            ret = rawBezierTo(pxpoints.get(), maxn);
+            pxs = pxpoints.get();
+        }
         pt1 = pt2;
         pt2 = pt3;
         pt3 = pt4;
@@ -977,15 +1464,9 @@ bool GiGraphics::drawClosedBSplines(const GiContext* ctx,
     }
 
     // 绘图
-    bool ret = rawBeginPath();
-    if (ret)
-    {
-        pxs = &pxpoints.front();
-        ret = rawMoveTo(pxs[0].x, pxs[0].y);
-        ret = rawBezierTo(pxs + 1, getSize(pxpoints) - 1);
-        ret = rawClosePath();
-        ret = rawEndPath(ctx, true);
-    }
+    ret = rawBezierTo(pxpoints.get(), static_cast<int>(pxs - pxpoints.get()));
+    ret = rawClosePath();
+    ret = rawEndPath(ctx, true);
 
     return ret;
 }
@@ -994,12 +1475,13 @@ bool GiGraphics::drawPath(const GiContext* ctx, int count,
                           const Point2d* points, const UInt8* types, 
                           bool modelUnit)
 {
+    if (m_impl->recorder)
+        return count > 1 && types && RECORD(m_impl,
+            GiDisplayList::kPath, ctx, modelUnit, count, points, NULL, types);
     if (m_impl->drawRefcnt == 0 || count < 2 
         || points == NULL || types == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
-    if (count > 0x2000)
-        count = 0x2000;
 
     Matrix2d matD(S2D(xf(), modelUnit));
 
@@ -1007,18 +1489,63 @@ bool GiGraphics::drawPath(const GiContext* ctx, int count,
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(extent))  // 全部在显示区域外
         return false;
 
-    vector<Point2d> pxpoints;
-    pxpoints.resize(count);
-    Point2d *pxs = &pxpoints.front();
+    GiScratch<Point2d> pxpoints (m_impl->scratch, mgMin(count, kMaxChunkPoints));
+    Point2d *pxs = pxpoints.get();
 
-    for (int i = 0; i < count; i++)
-        pxs[i] = points[i] * matD;
+    if (count <= kMaxChunkPoints)
+    {
+        matD.TransformPoints(count, points, pxs);
+        return rawPath(ctx, count, pxs, types);
+    }
 
-    return rawPath(ctx, count, pxs, types);
+    // 点数多时分块转换，按节点类型累积为一个路径，Bezier段不跨块
+    int si, i, n;
+    UInt8 type;
+    bool ret = rawBeginPath();
+
+    for (si = 0; ret && si < count; si += i)
+    {
+        n = mgMin(count - si, kMaxChunkPoints);
+        matD.TransformPoints(n, points + si, pxs);
+
+        for (i = 0; ret && i < n; i++)
+        {
+            type = types[si + i];
+            if ((type & ~kGiCloseFigure) == kGiBeziersTo && i + 2 >= n)
+                break;                          // 本块剩余点不足，从该段开始下一块
+
+            switch (type & ~kGiCloseFigure)
+            {
+            case kGiMoveTo:
+                rawMoveTo(pxs[i].x, pxs[i].y);
+                break;
+
+            case kGiLineTo:
+                rawLineTo(pxs[i].x, pxs[i].y);
+                break;
+
+            case kGiBeziersTo:
+                rawBezierTo(pxs + i, 3);
+                i += 2;
+                type = types[si + i];
+                break;
+
+            default:
+                ret = false;
+                break;
+            }
+            if (ret && (type & kGiCloseFigure))
+                rawClosePath();
+        }
+        ret = ret && i > 0;                     // 最后的Bezier段缺少点
+    }
+
+    return rawEndPath(ctx, true) && ret;
 }
 
 void GiGraphics::clearCachedBitmap(bool clearAll)
 {
+    m_impl->rectDirtyW.empty();
     SafeCall(m_impl->canvas, clearCachedBitmap(clearAll));
 }
 
@@ -1038,49 +1565,196 @@ float GiGraphics::getScreenDpi() const
     return m_impl->canvas ? m_impl->canvas->getScreenDpi() : 96;
 }
 
+enum { kBatchLine, kBatchLines, kBatchBeziers, kBatchPolygon };
+
+// 统计图元的绘图参数是否与上一个图元的相同，返回像素线宽
+static float BatchStyle(const GiGraphics* gs, GiGraphicsImpl* p, const GiContext* ctx)
+{
+    GiBatchStats& stats = p->batchStats;
+
+    stats.primitives++;
+    if (!ctx) {                                 // 沿用上一个绘图参数
+        stats.savedStates++;
+        return p->lastPenWidth;
+    }
+
+    float width = (p->hasLastCtx && ctx->getLineWidth() == p->lastCtx.getLineWidth())
+        ? p->lastPenWidth : gs->calcPenWidth(ctx->getLineWidth());
+    const GiContext& last = p->lastCtx;
+
+    if (p->hasLastCtx && width == p->lastPenWidth
+        && ctx->getLineStyle() == last.getLineStyle()
+        && ctx->getLineColor() == last.getLineColor()
+        && ctx->hasFillColor() == last.hasFillColor()
+        && (!ctx->hasFillColor() || ctx->getFillColor() == last.getFillColor())) {
+        stats.savedStates++;
+    }
+    else {
+        stats.stateChanges++;
+        p->lastCtx = *ctx;
+        p->lastPenWidth = width;
+        p->hasLastCtx = true;
+    }
+
+    return width;
+}
+
+// 提交一个图元给画布
+static bool BatchSubmit(GiGraphicsImpl* p, int type, const GiContext* ctx,
+                        const Point2d* pxs, int count)
+{
+    p->batchStats.calls++;
+    switch (type)
+    {
+    case kBatchLine:
+        return p->canvas->rawLine(ctx, pxs[0].x, pxs[0].y, pxs[1].x, pxs[1].y);
+    case kBatchLines:
+        return p->canvas->rawLines(ctx, pxs, count);
+    case kBatchBeziers:
+        return p->canvas->rawBeziers(ctx, pxs, count);
+    case kBatchPolygon:
+        return p->canvas->rawPolygon(ctx, pxs, count);
+    }
+    return false;
+}
+
+// 缓存可合并提交的图元，不能合并的图元先提交已缓存的图元再直接提交
+static bool BatchAdd(GiGraphics* gs, GiGraphicsImpl* p, int type,
+                     const GiContext* ctx, const Point2d* pxs, int count)
+{
+    if (!p->canvas || !pxs || count < 1)
+        return false;
+
+    float width = BatchStyle(gs, p, ctx);
+
+    if (!ctx || ctx->isNullLine() || ctx->getLineColor().a != 255   // 半透明时重叠处的显示不同
+        || (type == kBatchPolygon && ctx->hasFillColor())           // 填充后才画边线
+        || count > kMaxChunkPoints) {
+        gs->flushBatch();
+        return BatchSubmit(p, type, ctx, pxs, count);
+    }
+
+    if (p->batchCount > 0 && (width != p->batchPenWidth
+        || ctx->getLineStyle() != p->batchCtx.getLineStyle()
+        || ctx->getLineColor() != p->batchCtx.getLineColor()
+        || (int)p->batchPts.size() + count > kMaxChunkPoints)) {
+        gs->flushBatch();
+    }
+    if (p->batchCount == 0) {
+        p->batchType = type;
+        p->batchCtx = *ctx;
+        p->batchCtx.setNoFillColor();
+        p->batchPenWidth = width;
+    }
+
+    UInt8 segType = (UInt8)(type == kBatchBeziers ? kGiBeziersTo : kGiLineTo);
+
+    p->batchPts.insert(p->batchPts.end(), pxs, pxs + count);
+    p->batchTypes.push_back(kGiMoveTo);
+    p->batchTypes.insert(p->batchTypes.end(), count - 1, segType);
+    if (type == kBatchPolygon)
+        p->batchTypes.back() |= kGiCloseFigure;
+    p->batchCount++;
+
+    return true;
+}
+
+// 统计不能合并的图元，先提交已缓存的图元
+static bool BatchDirect(GiGraphics* gs, GiGraphicsImpl* p, const GiContext* ctx)
+{
+    if (!p->canvas)
+        return false;
+    BatchStyle(gs, p, ctx);
+    gs->flushBatch();
+    p->batchStats.calls++;
+    return true;
+}
+
+void GiGraphics::flushBatch()
+{
+    GiGraphicsImpl* p = m_impl;
+
+    if (p->batchCount == 0 || !p->canvas)
+        return;
+
+    if (p->batchCount == 1) {                   // 只有一个图元时按原方式提交
+        BatchSubmit(p, p->batchType, &p->batchCtx,
+                    &p->batchPts.front(), (int)p->batchPts.size());
+    }
+    else {                                      // 多个图元合为一个路径，每个图元为一个子路径
+        p->batchStats.calls++;
+        p->canvas->rawPath(&p->batchCtx, (int)p->batchPts.size(),
+                           &p->batchPts.front(), &p->batchTypes.front());
+    }
+
+    p->batchCount = 0;
+    p->batchPts.clear();
+    p->batchTypes.clear();
+}
+
 bool GiGraphics::rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2)
 {
+    if (m_impl->batchMode)
+    {
+        Point2d pxs[2] = { Point2d(x1, y1), Point2d(x2, y2) };
+        return BatchAdd(this, m_impl, kBatchLine, ctx, pxs, 2);
+    }
     return m_impl->canvas && m_impl->canvas->rawLine(ctx, x1, y1, x2, y2);
 }
 
 bool GiGraphics::rawLines(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    if (m_impl->batchMode)
+        return BatchAdd(this, m_impl, kBatchLines, ctx, pxs, count);
     return m_impl->canvas && m_impl->canvas->rawLines(ctx, pxs, count);
 }
 
 bool GiGraphics::rawBeziers(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    if (m_impl->batchMode)
+        return BatchAdd(this, m_impl, kBatchBeziers, ctx, pxs, count);
     return m_impl->canvas && m_impl->canvas->rawBeziers(ctx, pxs, count);
 }
 
 bool GiGraphics::rawPolygon(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    if (m_impl->batchMode)
+        return BatchAdd(this, m_impl, kBatchPolygon, ctx, pxs, count);
     return m_impl->canvas && m_impl->canvas->rawPolygon(ctx, pxs, count);
 }
 
 bool GiGraphics::rawRect(const GiContext* ctx, float x, float y, float w, float h)
 {
+    if (m_impl->batchMode && !BatchDirect(this, m_impl, ctx))
+        return false;
     return m_impl->canvas && m_impl->canvas->rawRect(ctx, x, y, w, h);
 }
 
 bool GiGraphics::rawEllipse(const GiContext* ctx, float x, float y, float w, float h)
 {
+    if (m_impl->batchMode && !BatchDirect(this, m_impl, ctx))
+        return false;
     return m_impl->canvas && m_impl->canvas->rawEllipse(ctx, x, y, w, h);
 }
 
 bool GiGraphics::rawPath(const GiContext* ctx, int count, 
                          const Point2d* pxs, const UInt8* types)
 {
+    if (m_impl->batchMode && !BatchDirect(this, m_impl, ctx))
+        return false;
     return m_impl->canvas && m_impl->canvas->rawPath(ctx, count, pxs, types);
 }
 
 bool GiGraphics::rawBeginPath()
 {
+    flushBatch();
     return m_impl->canvas && m_impl->canvas->rawBeginPath();
 }
 
 bool GiGraphics::rawEndPath(const GiContext* ctx, bool fill)
 {
+    if (m_impl->batchMode && !BatchDirect(this, m_impl, ctx))
+        return false;
     return m_impl->canvas && m_impl->canvas->rawEndPath(ctx, fill);
 }
 
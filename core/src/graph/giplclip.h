@@ -19,8 +19,8 @@ template<class T> inline static int getSize(T& arr)
 class PolygonClip
 {
     const Box2d     m_rect;         //!< 剪裁矩形
-    vector<Point2d> m_vs1;          //!< 剪裁交点缓冲
-    vector<Point2d> m_vs2;          //!< 剪裁交点缓冲
+    vector<Point2d>& m_vs1;         //!< 剪裁交点缓冲
+    vector<Point2d>& m_vs2;         //!< 剪裁交点缓冲
     bool            m_closed;       //!< 是否闭合
     
 public:
@@ -28,10 +28,13 @@ public:
     //! 构造函数
     /*!
         \param rect 剪裁矩形，必须为规范化的矩形
+        \param vs1 剪裁交点缓冲，由调用者提供以便重用
+        \param vs2 剪裁交点缓冲，存放剪裁结果
         \param closed 将要传入的坐标序列是多边形还是折线
     */
-    PolygonClip(const Box2d& rect, bool closed = true)
-        : m_rect(rect), m_closed(closed)
+    PolygonClip(const Box2d& rect, vector<Point2d>& vs1, vector<Point2d>& vs2, 
+                bool closed = true)
+        : m_rect(rect), m_vs1(vs1), m_vs2(vs2), m_closed(closed)
     {
     }
     
@@ -49,11 +52,17 @@ public:
         
         if (mat != NULL)
         {
+            Box2d box;
+
             m_vs1.resize(2+count/2);
             m_vs2.resize(count);
             Point2d* p = &m_vs2.front();
-            for (int i=0; i < count; i++)
-                p[i] = points[i] * (*mat);
+            mat->TransformPoints(count, points, p, &box);
+            if (m_rect.contains(box))   // 全部在剪裁矩形内，结果就是变换后的顶点
+            {
+                m_vs1.clear();
+                return true;
+            }
             points = p;
         }
         else
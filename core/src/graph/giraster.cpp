@@ -0,0 +1,1080 @@
+// giraster.cpp: 实现软件光栅化画布类 GiCanvasRaster
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include "giraster.h"
+#include "gigraph.h"
+#include <mgcurv.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+static const float patDash[]      = { 5, 5 };
+static const float patDot[]       = { 1, 3 };
+static const float patDashDot[]   = { 10, 2, 2, 2 };
+static const float dashDotdot[]   = { 20, 2, 2, 2, 2, 2 };
+
+struct LPatten { int n; const float* arr; };
+static const LPatten lpats[] = {
+    { 0, NULL }, { 2, patDash }, { 2, patDot },
+    { 4, patDashDot }, { 6, dashDotdot }
+};
+
+static const float kFlatness = 0.25f;   // 曲线展开为折线的允许误差，像素
+static const int kSubScanlines = 4;     // 反走样时每个像素行的子扫描线数
+
+//! 多边形的边，y0 < y1
+struct RasterEdge {
+    float   x0, y0, y1;
+    float   dxdy;
+    int     dir;                        // 向下为1，向上为-1
+
+    bool operator<(const RasterEdge& e) const { return y0 < e.y0; }
+};
+
+//! 扫描线与边的交点
+struct RasterCross {
+    float   x;
+    int     dir;
+
+    bool operator<(const RasterCross& c) const { return x < c.x; }
+};
+
+//! GiCanvasRaster 的实现类
+class GiCanvasRasterImpl
+{
+public:
+    GiCanvasRaster*     _gs;            //!< 拥有者
+    std::vector<UInt8>  _pixels;        //!< 像素缓冲，预乘透明度的RGBA
+    int                 _width;         //!< 像素缓冲的宽度
+    int                 _height;        //!< 像素缓冲的高度
+    int                 _clip[4];       //!< 剪裁框，左上右下，像素
+    GiColor             _bkcolor;       //!< 背景色
+    GiContext           _gictx;         //!< 当前画笔和画刷
+    bool                _ctxused[2];    //!< beginPaint后是否设置过画笔、画刷
+    bool                _drawing;       //!< 是否正在绘图
+    bool                _painted;       //!< 是否绘制过像素
+    bool                _antiAlias;     //!< 是否反走样
+    UInt8               _pen[4];        //!< 画笔颜色，预乘透明度
+    UInt8               _brush[4];      //!< 画刷颜色，预乘透明度
+    float               _penWidth;      //!< 画笔宽度，像素
+    int                 _lineStyle;     //!< 线型
+    std::vector<RasterEdge>     _edges; //!< 待填充的边
+    std::vector<RasterCross>    _cross; //!< 扫描线交点
+    std::vector<Point2d>        _pts;   //!< 折线点的临时数组
+    std::vector<Point2d>        _dash;  //!< 线型分段的临时数组
+    std::vector<Point2d>        _path;  //!< 路径的折线点
+    std::vector<int>            _figures;   //!< 路径中各子路径的起始序号
+    std::vector<bool>           _closed;    //!< 路径中各子路径是否闭合
+    std::vector<int>            _active;    //!< 与扫描线相交的边的序号
+    std::vector<float>          _cover;     //!< 反走样时一个像素行的覆盖率
+    std::vector<UInt8>          _caches[2]; //!< 后备缓冲位图
+    int                         _cacheW[2]; //!< 后备缓冲位图的宽度
+    int                         _cacheH[2]; //!< 后备缓冲位图的高度
+    static float        _dpi;           //!< 屏幕每英寸的点数
+
+    GiCanvasRasterImpl(GiCanvasRaster* p) : _gs(p), _width(0), _height(0)
+        , _bkcolor(GiColor::White()), _drawing(false), _painted(false)
+        , _antiAlias(true), _penWidth(1), _lineStyle(0)
+    {
+        _clip[0] = _clip[1] = _clip[2] = _clip[3] = 0;
+        _cacheW[0] = _cacheW[1] = _cacheH[0] = _cacheH[1] = 0;
+        _ctxused[0] = _ctxused[1] = false;
+        _pen[0] = _pen[1] = _pen[2] = _pen[3] = 0;
+        _brush[0] = _brush[1] = _brush[2] = _brush[3] = 0;
+    }
+
+    const GiGraphics* owner() const
+    {
+        return _gs->owner();
+    }
+
+    const GiTransform& xf() const
+    {
+        return owner()->xf();
+    }
+
+    static void premultiply(UInt8* dest, const GiColor& color)
+    {
+        dest[0] = (UInt8)((color.r * color.a + 127) / 255);
+        dest[1] = (UInt8)((color.g * color.a + 127) / 255);
+        dest[2] = (UInt8)((color.b * color.a + 127) / 255);
+        dest[3] = color.a;
+    }
+
+    bool setPen(const GiContext* ctx)
+    {
+        bool changed = !_ctxused[0];
+
+        if (ctx && !ctx->isNullLine())
+        {
+            if (_gictx.getLineColor() != ctx->getLineColor()) {
+                _gictx.setLineColor(ctx->getLineColor());
+                changed = true;
+            }
+            if (_gictx.getLineWidth() != ctx->getLineWidth()) {
+                _gictx.setLineWidth(ctx->getLineWidth());
+                changed = true;
+            }
+            if (_gictx.getLineStyle() != ctx->getLineStyle()) {
+                _gictx.setLineStyle(ctx->getLineStyle());
+                changed = true;
+            }
+        }
+
+        if (!ctx) ctx = &_gictx;
+        if (!ctx->isNullLine() && changed)
+        {
+            _ctxused[0] = true;
+
+            GiColor color = ctx->getLineColor();
+            if (owner())
+                color = owner()->calcPenColor(color);
+            premultiply(_pen, color);
+
+            float w = ctx->getLineWidth();
+            w = owner() ? owner()->calcPenWidth(w) : (w < 0 ? -w : 1);
+            _penWidth = mgMax(w, 1.f);              // 不反走样时细于1像素的线会断开
+            _lineStyle = ctx->getLineStyle();
+        }
+
+        return !ctx->isNullLine();
+    }
+
+    bool setBrush(const GiContext* ctx)
+    {
+        bool changed = !_ctxused[1];
+
+        if (ctx && ctx->hasFillColor())
+        {
+            if (_gictx.getFillColor() != ctx->getFillColor()) {
+                _gictx.setFillColor(ctx->getFillColor());
+                changed = true;
+            }
+        }
+        if (!ctx) ctx = &_gictx;
+        if (ctx->hasFillColor() && changed)
+        {
+            _ctxused[1] = true;
+
+            GiColor color = ctx->getFillColor();
+            if (owner())
+                color = owner()->calcPenColor(color);
+            premultiply(_brush, color);
+        }
+
+        return ctx->hasFillColor();
+    }
+
+    void fillColor(const GiColor& color);
+    void blendSpan(int y, int x1, int x2, const UInt8* color);
+    void blendCover(int y, int x1, int x2, const UInt8* color);
+    void addCover(float x1, float x2, float weight, int& xmin, int& xmax);
+    void drawImage(const UInt8* pixels, int width, int height, int left, int top);
+    void addEdge(const Point2d& p1, const Point2d& p2);
+    void addPolygon(const Point2d* pts, int count, bool normalize);
+    void addCircle(const Point2d& center, float r);
+    void scanCrosses(float yc, size_t& next);
+    void fillEdges(const UInt8* color);
+    void fillEdgesAA(const UInt8* color);
+
+    void addStroke(const Point2d* pts, int count, bool closed);
+    void addStrokePiece(const Point2d* pts, int count, bool closed);
+    bool strokeLines(const Point2d* pts, int count, bool closed);
+    bool fillPolygon(const Point2d* pts, int count);
+
+    static void addBezier(std::vector<Point2d>& pts, const Point2d* pxs);
+    static void addBeziers(std::vector<Point2d>& pts, const Point2d* pxs, int count);
+    static void addEllipse(std::vector<Point2d>& pts, float x, float y, float w, float h);
+    bool drawPath(const GiContext* ctx, bool fill);
+};
+
+float GiCanvasRasterImpl::_dpi = 96;
+
+void GiCanvasRasterImpl::fillColor(const GiColor& color)
+{
+    UInt8 c[4];
+    premultiply(c, color);
+
+    for (int y = _clip[1]; y < _clip[3]; y++) {
+        UInt8* p = &_pixels[(y * _width + _clip[0]) * 4];
+        for (int x = _clip[0]; x < _clip[2]; x++, p += 4) {
+            p[0] = c[0]; p[1] = c[1]; p[2] = c[2]; p[3] = c[3];
+        }
+    }
+}
+
+void GiCanvasRasterImpl::blendSpan(int y, int x1, int x2, const UInt8* color)
+{
+    x1 = mgMax(x1, _clip[0]);
+    x2 = mgMin(x2, _clip[2]);
+    if (x1 >= x2)
+        return;
+
+    UInt8* p = &_pixels[(y * _width + x1) * 4];
+    _painted = true;
+
+    if (color[3] == 255) {
+        for (; x1 < x2; x1++, p += 4) {
+            p[0] = color[0]; p[1] = color[1]; p[2] = color[2]; p[3] = 255;
+        }
+    }
+    else {
+        int inv = 255 - color[3];
+        for (; x1 < x2; x1++, p += 4) {
+            for (int i = 0; i < 4; i++)
+                p[i] = (UInt8)(color[i] + (p[i] * inv + 127) / 255);
+        }
+    }
+}
+
+void GiCanvasRasterImpl::blendCover(int y, int x1, int x2, const UInt8* color)
+{
+    UInt8* p = &_pixels[(y * _width + x1) * 4];
+
+    for (; x1 < x2; x1++, p += 4) {
+        float cover = _cover[x1];
+        if (cover <= 0)
+            continue;
+        _cover[x1] = 0;
+        _painted = true;
+
+        int a = cover < 1 ? (int)(cover * 255 + 0.5f) : 255;
+        if (a == 255 && color[3] == 255) {
+            p[0] = color[0]; p[1] = color[1]; p[2] = color[2]; p[3] = 255;
+        }
+        else {
+            UInt8 c[4];
+            for (int i = 0; i < 4; i++)
+                c[i] = (UInt8)((color[i] * a + 127) / 255);
+
+            int inv = 255 - c[3];
+            for (int i = 0; i < 4; i++)
+                p[i] = (UInt8)(c[i] + (p[i] * inv + 127) / 255);
+        }
+    }
+}
+
+void GiCanvasRasterImpl::addCover(float x1, float x2, float weight, int& xmin, int& xmax)
+{
+    x1 = mgMax(x1, (float)_clip[0]);
+    x2 = mgMin(x2, (float)_clip[2]);
+    if (x1 >= x2)
+        return;
+
+    int i1 = (int)x1;
+    int i2 = (int)x2;
+
+    xmin = mgMin(xmin, i1);
+    xmax = mgMax(xmax, mgMin(i2 + 1, _clip[2]));
+
+    if (i1 == i2) {                         // 在一个像素内
+        _cover[i1] += (x2 - x1) * weight;
+        return;
+    }
+    _cover[i1] += (i1 + 1 - x1) * weight;
+    for (int i = i1 + 1; i < i2; i++)
+        _cover[i] += weight;
+    if (i2 < _clip[2])
+        _cover[i2] += (x2 - i2) * weight;
+}
+
+void GiCanvasRasterImpl::drawImage(const UInt8* pixels, int width, int height, int left, int top)
+{
+    int x1 = mgMax(left, _clip[0]);
+    int x2 = mgMin(left + width, _clip[2]);
+    int y1 = mgMax(top, _clip[1]);
+    int y2 = mgMin(top + height, _clip[3]);
+
+    for (int j = y1; j < y2; j++) {
+        const UInt8* src = pixels + ((j - top) * width + x1 - left) * 4;
+        UInt8* dest = &_pixels[(j * _width + x1) * 4];
+
+        for (int i = x1; i < x2; i++, src += 4, dest += 4) {
+            if (src[3] == 255) {
+                memcpy(dest, src, 4);
+            }
+            else if (src[3] != 0) {
+                int inv = 255 - src[3];
+                for (int k = 0; k < 4; k++)
+                    dest[k] = (UInt8)(src[k] + (dest[k] * inv + 127) / 255);
+            }
+        }
+    }
+    if (x1 < x2 && y1 < y2)
+        _painted = true;
+}
+
+void GiCanvasRasterImpl::addEdge(const Point2d& p1, const Point2d& p2)
+{
+    if (p1.y == p2.y)                       // 水平边不与扫描线相交
+        return;
+
+    RasterEdge e;
+    const Point2d& a = p1.y < p2.y ? p1 : p2;
+    const Point2d& b = p1.y < p2.y ? p2 : p1;
+
+    e.x0 = a.x;
+    e.y0 = a.y;
+    e.y1 = b.y;
+    e.dxdy = (b.x - a.x) / (b.y - a.y);
+    e.dir = p1.y < p2.y ? 1 : -1;
+    _edges.push_back(e);
+}
+
+void GiCanvasRasterImpl::addPolygon(const Point2d* pts, int count, bool normalize)
+{
+    if (count < 3)
+        return;
+
+    size_t from = _edges.size();
+    float area = 0;
+
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        addEdge(pts[j], pts[i]);
+        area += (pts[j].x - pts[i].x) * (pts[j].y + pts[i].y);
+    }
+    if (normalize && area < 0) {            // 线条展开的多边形统一方向，使得重叠处不抵消
+        for (size_t k = from; k < _edges.size(); k++)
+            _edges[k].dir = -_edges[k].dir;
+    }
+}
+
+void GiCanvasRasterImpl::addCircle(const Point2d& center, float r)
+{
+    Point2d pts[64];
+    int n = mgMax(8, mgMin(64, (int)(r * 3.2f)));
+    float step = _M_2PI / n;
+
+    for (int i = 0; i < n; i++) {
+        pts[i].set(center.x + r * cosf(i * step), center.y + r * sinf(i * step));
+    }
+    addPolygon(pts, n, true);
+}
+
+void GiCanvasRasterImpl::scanCrosses(float yc, size_t& next)
+{
+    while (next < _edges.size() && _edges[next].y0 <= yc)
+        _active.push_back((int)next++);
+
+    _cross.clear();
+    for (size_t k = 0; k < _active.size(); k++) {
+        const RasterEdge& e = _edges[_active[k]];
+        if (e.y1 <= yc) {
+            _active[k--] = _active.back();
+            _active.pop_back();
+        }
+        else {
+            RasterCross c = { e.x0 + (yc - e.y0) * e.dxdy, e.dir };
+            _cross.push_back(c);
+        }
+    }
+    std::sort(_cross.begin(), _cross.end());
+}
+
+void GiCanvasRasterImpl::fillEdges(const UInt8* color)
+{
+    if (_edges.empty() || color[3] == 0) {
+        _edges.clear();
+        return;
+    }
+    if (_antiAlias) {
+        fillEdgesAA(color);
+        return;
+    }
+
+    std::sort(_edges.begin(), _edges.end());
+
+    float ymax = _edges[0].y1;
+    for (size_t k = 1; k < _edges.size(); k++)
+        ymax = mgMax(ymax, _edges[k].y1);
+
+    // 像素中心 y+0.5 位于边的 [y0, y1) 范围内时才与边相交
+    int y1 = mgMax(_clip[1], (int)ceilf(_edges[0].y0 - 0.5f));
+    int y2 = mgMin(_clip[3], (int)ceilf(ymax - 0.5f));
+    size_t next = 0;
+
+    _active.clear();
+    for (int y = y1; y < y2; y++)
+    {
+        scanCrosses(y + 0.5f, next);
+
+        int winding = 0;
+        float xstart = 0;
+
+        for (size_t k = 0; k < _cross.size(); k++) {
+            int old = winding;
+            winding += _cross[k].dir;
+            if (old == 0 && winding != 0) {
+                xstart = _cross[k].x;
+            }
+            else if (old != 0 && winding == 0) {
+                blendSpan(y, (int)ceilf(xstart - 0.5f), (int)ceilf(_cross[k].x - 0.5f), color);
+            }
+        }
+    }
+
+    _edges.clear();
+}
+
+void GiCanvasRasterImpl::fillEdgesAA(const UInt8* color)
+{
+    std::sort(_edges.begin(), _edges.end());
+
+    float ymax = _edges[0].y1;
+    for (size_t k = 1; k < _edges.size(); k++)
+        ymax = mgMax(ymax, _edges[k].y1);
+
+    // 每个像素行取几条子扫描线，各子扫描线上的区间按横向覆盖的长度累加覆盖率
+    int y1 = mgMax(_clip[1], (int)floorf(_edges[0].y0));
+    int y2 = mgMin(_clip[3], (int)ceilf(ymax));
+    const float weight = 1.f / kSubScanlines;
+    size_t next = 0;
+
+    if ((int)_cover.size() != _width + 1)
+        _cover.assign(_width + 1, 0.f);
+    _active.clear();
+
+    for (int y = y1; y < y2; y++)
+    {
+        int xmin = _clip[2];
+        int xmax = _clip[0];
+
+        for (int sub = 0; sub < kSubScanlines; sub++) {
+            scanCrosses(y + (sub + 0.5f) * weight, next);
+
+            int winding = 0;
+            float xstart = 0;
+
+            for (size_t k = 0; k < _cross.size(); k++) {
+                int old = winding;
+                winding += _cross[k].dir;
+                if (old == 0 && winding != 0)
+                    xstart = _cross[k].x;
+                else if (old != 0 && winding == 0)
+                    addCover(xstart, _cross[k].x, weight, xmin, xmax);
+            }
+        }
+        if (xmin < xmax)
+            blendCover(y, xmin, xmax, color);
+    }
+
+    _edges.clear();
+}
+
+void GiCanvasRasterImpl::addStrokePiece(const Point2d* pts, int count, bool closed)
+{
+    float hw = _penWidth * 0.5f;
+    bool joins = _penWidth > 2.f;           // 细线的连接处不明显，不画圆头
+    int n = closed ? count : count - 1;
+    Point2d quad[4];
+
+    for (int i = 0; i < n; i++) {
+        const Point2d& a = pts[i];
+        const Point2d& b = pts[(i + 1) % count];
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float len = sqrtf(dx * dx + dy * dy);
+
+        if (len < 1e-4f)
+            continue;
+        dx *= hw / len;
+        dy *= hw / len;
+        quad[0].set(a.x - dy, a.y + dx);
+        quad[1].set(b.x - dy, b.y + dx);
+        quad[2].set(b.x + dy, b.y - dx);
+        quad[3].set(a.x + dy, a.y - dx);
+        addPolygon(quad, 4, true);
+    }
+    if (joins || count == 1) {
+        for (int i = 0; i < count; i++)
+            addCircle(pts[i], hw);
+    }
+}
+
+void GiCanvasRasterImpl::addStroke(const Point2d* pts, int count, bool closed)
+{
+    if (_lineStyle <= 0 || _lineStyle >= (int)(sizeof(lpats)/sizeof(lpats[0]))) {
+        addStrokePiece(pts, count, closed);
+        return;
+    }
+
+    const LPatten& pat = lpats[_lineStyle];
+    float scale = mgMax(_penWidth, 1.f);
+    int index = 0;
+    float remain = pat.arr[0] * scale;
+    int n = closed ? count : count - 1;
+
+    _dash.clear();
+    _dash.push_back(pts[0]);
+
+    for (int i = 0; i < n; i++) {
+        Point2d a = pts[i];
+        const Point2d& b = pts[(i + 1) % count];
+        float len = a.distanceTo(b);
+
+        while (len > 0) {
+            float step = mgMin(len, remain);
+            a = a + (b - a) * (step / len);
+            len -= step;
+            remain -= step;
+
+            if (index % 2 == 0)
+                _dash.push_back(a);
+            if (remain <= 0) {
+                if (index % 2 == 0 && !_dash.empty())
+                    addStrokePiece(&_dash.front(), (int)_dash.size(), false);
+                _dash.clear();
+                index = (index + 1) % pat.n;
+                remain = pat.arr[index] * scale;
+                if (index % 2 == 0)
+                    _dash.push_back(a);
+            }
+        }
+    }
+    if (index % 2 == 0 && _dash.size() > 1)
+        addStrokePiece(&_dash.front(), (int)_dash.size(), false);
+}
+
+bool GiCanvasRasterImpl::strokeLines(const Point2d* pts, int count, bool closed)
+{
+    if (count < 1)
+        return false;
+    addStroke(pts, count, closed);
+    fillEdges(_pen);
+    return true;
+}
+
+bool GiCanvasRasterImpl::fillPolygon(const Point2d* pts, int count)
+{
+    if (count < 3)
+        return false;
+    addPolygon(pts, count, false);
+    fillEdges(_brush);
+    return true;
+}
+
+void GiCanvasRasterImpl::addBezier(std::vector<Point2d>& pts, const Point2d* pxs)
+{
+    // 按二阶差分的最大值估算满足误差要求的分段数
+    Point2d d1(pxs[0].x - 2 * pxs[1].x + pxs[2].x, pxs[0].y - 2 * pxs[1].y + pxs[2].y);
+    Point2d d2(pxs[1].x - 2 * pxs[2].x + pxs[3].x, pxs[1].y - 2 * pxs[2].y + pxs[3].y);
+    float dd = mgMax(d1.x * d1.x + d1.y * d1.y, d2.x * d2.x + d2.y * d2.y);
+    int n = (int)ceilf(sqrtf(0.75f * sqrtf(dd) / kFlatness));
+
+    n = mgMax(1, mgMin(n, 100));
+    for (int i = 1; i < n; i++) {
+        Point2d pt;
+        mgFitBezier(pxs, (float)i / n, pt);
+        pts.push_back(pt);
+    }
+    pts.push_back(pxs[3]);
+}
+
+void GiCanvasRasterImpl::addBeziers(std::vector<Point2d>& pts, const Point2d* pxs, int count)
+{
+    pts.push_back(pxs[0]);
+    for (int i = 0; i + 3 < count; i += 3) {
+        addBezier(pts, pxs + i);
+    }
+}
+
+void GiCanvasRasterImpl::addEllipse(std::vector<Point2d>& pts, float x, float y, float w, float h)
+{
+    Point2d pxs[13];
+    mgEllipseToBezier(pxs, Point2d(x + w * 0.5f, y + h * 0.5f), w * 0.5f, h * 0.5f);
+    addBeziers(pts, pxs, 13);
+    pts.pop_back();                         // 终点与起点重合
+}
+
+bool GiCanvasRasterImpl::drawPath(const GiContext* ctx, bool fill)
+{
+    int count = (int)_figures.size();
+    bool usebrush = fill && setBrush(ctx);
+    bool usepen = setPen(ctx);
+
+    if (_path.empty() || (!usepen && !usebrush))
+        return false;
+
+    for (int i = 0; usebrush && i < count; i++) {
+        int from = _figures[i];
+        int to = i + 1 < count ? _figures[i + 1] : (int)_path.size();
+        addPolygon(&_path[from], to - from, false);
+    }
+    fillEdges(_brush);
+
+    for (int i = 0; usepen && i < count; i++) {
+        int from = _figures[i];
+        int to = i + 1 < count ? _figures[i + 1] : (int)_path.size();
+        if (to > from)
+            addStroke(&_path[from], to - from, _closed[i]);
+    }
+    fillEdges(_pen);
+
+    return true;
+}
+
+// PNG 文件的数据块校验码
+static unsigned long pngCrc(unsigned long crc, const UInt8* data, size_t len)
+{
+    static unsigned long table[256];
+
+    if (!table[1]) {
+        for (unsigned long n = 0; n < 256; n++) {
+            unsigned long c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc;
+}
+
+static void pngPutLong(std::vector<UInt8>& buf, unsigned long v)
+{
+    buf.push_back((UInt8)(v >> 24));
+    buf.push_back((UInt8)(v >> 16));
+    buf.push_back((UInt8)(v >> 8));
+    buf.push_back((UInt8)v);
+}
+
+static bool pngWriteChunk(FILE* fp, const char* type, const std::vector<UInt8>& data)
+{
+    std::vector<UInt8> buf;
+
+    pngPutLong(buf, (unsigned long)data.size());
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+    pngPutLong(buf, pngCrc(0xFFFFFFFFUL, &buf[4], buf.size() - 4) ^ 0xFFFFFFFFUL);
+
+    return fwrite(&buf.front(), 1, buf.size(), fp) == buf.size();
+}
+
+GiCanvasRaster::GiCanvasRaster(GiGraphics* gs, float dpi)
+{
+    if (gs) {
+        gs->_setCanvas(this);
+        gs->_xf().setResolution(dpi > 0.1f ? dpi : GiCanvasRasterImpl::_dpi);
+    }
+    m_draw = new GiCanvasRasterImpl(this);
+}
+
+GiCanvasRaster::~GiCanvasRaster()
+{
+    delete m_draw;
+}
+
+void GiCanvasRaster::setScreenDpi(float dpi)
+{
+    GiCanvasRasterImpl::_dpi = dpi;
+}
+
+bool GiCanvasRaster::beginPaint(bool transparent)
+{
+    if (m_draw->_drawing || !owner())
+        return false;
+
+    m_draw->_width = (int)m_draw->xf().getWidth();
+    m_draw->_height = (int)m_draw->xf().getHeight();
+    m_draw->_pixels.resize(m_draw->_width * m_draw->_height * 4);
+
+    m_draw->_clip[0] = 0;
+    m_draw->_clip[1] = 0;
+    m_draw->_clip[2] = m_draw->_width;
+    m_draw->_clip[3] = m_draw->_height;
+    m_draw->fillColor(transparent ? GiColor::Invalid() : m_draw->_bkcolor);
+    m_draw->_ctxused[0] = false;
+    m_draw->_ctxused[1] = false;
+    m_draw->_painted = false;
+    m_draw->_antiAlias = owner()->isAntiAliasMode();
+    m_draw->_drawing = true;
+
+    RECT_2D clipBox = { 0, 0, (float)m_draw->_width, (float)m_draw->_height };
+    owner2()->_beginPaint(clipBox);
+
+    return true;
+}
+
+void GiCanvasRaster::endPaint()
+{
+    if (m_draw->_drawing) {
+        owner2()->flushBatch();             // 先输出批量提交时缓存的图元
+        m_draw->_drawing = false;
+        owner2()->_endPaint();
+    }
+}
+
+const UInt8* GiCanvasRaster::getPixels() const
+{
+    return m_draw->_pixels.empty() ? NULL : &m_draw->_pixels.front();
+}
+
+int GiCanvasRaster::getWidth() const
+{
+    return m_draw->_width;
+}
+
+int GiCanvasRaster::getHeight() const
+{
+    return m_draw->_height;
+}
+
+bool GiCanvasRaster::isPainted() const
+{
+    return m_draw->_painted;
+}
+
+bool GiCanvasRaster::savePNG(const char* filename) const
+{
+    int w = m_draw->_width;
+    int h = m_draw->_height;
+    const UInt8* pixels = getPixels();
+
+    if (!pixels || !filename)
+        return false;
+
+    // 每行前加滤波类型0，透明度改为非预乘
+    std::vector<UInt8> raw;
+    raw.reserve((w * 4 + 1) * h);
+    for (int y = 0; y < h; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < w; x++, pixels += 4) {
+            UInt8 a = pixels[3];
+            for (int i = 0; i < 3; i++)
+                raw.push_back(a ? (UInt8)mgMin(255, (pixels[i] * 255 + a / 2) / a) : (UInt8)0);
+            raw.push_back(a);
+        }
+    }
+
+    // zlib 数据流，使用不压缩的存储块
+    std::vector<UInt8> zdata;
+    unsigned long s1 = 1, s2 = 0;
+    size_t pos = 0;
+
+    zdata.push_back(0x78);
+    zdata.push_back(0x01);
+    do {
+        size_t len = mgMin(raw.size() - pos, (size_t)65535);
+        bool last = pos + len == raw.size();
+
+        zdata.push_back(last ? 1 : 0);
+        zdata.push_back((UInt8)len);
+        zdata.push_back((UInt8)(len >> 8));
+        zdata.push_back((UInt8)~len);
+        zdata.push_back((UInt8)(~len >> 8));
+        zdata.insert(zdata.end(), raw.begin() + pos, raw.begin() + pos + len);
+
+        for (size_t i = pos; i < pos + len; i++) {
+            s1 = (s1 + raw[i]) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+        pos += len;
+    } while (pos < raw.size());
+    pngPutLong(zdata, (s2 << 16) | s1);
+
+    std::vector<UInt8> header;
+    pngPutLong(header, w);
+    pngPutLong(header, h);
+    header.push_back(8);                    // 每个分量8位
+    header.push_back(6);                    // RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    static const UInt8 signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    FILE* fp = fopen(filename, "wb");
+    bool ret = false;
+
+    if (fp) {
+        ret = fwrite(signature, 1, 8, fp) == 8
+            && pngWriteChunk(fp, "IHDR", header)
+            && pngWriteChunk(fp, "IDAT", zdata)
+            && pngWriteChunk(fp, "IEND", std::vector<UInt8>());
+        fclose(fp);
+    }
+
+    return ret;
+}
+
+bool GiCanvasRaster::savePPM(const char* filename) const
+{
+    int w = m_draw->_width;
+    int h = m_draw->_height;
+    const UInt8* pixels = getPixels();
+
+    if (!pixels || !filename)
+        return false;
+
+    UInt8 bk[4];
+    GiCanvasRasterImpl::premultiply(bk, m_draw->_bkcolor);
+
+    std::vector<UInt8> rgb(w * h * 3);
+    for (int i = 0; i < w * h; i++, pixels += 4) {
+        int inv = 255 - pixels[3];              // 透明部分按背景色合成
+        for (int k = 0; k < 3; k++)
+            rgb[i * 3 + k] = (UInt8)mgMin(255, pixels[k] + (bk[k] * inv + 127) / 255);
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    bool ret = false;
+
+    if (fp) {
+        fprintf(fp, "P6\n%d %d\n255\n", w, h);
+        ret = rgb.empty() || fwrite(&rgb.front(), 1, rgb.size(), fp) == rgb.size();
+        fclose(fp);
+    }
+
+    return ret;
+}
+
+void GiCanvasRaster::clearWindow()
+{
+    if (m_draw->_drawing) {
+        m_draw->fillColor(m_draw->_bkcolor);    // 只清除剪裁框内的区域
+    }
+}
+
+bool GiCanvasRaster::drawCachedBitmap(float x, float y, bool secondBmp)
+{
+    return drawCachedBitmap2(this, x, y, secondBmp);
+}
+
+bool GiCanvasRaster::drawCachedBitmap2(const GiCanvas* p, float x, float y, bool secondBmp)
+{
+    bool ret = false;
+
+    if (m_draw->_drawing && p && p->getCanvasType() == getCanvasType()) {
+        const GiCanvasRasterImpl* src = ((const GiCanvasRaster*)p)->m_draw;
+        int n = secondBmp ? 1 : 0;
+
+        if (!src->_caches[n].empty()) {
+            m_draw->drawImage(&src->_caches[n].front(), src->_cacheW[n], src->_cacheH[n],
+                              mgRound(x), mgRound(y));
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+void GiCanvasRaster::saveCachedBitmap(bool secondBmp)
+{
+    int n = secondBmp ? 1 : 0;
+
+    m_draw->_caches[n] = m_draw->_pixels;
+    m_draw->_cacheW[n] = m_draw->_width;
+    m_draw->_cacheH[n] = m_draw->_height;
+}
+
+bool GiCanvasRaster::hasCachedBitmap(bool secondBmp) const
+{
+    return !m_draw->_caches[secondBmp ? 1 : 0].empty();
+}
+
+void GiCanvasRaster::clearCachedBitmap(bool clearAll)
+{
+    m_draw->_caches[0].clear();
+    if (clearAll) {
+        m_draw->_caches[1].clear();
+    }
+}
+
+bool GiCanvasRaster::isBufferedDrawing() const
+{
+    return m_draw->_drawing;                // 总是在内存中的像素缓冲上绘图
+}
+
+const GiContext* GiCanvasRaster::getCurrentContext() const
+{
+    return &m_draw->_gictx;
+}
+
+void GiCanvasRaster::_clipBoxChanged(const RECT_2D& clipBox)
+{
+    m_draw->_clip[0] = mgMax(0, (int)floorf(clipBox.left));
+    m_draw->_clip[1] = mgMax(0, (int)floorf(clipBox.top));
+    m_draw->_clip[2] = mgMin(m_draw->_width, (int)ceilf(clipBox.right));
+    m_draw->_clip[3] = mgMin(m_draw->_height, (int)ceilf(clipBox.bottom));
+}
+
+void GiCanvasRaster::_antiAliasModeChanged(bool antiAlias)
+{
+    m_draw->_antiAlias = antiAlias;
+}
+
+bool GiCanvasRaster::rawImage(const UInt8* pixels, int width, int height, float x, float y)
+{
+    if (!m_draw->_drawing || !pixels || width < 1 || height < 1)
+        return false;
+
+    m_draw->drawImage(pixels, width, height, mgRound(x), mgRound(y));
+
+    return true;
+}
+
+float GiCanvasRaster::getScreenDpi() const
+{
+    return GiCanvasRasterImpl::_dpi;
+}
+
+GiColor GiCanvasRaster::getBkColor() const
+{
+    return m_draw->_bkcolor;
+}
+
+GiColor GiCanvasRaster::setBkColor(const GiColor& color)
+{
+    GiColor old(m_draw->_bkcolor);
+    m_draw->_bkcolor = color;
+    return old;
+}
+
+bool GiCanvasRaster::rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2)
+{
+    Point2d pts[2] = { Point2d(x1, y1), Point2d(x2, y2) };
+    return m_draw->_drawing && m_draw->setPen(ctx) && m_draw->strokeLines(pts, 2, false);
+}
+
+bool GiCanvasRaster::rawLines(const GiContext* ctx, const Point2d* pxs, int count)
+{
+    return m_draw->_drawing && m_draw->setPen(ctx) && count > 1
+        && m_draw->strokeLines(pxs, count, false);
+}
+
+bool GiCanvasRaster::rawBeziers(const GiContext* ctx, const Point2d* pxs, int count)
+{
+    bool ret = m_draw->_drawing && m_draw->setPen(ctx) && count > 3;
+
+    if (ret) {
+        m_draw->_pts.clear();
+        GiCanvasRasterImpl::addBeziers(m_draw->_pts, pxs, count);
+        ret = m_draw->strokeLines(&m_draw->_pts.front(), (int)m_draw->_pts.size(), false);
+    }
+
+    return ret;
+}
+
+bool GiCanvasRaster::rawPolygon(const GiContext* ctx, const Point2d* pxs, int count)
+{
+    bool usepen = m_draw->setPen(ctx);
+    bool usebrush = m_draw->setBrush(ctx);
+    bool ret = m_draw->_drawing && count > 1 && (usepen || usebrush);
+
+    if (ret) {
+        if (usebrush)
+            m_draw->fillPolygon(pxs, count);
+        if (usepen)
+            m_draw->strokeLines(pxs, count, true);
+    }
+
+    return ret;
+}
+
+bool GiCanvasRaster::rawRect(const GiContext* ctx, float x, float y, float w, float h)
+{
+    Point2d pts[4] = { Point2d(x, y), Point2d(x + w, y),
+        Point2d(x + w, y + h), Point2d(x, y + h) };
+    return rawPolygon(ctx, pts, 4);
+}
+
+bool GiCanvasRaster::rawEllipse(const GiContext* ctx, float x, float y, float w, float h)
+{
+    m_draw->_pts.clear();
+    GiCanvasRasterImpl::addEllipse(m_draw->_pts, x, y, w, h);
+
+    return rawPolygon(ctx, &m_draw->_pts.front(), (int)m_draw->_pts.size());
+}
+
+bool GiCanvasRaster::rawPath(const GiContext* ctx,
+                             int count, const Point2d* pxs, const UInt8* types)
+{
+    rawBeginPath();
+
+    for (int i = 0; i < count; i++)
+    {
+        switch (types[i] & ~kGiCloseFigure)
+        {
+        case kGiMoveTo:
+            rawMoveTo(pxs[i].x, pxs[i].y);
+            break;
+
+        case kGiLineTo:
+            rawLineTo(pxs[i].x, pxs[i].y);
+            break;
+
+        case kGiBeziersTo:
+            if (i + 2 >= count)
+                return false;
+            rawBezierTo(pxs + i, 3);
+            i += 2;
+            break;
+
+        default:
+            return false;
+        }
+        if (types[i] & kGiCloseFigure)
+            rawClosePath();
+    }
+
+    return rawEndPath(ctx, true);
+}
+
+bool GiCanvasRaster::rawBeginPath()
+{
+    m_draw->_path.clear();
+    m_draw->_figures.clear();
+    m_draw->_closed.clear();
+    return true;
+}
+
+bool GiCanvasRaster::rawEndPath(const GiContext* ctx, bool fill)
+{
+    bool ret = m_draw->_drawing && m_draw->drawPath(ctx, fill);
+    rawBeginPath();
+    return ret;
+}
+
+bool GiCanvasRaster::rawMoveTo(float x, float y)
+{
+    m_draw->_figures.push_back((int)m_draw->_path.size());
+    m_draw->_closed.push_back(false);
+    m_draw->_path.push_back(Point2d(x, y));
+    return true;
+}
+
+bool GiCanvasRaster::rawLineTo(float x, float y)
+{
+    if (m_draw->_figures.empty())
+        return false;
+    m_draw->_path.push_back(Point2d(x, y));
+    return true;
+}
+
+bool GiCanvasRaster::rawBezierTo(const Point2d* pxs, int count)
+{
+    if (m_draw->_figures.empty() || !pxs || count < 3)
+        return false;
+
+    Point2d bz[4];
+    for (int i = 0; i + 2 < count; i += 3) {
+        bz[0] = m_draw->_path.back();
+        bz[1] = pxs[i];
+        bz[2] = pxs[i + 1];
+        bz[3] = pxs[i + 2];
+        GiCanvasRasterImpl::addBezier(m_draw->_path, bz);
+    }
+    return true;
+}
+
+bool GiCanvasRaster::rawClosePath()
+{
+    if (m_draw->_closed.empty())
+        return false;
+    m_draw->_closed.back() = true;
+    return true;
+}
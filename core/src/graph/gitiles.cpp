@@ -0,0 +1,330 @@
+// gitiles.cpp: 实现静态图形的瓦片位图缓存类 GiTileCache
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include "gitiles.h"
+#include "giraster.h"
+#include <math.h>
+#include <string.h>
+#include <list>
+#include <map>
+#include <vector>
+
+static const float kLevelTol = 1e-5f;   // 显示比例的相对误差在此范围内视为同一级
+static const float kInflatePixels = 10; // 失效范围放大的像素数，以包含线宽
+static const long kTileOverhead = 64;   // 每个瓦片索引占用的字节数
+static const float kPhaseTol = 0.01f;   // 平移相位的误差在此范围内视为同一级，像素
+static const int kMaxLevels = 32;       // 最多记录的级别数，超过时清除所有瓦片
+
+//! 瓦片的索引
+struct GiTileKey {
+    int     level;                      //!< 显示比例和平移相位的级别序号
+    long    i;                          //!< 瓦片列号
+    long    j;                          //!< 瓦片行号
+
+    bool operator<(const GiTileKey& k) const {
+        return level < k.level || (level == k.level
+            && (i < k.i || (i == k.i && j < k.j)));
+    }
+};
+
+//! 缓存的瓦片
+struct GiTile {
+    GiTileKey   key;                    //!< 瓦片索引
+    UInt8*      pixels;                 //!< 瓦片位图，为NULL表示没有图形
+    long        frame;                  //!< 最近一次显示的次数序号
+};
+
+//! 瓦片的级别，级别像素坐标为世界坐标乘以显示比例再加上相位
+struct GiTileLevel {
+    float       scale;                  //!< 显示比例
+    float       phaseX;                 //!< 显示坐标X的像素小数部分
+    float       phaseY;                 //!< 显示坐标Y的像素小数部分
+};
+
+typedef std::list<GiTile> GiTileList;
+typedef std::map<GiTileKey, GiTileList::iterator> GiTileMap;
+
+//! GiTileCache 的实现类
+class GiTileCacheImpl
+{
+public:
+    int                 tileSize;       //!< 瓦片的宽高，像素
+    long                maxBytes;       //!< 最大字节数
+    long                usedBytes;      //!< 已占用的字节数
+    long                frame;          //!< 显示次数
+    GiTileList          tiles;          //!< 瓦片，最近使用的在前
+    GiTileMap           index;          //!< 瓦片索引
+    std::vector<GiTileLevel>  levels;   //!< 各级显示比例和平移相位
+    float               dpiX;           //!< 瓦片对应的显示分辨率X
+    float               dpiY;           //!< 瓦片对应的显示分辨率Y
+    bool                ydown;          //!< 瓦片对应的显示设备+Y方向是否向下
+    Matrix2d            matM2W;         //!< 瓦片对应的模型坐标到世界坐标的变换
+    GiTransform         xform;          //!< 生成瓦片的坐标系
+    GiGraphics          gs;             //!< 生成瓦片的图形系统
+    GiCanvasRaster      canvas;         //!< 生成瓦片的画布
+
+    GiTileCacheImpl(int size, long bytes)
+        : tileSize(size), maxBytes(bytes), usedBytes(0), frame(0)
+        , dpiX(0), dpiY(0), ydown(true), gs(&xform), canvas(&gs)
+    {
+    }
+
+    ~GiTileCacheImpl()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (GiTileList::iterator it = tiles.begin(); it != tiles.end(); ++it) {
+            delete[] it->pixels;
+        }
+        tiles.clear();
+        index.clear();
+        levels.clear();
+        usedBytes = 0;
+    }
+
+    long tileBytes(const GiTile& tile) const
+    {
+        return kTileOverhead + (tile.pixels ? tileSize * tileSize * 4 : 0);
+    }
+
+    void removeTile(GiTileList::iterator it)
+    {
+        usedBytes -= tileBytes(*it);
+        delete[] it->pixels;
+        index.erase(it->key);
+        tiles.erase(it);
+    }
+
+    // 世界坐标到级别像素坐标的比例
+    double w2dx(int level) const { return levels[level].scale * dpiX / 25.4; }
+    double w2dy(int level) const { return levels[level].scale * dpiY / 25.4 * (ydown ? -1 : 1); }
+
+    // 坐标系的分辨率或模型变换改变后，原有瓦片都不能用了
+    void checkTransform(const GiTransform& xf)
+    {
+        bool down = xf.worldToDisplay().m22 < 0;
+
+        if (dpiX != xf.getDpiX() || dpiY != xf.getDpiY()
+            || ydown != down || matM2W != xf.modelToWorld())
+        {
+            clear();
+            dpiX = xf.getDpiX();
+            dpiY = xf.getDpiY();
+            ydown = down;
+            matM2W = xf.modelToWorld();
+        }
+    }
+
+    int findLevel(float scale, float phaseX, float phaseY)
+    {
+        for (int k = 0; k < (int)levels.size(); k++) {
+            const GiTileLevel& lv = levels[k];
+            if (fabsf(lv.scale - scale) <= scale * kLevelTol
+                && fabsf(lv.phaseX - phaseX) < kPhaseTol
+                && fabsf(lv.phaseY - phaseY) < kPhaseTol) {
+                return k;
+            }
+        }
+        if ((int)levels.size() >= kMaxLevels)   // 多次按小数像素平移后
+            clear();
+
+        GiTileLevel lv = { scale, phaseX, phaseY };
+        levels.push_back(lv);
+        return (int)levels.size() - 1;
+    }
+
+    // 级别像素坐标 (u, v) 对应的世界坐标
+    Point2d levelToWorld(int level, double u, double v) const
+    {
+        return Point2d((float)((u - levels[level].phaseX) / w2dx(level)),
+                       (float)((v - levels[level].phaseY) / w2dy(level)));
+    }
+
+    Box2d tileWorld(const GiTileKey& key) const
+    {
+        return Box2d(levelToWorld(key.level, key.i * tileSize, key.j * tileSize),
+                     levelToWorld(key.level, (key.i + 1) * tileSize, (key.j + 1) * tileSize));
+    }
+
+    const GiTile& getTile(const GiTileKey& key, const GiGraphics& src,
+                          GiTilePainter* painter, int& rendered);
+    void renderTile(GiTile& tile, const GiGraphics& src, GiTilePainter* painter);
+    void shrink();
+};
+
+const GiTile& GiTileCacheImpl::getTile(const GiTileKey& key, const GiGraphics& src,
+                                       GiTilePainter* painter, int& rendered)
+{
+    GiTileMap::iterator found = index.find(key);
+
+    if (found != index.end()) {
+        tiles.splice(tiles.begin(), tiles, found->second);
+    }
+    else {
+        GiTile tile;
+        tile.key = key;
+        tile.pixels = NULL;
+        tile.frame = frame;
+        renderTile(tile, src, painter);
+        rendered++;
+
+        tiles.push_front(tile);
+        index[key] = tiles.begin();
+        usedBytes += tileBytes(tile);
+        shrink();
+    }
+    tiles.front().frame = frame;
+
+    return tiles.front();
+}
+
+void GiTileCacheImpl::renderTile(GiTile& tile, const GiGraphics& src, GiTilePainter* painter)
+{
+    const GiTileKey& key = tile.key;
+    Point2d centerW(levelToWorld(key.level, (key.i + 0.5) * tileSize, (key.j + 0.5) * tileSize));
+
+    xform.copy(src.xf());
+    xform.setWndSize(tileSize, tileSize);
+    xform.setWorldLimits(Box2d());          // 瓦片可在世界范围之外
+    xform.zoom(centerW, levels[key.level].scale);
+    gs.copy(src);
+
+    if (canvas.beginPaint(true)) {
+        painter->paint(gs, GiTilePainter::kPaintTiled);
+        canvas.endPaint();
+
+        if (canvas.isPainted()) {
+            int bytes = tileSize * tileSize * 4;
+            tile.pixels = new UInt8[bytes];
+            memcpy(tile.pixels, canvas.getPixels(), bytes);
+        }
+    }
+}
+
+void GiTileCacheImpl::shrink()
+{
+    while (usedBytes > maxBytes && !tiles.empty()
+           && tiles.back().frame != frame) {    // 本次要显示的瓦片不淘汰
+        removeTile(--tiles.end());
+    }
+}
+
+GiTileCache::GiTileCache(int tileSize, long maxBytes)
+{
+    m_impl = new GiTileCacheImpl(mgMax(tileSize, 16), maxBytes);
+}
+
+GiTileCache::~GiTileCache()
+{
+    delete m_impl;
+}
+
+int GiTileCache::getTileSize() const
+{
+    return m_impl->tileSize;
+}
+
+void GiTileCache::setMemoryLimit(long maxBytes)
+{
+    m_impl->maxBytes = maxBytes;
+    m_impl->frame++;
+    m_impl->shrink();
+}
+
+long GiTileCache::getMemoryUsed() const
+{
+    return m_impl->usedBytes;
+}
+
+int GiTileCache::getTileCount() const
+{
+    return (int)m_impl->index.size();
+}
+
+void GiTileCache::clear()
+{
+    m_impl->clear();
+}
+
+void GiTileCache::invalidate(const Box2d& rectModel)
+{
+    if (m_impl->tiles.empty())
+        return;
+
+    Box2d rectW(rectModel * m_impl->matM2W);
+    GiTileList::iterator it = m_impl->tiles.begin();
+
+    while (it != m_impl->tiles.end()) {
+        Box2d rect(rectW);
+        rect.inflate((float)(kInflatePixels / m_impl->w2dx(it->key.level)));
+
+        if (rect.isIntersect(m_impl->tileWorld(it->key)))
+            m_impl->removeTile(it++);
+        else
+            ++it;
+    }
+}
+
+bool GiTileCache::draw(GiGraphics& gs, GiTilePainter* painter, int* rendered)
+{
+    static const UInt8 probe[4] = { 0, 0, 0, 0 };
+    GiCanvas* canvas = gs.getCanvas();
+    int count = 0;
+
+    if (rendered)
+        *rendered = 0;
+    if (!canvas || !painter || !gs.isDrawing())
+        return false;
+
+    if (!canvas->rawImage(probe, 1, 1, 0, 0)) {    // 以透明像素检测画布是否支持显示位图
+        painter->paint(gs, GiTilePainter::kPaintAll);
+        return false;
+    }
+
+    const GiTransform& xf = gs.xf();
+    m_impl->checkTransform(xf);
+    m_impl->frame++;
+
+    // 世界坐标乘以比例再加上偏移即为显示坐标，偏移的小数部分作为级别的相位，
+    // 级别像素坐标加上偏移的整数部分即为显示坐标，瓦片按整像素贴图后与直接显示的像素位置相同
+    double ox = xf.worldToDisplay().dx;
+    double oy = xf.worldToDisplay().dy;
+    double fx = floor(ox);
+    double fy = floor(oy);
+
+    GiTileKey key;
+    key.level = m_impl->findLevel(xf.getViewScale(), (float)(ox - fx), (float)(oy - fy));
+    ox = fx;
+    oy = fy;
+
+    double T = m_impl->tileSize;
+
+    RECT_2D rc;
+    gs.getClipBox(rc);
+
+    long i1 = (long)floor((rc.left - ox) / T);
+    long i2 = (long)ceil((rc.right - ox) / T);
+    long j1 = (long)floor((rc.top - oy) / T);
+    long j2 = (long)ceil((rc.bottom - oy) / T);
+
+    for (key.j = j1; key.j < j2; key.j++) {
+        for (key.i = i1; key.i < i2; key.i++) {
+            const GiTile& tile = m_impl->getTile(key, gs, painter, count);
+            if (tile.pixels) {
+                canvas->rawImage(tile.pixels, m_impl->tileSize, m_impl->tileSize,
+                                 (float)(key.i * T + ox), (float)(key.j * T + oy));
+            }
+        }
+    }
+    m_impl->shrink();
+    painter->paint(gs, GiTilePainter::kPaintOverlay);
+
+    if (rendered)
+        *rendered = count;
+
+    return true;
+}
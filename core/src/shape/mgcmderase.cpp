@@ -97,9 +97,11 @@ bool MgCommandErase::click(const MgMotion* sender)
     MgShape* shape = hitTest(sender);
     if (shape) {
         MgShapesLock locker(sender->view->shapes(), MgShapesLock::Edit);
+        Box2d rect(mgShapeDisplayBox(shape, sender->view->graph()));
+        
         shape = sender->view->shapes()->removeShape(shape->getID());
         shape->release();
-        sender->view->regen();
+        sender->view->regenRect(rect);
     }
     
     return true;
@@ -118,6 +120,7 @@ bool MgCommandErase::longPress(const MgMotion* /*sender*/)
 bool MgCommandErase::touchBegan(const MgMotion* sender)
 {
     m_boxsel = true;
+    m_region.reset();
     sender->view->redraw(false);
     return true;
 }
@@ -131,17 +134,15 @@ bool MgCommandErase::isIntersectMode(const MgMotion* sender)
 bool MgCommandErase::touchMoved(const MgMotion* sender)
 {
     Box2d snap(sender->startPointM, sender->pointM);
-    void *it = NULL;
-    MgShape* shape = m_boxsel ? sender->view->shapes()->getFirstShape(it) : NULL;
+    MgRegionQuery query(snap, !isIntersectMode(sender));
     
-    m_delIds.clear();
-    for (; shape; shape = sender->view->shapes()->getNextShape(it)) {
-        if (isIntersectMode(sender) ? shape->shape()->hitTestBox(snap)
-            : snap.contains(shape->shape()->getExtent())) {
-            m_delIds.push_back(shape->getID());
-        }
+    if (m_boxsel) {                             // 只重新判断选择框变化部分的图形
+        m_region.update(sender->view->shapes(), query);
+        m_delIds = m_region.getIDs();
+    }
+    else {
+        m_delIds.clear();
     }
-    sender->view->shapes()->freeIterator(it);
     sender->view->redraw(false);
     
     return true;
@@ -151,16 +152,18 @@ bool MgCommandErase::touchEnded(const MgMotion* sender)
 {
     if (!m_delIds.empty()) {
         MgShapesLock locker(sender->view->shapes(), MgShapesLock::Edit);
+        Box2d rect;
         
         for (std::vector<UInt32>::iterator it = m_delIds.begin(); it != m_delIds.end(); ++it) {
             MgShape* shape = sender->view->shapes()->findShape(*it);
             if (shape) {
+                rect.unionWith(mgShapeDisplayBox(shape, sender->view->graph()));
                 shape = sender->view->shapes()->removeShape(shape->getID());
                 shape->release();
             }
         }
         
-        sender->view->regen();
+        sender->view->regenRect(rect);
         m_delIds.clear();
     }
     
@@ -7,6 +7,7 @@
 #define __GEOMETRY_MGCOMMAND_ERASE_H_
 
 #include <mgcmd.h>
+#include <mgregion.h>
 #include <vector>
 
 //! 橡皮擦命令类
@@ -44,6 +45,7 @@ private:
     bool isIntersectMode(const MgMotion* sender);
     
     std::vector<UInt32>     m_delIds;
+    MgRegionSelection       m_region;           // 框选的增量查找结果
     bool                    m_boxsel;
 };
 
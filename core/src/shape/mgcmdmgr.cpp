@@ -13,6 +13,11 @@ MgCommandManager* mgGetCommandManager()
     return &s_cmds;
 }
 
+MgCommandManager* mgCreateCommandManager()
+{
+    return new MgCmdManagerImpl;
+}
+
 MgCmdManagerImpl::MgCmdManagerImpl()
 {
 }
@@ -22,6 +27,17 @@ MgCmdManagerImpl::~MgCmdManagerImpl()
     unloadCommands();
 }
 
+void MgCmdManagerImpl::release()
+{
+    if (this != &s_cmds)
+        delete this;
+}
+
+MgLockRW* MgCmdManagerImpl::getDynamicShapeLock()
+{
+    return &_dynLock;
+}
+
 void MgCmdManagerImpl::unloadCommands()
 {
     for (CMDS::iterator it = _cmds.begin(); it != _cmds.end(); ++it)
@@ -29,6 +29,8 @@ private:
     virtual UInt32 getSelection(MgView* view, UInt32 count, MgShape** shapes, bool forChange = false);
     virtual bool dynamicChangeEnded(MgView* view, bool apply);
     virtual MgSelection* getSelection(MgView* view);
+    virtual MgLockRW* getDynamicShapeLock();
+    virtual void release();
 
 private:
     typedef std::map<std::string, MgCommand*> CMDS;
@@ -36,6 +38,7 @@ private:
     CMDS            _cmds;
     Factories       _factories;
     std::string     _cmdname;
+    MgLockRW        _dynLock;
 };
 
 #endif // __GEOMETRY_MGCOMMAND_MANAGER_H_
@@ -14,53 +14,226 @@
 #include <mgshapet.h>
 
 typedef std::pair<MgShapesLock::ShapesLocked, void*> ShapeObserver;
-static std::vector<ShapeObserver>  s_shapeObservers;
-static MgLockRW s_dynLock;
+typedef std::vector<ShapeObserver> ShapeObservers;
 
 #ifdef _WIN32
 void giSleep(int ms) { Sleep(ms); }
 #else
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <errno.h>
 void giSleep(int ms) { usleep(ms * 1000); }
 #endif
 
+// MgLockMonitor: 互斥量和条件变量
+//
+
+#ifdef _WIN32
+
+static double giLockTicks()                 // 毫秒
+{
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER count;
+    
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    
+    return 1000.0 * count.QuadPart / freq.QuadPart;
+}
+
+// 用信号量实现条件变量的广播唤醒，兼容没有 CONDITION_VARIABLE 的 Windows XP
+class MgLockMonitor
+{
+public:
+    MgLockMonitor() : _waiters(0), _generation(0) {
+        InitializeCriticalSection(&_cs);
+        _sem = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+    }
+    ~MgLockMonitor() {
+        CloseHandle(_sem);
+        DeleteCriticalSection(&_cs);
+    }
+    void enter() { EnterCriticalSection(&_cs); }
+    void leave() { LeaveCriticalSection(&_cs); }
+    
+    // 在 enter() 之后调用，等待 notifyAll() 或超时，可能被提前唤醒
+    void wait(int ms) {
+        long gen = _generation;
+        
+        _waiters++;
+        leave();
+        DWORD ret = WaitForSingleObject(_sem, ms);
+        enter();
+        if (ret != WAIT_OBJECT_0 && gen == _generation)
+            _waiters--;                     // 超时且未被计入唤醒
+    }
+    void notifyAll() {
+        if (_waiters > 0) {
+            ReleaseSemaphore(_sem, _waiters, NULL);
+            _waiters = 0;
+            _generation++;
+        }
+    }
+    
+private:
+    CRITICAL_SECTION    _cs;
+    HANDLE              _sem;
+    long                _waiters;
+    long                _generation;
+};
+
+#else // pthread
+
+static double giLockTicks()                 // 毫秒
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+class MgLockMonitor
+{
+public:
+    MgLockMonitor() {
+        pthread_mutex_init(&_mutex, NULL);
+        pthread_cond_init(&_cond, NULL);
+    }
+    ~MgLockMonitor() {
+        pthread_cond_destroy(&_cond);
+        pthread_mutex_destroy(&_mutex);
+    }
+    void enter() { pthread_mutex_lock(&_mutex); }
+    void leave() { pthread_mutex_unlock(&_mutex); }
+    
+    // 在 enter() 之后调用，等待 notifyAll() 或超时，可能被提前唤醒
+    void wait(int ms) {
+        struct timeval now;
+        struct timespec abstime;
+        
+        gettimeofday(&now, NULL);
+        long usec = now.tv_usec + (ms % 1000) * 1000L;
+        abstime.tv_sec = now.tv_sec + ms / 1000 + usec / 1000000L;
+        abstime.tv_nsec = (usec % 1000000L) * 1000L;
+        pthread_cond_timedwait(&_cond, &_mutex, &abstime);
+    }
+    void notifyAll() { pthread_cond_broadcast(&_cond); }
+    
+private:
+    pthread_mutex_t     _mutex;
+    pthread_cond_t      _cond;
+};
+
+#endif // _WIN32
+
+struct MgLockRWImpl
+{
+    MgLockMonitor   monitor;
+    long            readers;                // 已读锁定的个数
+    long            writers;                // 已写锁定的个数, 0 或 1
+    long            waitingWriters;         // 等待写锁定的个数
+    double          readStart;              // 开始有读者的时刻
+    double          writeStart;             // 写锁定的时刻
+    MgLockStats     stats;
+    ShapeObservers  observers;              // 图形列表的写锁定观察者
+    
+    MgLockRWImpl() : readers(0), writers(0), waitingWriters(0)
+        , readStart(0), writeStart(0) {}
+    
+    bool canLock(bool forWrite) const {
+        return forWrite ? (!readers && !writers) : (!writers && !waitingWriters);
+    }
+    void addHold(double start) {
+        double t = giLockTicks() - start;
+        stats.holdTime += t;
+        if (stats.maxHold < t)
+            stats.maxHold = t;
+    }
+};
+
 // MgLockRW
 //
 
-MgLockRW::MgLockRW() : _editFlags(0)
+MgLockRW::MgLockRW() : _impl(new MgLockRWImpl), _editFlags(0)
 {
     _counts[0] = _counts[1] = _counts[2] = 0;
 }
 
+MgLockRW::~MgLockRW()
+{
+    delete _impl;
+}
+
 bool MgLockRW::lock(bool forWrite, int timeout)
 {
-    bool ret = false;
+    MgLockRWImpl* p = _impl;
+    bool ret;
     
-    if (1 == giInterlockedIncrement(_counts)) {     // first locked
-        giInterlockedIncrement(_counts + (forWrite ? 2 : 1));
-        ret = true;
+    p->monitor.enter();
+    ret = p->canLock(forWrite);
+    
+    if (!ret) {                                     // 阻塞等待，不再轮询
+        double start = giLockTicks();
+        double wait = 0;
+        
+        p->stats.contended++;
+        if (forWrite)
+            p->waitingWriters++;                    // 写者优先，后来的读者等待
+        while (!ret && wait < timeout) {
+            p->monitor.wait((int)(timeout - wait + 0.999));
+            ret = p->canLock(forWrite);
+            wait = giLockTicks() - start;
+        }
+        if (forWrite && 0 == --p->waitingWriters && !ret)
+            p->monitor.notifyAll();                 // 放弃写锁定后让等待的读者继续
+        
+        p->stats.waitTime += wait;
+        if (p->stats.maxWait < wait)
+            p->stats.maxWait = wait;
     }
-    else {
-        ret = !forWrite && 0 == _counts[2];         // for read and not locked for write
-        for (int i = 0; i < timeout && !ret; i += 25) {
-            giSleep(25);
-            ret = forWrite ? (!_counts[1] && !_counts[2]) : !_counts[2];
+    
+    if (ret) {
+        p->stats.locks++;
+        if (forWrite) {
+            p->stats.writeLocks++;
+            p->writers++;
+            p->writeStart = giLockTicks();
         }
-        if (ret) {
-            giInterlockedIncrement(_counts + (forWrite ? 2 : 1));
-        }
-        else {
-            giInterlockedDecrement(_counts);
+        else if (1 == ++p->readers) {
+            p->readStart = giLockTicks();
         }
+        _counts[0]++;
+        _counts[forWrite ? 2 : 1]++;
+    }
+    else {
+        p->stats.timeouts++;
     }
+    p->monitor.leave();
     
     return ret;
 }
 
 long MgLockRW::unlock(bool forWrite)
 {
-    giInterlockedDecrement(_counts + (forWrite ? 2 : 1));
-    return giInterlockedDecrement(_counts);
+    MgLockRWImpl* p = _impl;
+    long ret;
+    
+    p->monitor.enter();
+    if (forWrite) {
+        p->writers--;
+        p->addHold(p->writeStart);
+        p->monitor.notifyAll();
+    }
+    else if (0 == --p->readers) {
+        p->addHold(p->readStart);
+        p->monitor.notifyAll();
+    }
+    _counts[forWrite ? 2 : 1]--;
+    ret = --_counts[0];
+    p->monitor.leave();
+    
+    return ret;
 }
 
 bool MgLockRW::firstLocked()
@@ -78,9 +251,65 @@ bool MgLockRW::lockedForWrite()
     return _counts[2] > 0;
 }
 
+MgLockStats MgLockRW::getStats() const
+{
+    _impl->monitor.enter();
+    MgLockStats stats(_impl->stats);
+    _impl->monitor.leave();
+    
+    return stats;
+}
+
+void MgLockRW::resetStats()
+{
+    _impl->monitor.enter();
+    _impl->stats = MgLockStats();
+    _impl->monitor.leave();
+}
+
 // MgShapesLock
 //
 
+static ShapeObservers   s_shapeObservers;   // 所有图形列表的写锁定观察者
+static MgLockRW         s_observersLock;
+
+// 通知所有图形列表的观察者和本图形列表的观察者，复制后再通知，以便在通知时登记观察者
+static void notifyObservers(MgShapes* sp, MgLockRWImpl* impl, bool locked)
+{
+    ShapeObservers observers;
+    
+    if (s_observersLock.lock(false)) {
+        observers = s_shapeObservers;
+        s_observersLock.unlock(false);
+    }
+    impl->monitor.enter();
+    observers.insert(observers.end(), impl->observers.begin(), impl->observers.end());
+    impl->monitor.leave();
+    
+    for (ShapeObservers::iterator it = observers.begin(); it != observers.end(); ++it) {
+        (it->first)(sp, it->second, locked);
+    }
+}
+
+static void addObserver(ShapeObservers& observers, MgShapesLock::ShapesLocked func, void* obj)
+{
+    for (ShapeObservers::iterator it = observers.begin(); it != observers.end(); ++it) {
+        if (it->first == func && it->second == obj)
+            return;
+    }
+    observers.push_back(ShapeObserver(func, obj));
+}
+
+static void removeObserver(ShapeObservers& observers, MgShapesLock::ShapesLocked func, void* obj)
+{
+    for (ShapeObservers::iterator it = observers.begin(); it != observers.end(); ++it) {
+        if (it->first == func && it->second == obj) {
+            observers.erase(it);
+            break;
+        }
+    }
+}
+
 MgShapesLock::MgShapesLock(MgShapes* sp, int flags, int timeout) : shapes(sp)
 {
     bool forWrite = (flags != 0);
@@ -89,10 +318,7 @@ MgShapesLock::MgShapesLock(MgShapes* sp, int flags, int timeout) : shapes(sp)
         m_mode |= 4;
     if (m_mode == 2 && shapes->getLockData()->firstLocked()) {
         shapes->getLockData()->setEditFlags(flags);
-        for (std::vector<ShapeObserver>::iterator it = s_shapeObservers.begin();
-             it != s_shapeObservers.end(); ++it) {
-            (it->first)(shapes, it->second, true);
-        }
+        notifyObservers(shapes, shapes->getLockData()->_impl, true);
     }
 }
 
@@ -105,29 +331,43 @@ MgShapesLock::~MgShapesLock()
     }
     if (m_mode == 2 && ended) {
         shapes->afterChanged();
-        for (std::vector<ShapeObserver>::iterator it = s_shapeObservers.begin();
-             it != s_shapeObservers.end(); ++it) {
-            (it->first)(shapes, it->second, false);
-        }
+        notifyObservers(shapes, shapes->getLockData()->_impl, false);
     }
 }
 
 void MgShapesLock::registerObserver(ShapesLocked func, void* obj)
 {
-    if (func) {
-        unregisterObserver(func, obj);
-        s_shapeObservers.push_back(ShapeObserver(func, obj));
+    if (func && s_observersLock.lock(true, 1000)) {
+        addObserver(s_shapeObservers, func, obj);
+        s_observersLock.unlock(true);
     }
 }
 
 void MgShapesLock::unregisterObserver(ShapesLocked func, void* obj)
 {
-    for (std::vector<ShapeObserver>::iterator it = s_shapeObservers.begin();
-         it != s_shapeObservers.end(); ++it) {
-        if (it->first == func && it->second == obj) {
-            s_shapeObservers.erase(it);
-            break;
-        }
+    if (s_observersLock.lock(true, 1000)) {
+        removeObserver(s_shapeObservers, func, obj);
+        s_observersLock.unlock(true);
+    }
+}
+
+void MgShapesLock::registerObserver(MgShapes* sp, ShapesLocked func, void* obj)
+{
+    if (sp && func) {
+        MgLockRWImpl* impl = sp->getLockData()->_impl;
+        impl->monitor.enter();
+        addObserver(impl->observers, func, obj);
+        impl->monitor.leave();
+    }
+}
+
+void MgShapesLock::unregisterObserver(MgShapes* sp, ShapesLocked func, void* obj)
+{
+    if (sp) {
+        MgLockRWImpl* impl = sp->getLockData()->_impl;
+        impl->monitor.enter();
+        removeObserver(impl->observers, func, obj);
+        impl->monitor.leave();
     }
 }
 
@@ -150,14 +390,20 @@ bool MgShapesLock::lockedForWrite(MgShapes* sp)
 //
 
 MgDynShapeLock::MgDynShapeLock(bool forWrite, int timeout)
+    : m_lock(mgGetCommandManager()->getDynamicShapeLock())
+{
+    m_mode = m_lock->lock(forWrite, timeout) ? (forWrite ? 2 : 1) : 0;
+}
+
+MgDynShapeLock::MgDynShapeLock(MgLockRW* lock, bool forWrite, int timeout) : m_lock(lock)
 {
-    m_mode = s_dynLock.lock(forWrite, timeout) ? (forWrite ? 2 : 1) : 0;
+    m_mode = m_lock && m_lock->lock(forWrite, timeout) ? (forWrite ? 2 : 1) : 0;
 }
 
 MgDynShapeLock::~MgDynShapeLock()
 {
     if (locked()) {
-        s_dynLock.unlock(m_mode == 2);
+        m_lock->unlock(m_mode == 2);
     }
 }
 
@@ -168,12 +414,22 @@ bool MgDynShapeLock::locked()
 
 bool MgDynShapeLock::lockedForRead()
 {
-    return s_dynLock.lockedForRead();
+    return mgGetCommandManager()->getDynamicShapeLock()->lockedForRead();
 }
 
 bool MgDynShapeLock::lockedForWrite()
 {
-    return s_dynLock.lockedForWrite();
+    return mgGetCommandManager()->getDynamicShapeLock()->lockedForWrite();
+}
+
+MgLockStats MgDynShapeLock::getStats()
+{
+    return mgGetCommandManager()->getDynamicShapeLock()->getStats();
+}
+
+void MgDynShapeLock::resetStats()
+{
+    mgGetCommandManager()->getDynamicShapeLock()->resetStats();
 }
 
 // mgCreateCommand, mgRegisterShapeCreator, mgCreateShape
@@ -204,39 +460,73 @@ MgCommand* mgCreateCommand(const char* name)
     return NULL;
 }
 
-static std::map<UInt32, MgShape* (*)()>   s_shapeCreators;
+// 图形创建函数表，注册时复制出新表再替换，创建图形时不用锁定
+typedef std::map<UInt32, MgShape* (*)()> ShapeCreators;
+static ShapeCreators* volatile  s_shapeCreators = NULL;
+static std::vector<ShapeCreators*> s_oldCreators;   // 替换掉的表，其他线程可能正在查找
+static MgLockRW     s_creatorsLock;                 // 注册时锁定
 
-static void registerCoreCreators()
+static void registerCoreCreators(ShapeCreators& creators)
 {
-    s_shapeCreators[MgShapeT<MgLine>::Type() % 10000] = MgShapeT<MgLine>::create;
-    s_shapeCreators[MgShapeT<MgRect>::Type() % 10000] = MgShapeT<MgRect>::create;
-    s_shapeCreators[MgShapeT<MgEllipse>::Type() % 10000] = MgShapeT<MgEllipse>::create;
-    s_shapeCreators[MgShapeT<MgRoundRect>::Type() % 10000] = MgShapeT<MgRoundRect>::create;
-    s_shapeCreators[MgShapeT<MgLines>::Type() % 10000] = MgShapeT<MgLines>::create;
-    s_shapeCreators[MgShapeT<MgSplines>::Type() % 10000] = MgShapeT<MgSplines>::create;
+    creators[MgShapeT<MgLine>::Type() % 10000] = MgShapeT<MgLine>::create;
+    creators[MgShapeT<MgRect>::Type() % 10000] = MgShapeT<MgRect>::create;
+    creators[MgShapeT<MgEllipse>::Type() % 10000] = MgShapeT<MgEllipse>::create;
+    creators[MgShapeT<MgRoundRect>::Type() % 10000] = MgShapeT<MgRoundRect>::create;
+    creators[MgShapeT<MgLines>::Type() % 10000] = MgShapeT<MgLines>::create;
+    creators[MgShapeT<MgSplines>::Type() % 10000] = MgShapeT<MgSplines>::create;
 }
 
-void mgRegisterShapeCreator(UInt32 type, MgShape* (*factory)())
+// 在锁定时替换创建函数表，factory为NULL则取消注册，type为0时只注册核心图形
+static const ShapeCreators* changeCreators(UInt32 type, MgShape* (*factory)())
 {
-    if (s_shapeCreators.empty()) {
-        registerCoreCreators();
-    }
-    type = type % 10000;
-    if (type > 20) {
-        if (factory) {
-            s_shapeCreators[type] = factory;
+    const ShapeCreators* ret = NULL;
+    
+    if (s_creatorsLock.lock(true, 1000)) {
+        ShapeCreators* old = s_shapeCreators;
+        
+        if (old && type == 0) {                     // 其他线程已注册核心图形
+            ret = old;
         }
         else {
-            s_shapeCreators.erase(type);
+            ShapeCreators* creators = old ? new ShapeCreators(*old) : new ShapeCreators;
+            
+            if (!old)
+                registerCoreCreators(*creators);
+            if (factory)
+                (*creators)[type] = factory;
+            else if (type != 0)
+                creators->erase(type);
+            
+            giMemoryBarrier();                      // 先填好新表再替换
+            s_shapeCreators = creators;
+            if (old)
+                s_oldCreators.push_back(old);
+            ret = creators;
         }
+        s_creatorsLock.unlock(true);
+    }
+    
+    return ret;
+}
+
+void mgRegisterShapeCreator(UInt32 type, MgShape* (*factory)())
+{
+    type = type % 10000;
+    if (type > 20) {
+        changeCreators(type, factory);
     }
 }
 
 MgShape* mgCreateShape(UInt32 type)
 {
-    if (s_shapeCreators.empty())
-        registerCoreCreators();
+    const ShapeCreators* creators = s_shapeCreators;
+    
+    giMemoryBarrier();
+    if (!creators)
+        creators = changeCreators(0, NULL);
+    if (!creators)
+        return NULL;
     
-    std::map<UInt32, MgShape* (*)()>::const_iterator it = s_shapeCreators.find(type % 10000);
-    return (it != s_shapeCreators.end()) ? (it->second)() : NULL;
+    ShapeCreators::const_iterator it = creators->find(type % 10000);
+    return (it != creators->end()) ? (it->second)() : NULL;
 }
@@ -131,6 +131,17 @@ float mgLineHalfWidthModel(const MgShape* shape, const MgMotion* sender)
     return mgLineHalfWidthModel(shape, sender->view->graph());
 }
 
+Box2d mgShapeDisplayBox(const MgShape* shape, GiGraphics* gs)
+{
+    Box2d rect(shape->shapec()->getExtent());
+    
+    if (gs) {       // 线宽一半再加上反走样的1像素
+        rect.inflate(mgLineHalfWidthModel(shape, gs) + gs->xf().displayToModel(1.f));
+    }
+    
+    return rect;
+}
+
 float mgDisplayMmToModel(float mm, GiGraphics* gs)
 {
     return gs->xf().displayToModel(mm, true);
@@ -456,6 +467,7 @@ bool MgCommandSelect::touchBegan(const MgMotion* sender)
     
     if (m_cloneShapes.empty()) {
         m_boxsel = true;
+        m_region.reset();
     }
     m_boxHandle = 99;
     
@@ -598,19 +610,11 @@ bool MgCommandSelect::touchMoved(const MgMotion* sender)
     
     if (m_cloneShapes.empty() && m_boxsel) {    // 没有选中图形时就滑动多选
         Box2d snap(sender->startPointM, sender->pointM);
-        void *it = NULL;
-        MgShape* shape = sender->view->shapes()->getFirstShape(it);
+        MgRegionQuery query(snap, !isIntersectMode(sender));
         
-        m_selIds.clear();
-        m_id = 0;
-        for (; shape; shape = sender->view->shapes()->getNextShape(it)) {
-            if (isIntersectMode(sender) ? shape->shape()->hitTestBox(snap)
-                : snap.contains(shape->shape()->getExtent())) {
-                m_selIds.push_back(shape->getID());
-                m_id = shape->getID();
-            }
-        }
-        sender->view->shapes()->freeIterator(it);
+        m_region.update(sender->view->shapes(), query);  // 只重新判断选择框变化部分的图形
+        m_selIds = m_region.getIDs();
+        m_id = m_region.getTopID();             // 选中图形中显示在最上面的
         sender->view->redraw(true);
     }
     
@@ -674,6 +678,7 @@ bool MgCommandSelect::applyCloneShapes(MgView* view, bool apply, bool addNewShap
 {
     bool changed = false;
     bool cloned = !m_cloneShapes.empty();
+    Box2d rect;
     
     if (!m_cloneShapes.empty()) {
         MgShapesLock locker(view->shapes(), !apply ? MgShapesLock::ReadOnly
@@ -696,8 +701,11 @@ bool MgCommandSelect::applyCloneShapes(MgView* view, bool apply, bool addNewShap
             else if (apply) {
                 MgShape* shape = i < m_selIds.size() ? view->shapes()->findShape(m_selIds[i]) : NULL;
                 if (shape) {
+                    rect.unionWith(mgShapeDisplayBox(shape, view->graph()));
                     shape->copy(*m_cloneShapes[i]);
                     shape->shape()->update();
+                    view->shapes()->shapeChanged(shape);
+                    rect.unionWith(mgShapeDisplayBox(shape, view->graph()));
                     changed = true;
                 }
             }
@@ -708,7 +716,8 @@ bool MgCommandSelect::applyCloneShapes(MgView* view, bool apply, bool addNewShap
         m_cloneShapes.clear();
     }
     if (changed) {
-        view->regen();
+        if (!rect.isEmpty())            // 新加的图形已由 shapeAdded() 显示
+            view->regenRect(rect);
         if (addNewShapes)
             view->selChanged();
     }
@@ -736,22 +745,32 @@ MgCommandSelect::kSelState MgCommandSelect::getSelectState(MgView* view)
     return state;
 }
 
+// 收集所有图形的ID
+struct SelectAllVisitor : public MgShapeVisitor
+{
+    std::vector<UInt32>*    ids;
+
+    SelectAllVisitor(std::vector<UInt32>* p) : ids(p) {}
+
+    bool visit(MgShape* shape) {
+        ids->push_back(shape->getID());
+        return true;
+    }
+};
+
 bool MgCommandSelect::selectAll(MgView* view)
 {
     size_t oldn = m_selIds.size();
-    void* it = NULL;
     
     m_selIds.clear();
     m_handleIndex = 0;
     m_insertPoint = false;
     m_boxsel = false;
     
-    for (MgShape* shape = view->shapes()->getFirstShape(it);
-         shape; shape = view->shapes()->getNextShape(it)) {
-        m_selIds.push_back(shape->getID());
-        m_id = shape->getID();
-    }
-    view->shapes()->freeIterator(it);
+    SelectAllVisitor visitor(&m_selIds);
+    
+    view->shapes()->traverse(visitor);
+    m_id = m_selIds.empty() ? m_id : m_selIds.back();
     view->redraw(false);
 
     if (oldn != m_selIds.size() || !m_selIds.empty())
@@ -764,11 +783,13 @@ bool MgCommandSelect::deleteSelection(MgView* view)
 {
     MgShapesLock locker(view->shapes(), MgShapesLock::Edit);
     int count = 0;
+    Box2d rect;
     
     applyCloneShapes(view, false);
     for (sel_iterator it = m_selIds.begin(); it != m_selIds.end(); ++it) {
         MgShape* shape = view->shapes()->removeShape(*it);
         if (shape) {
+            rect.unionWith(mgShapeDisplayBox(shape, view->graph()));
             shape->release();
             count++;
         }
@@ -778,7 +799,7 @@ bool MgCommandSelect::deleteSelection(MgView* view)
     m_handleIndex = 0;
     
     if (count > 0) {
-        view->regen();
+        view->regenRect(rect);
         view->selChanged();
     }
     
@@ -834,11 +855,13 @@ bool MgCommandSelect::deleteVertext(const MgMotion* sender)
     {
         MgShapesLock locker(sender->view->shapes(), MgShapesLock::Edit);
         MgBaseLines *lines = (MgBaseLines *)shape->shape();
+        Box2d rect(mgShapeDisplayBox(shape, sender->view->graph()));
         
         ret = lines->removePoint(m_handleIndex - 1);
         if (ret) {
             shape->shape()->update();
-            sender->view->regen();
+            sender->view->shapes()->shapeChanged(shape);
+            sender->view->regenRect(rect.unionWith(mgShapeDisplayBox(shape, sender->view->graph())));
             m_handleIndex = hitTestHandles(shape, m_ptNear, sender);
         }
     }
@@ -858,11 +881,13 @@ bool MgCommandSelect::insertVertext(const MgMotion* sender)
         MgShapesLock locker(sender->view->shapes(), MgShapesLock::Edit);
         MgBaseLines *lines = (MgBaseLines *)shape->shape();
         float dist = m_ptNear.distanceTo(shape->shape()->getPoint(m_segment));
+        Box2d rect(mgShapeDisplayBox(shape, sender->view->graph()));
         
         ret = dist > mgDisplayMmToModel(1, sender) && lines->insertPoint(m_segment, m_ptNear);
         if (ret) {
             shape->shape()->update();
-            sender->view->regen();
+            sender->view->shapes()->shapeChanged(shape);
+            sender->view->regenRect(rect.unionWith(mgShapeDisplayBox(shape, sender->view->graph())));
             m_handleIndex = hitTestHandles(shape, m_ptNear, sender);
         }
     }
@@ -880,11 +905,13 @@ bool MgCommandSelect::switchClosed(MgView* view)
     {
         MgShapesLock locker(view->shapes(), MgShapesLock::Edit);
         MgBaseLines *lines = (MgBaseLines *)shape->shape();
+        Box2d rect(mgShapeDisplayBox(shape, view->graph()));
         
         ret = lines->setClosed(!lines->isClosed());
         if (ret) {
             shape->shape()->update();
-            view->regen();
+            view->shapes()->shapeChanged(shape);
+            view->regenRect(rect.unionWith(mgShapeDisplayBox(shape, view->graph())));
         }
     }
     
@@ -8,6 +8,7 @@
 
 #include <mgcmd.h>
 #include <mgselect.h>
+#include <mgregion.h>
 #include <vector>
 
 //! 选择命令类
@@ -73,6 +74,7 @@ private:
 private:
     std::vector<UInt32>     m_selIds;           // 选中的图形的ID
     std::vector<MgShape*>   m_cloneShapes;      // 选中图形的复制对象
+    MgRegionSelection       m_region;           // 框选的增量查找结果
     UInt32                  m_id;               // 选中图形的ID
     Point2d                 m_ptNear;           // 图形上的最近点
     Point2d                 m_ptSnap;           // 捕捉点
@@ -0,0 +1,146 @@
+// mgdispcache.cpp: 实现图形列表的显示缓存类 MgDisplayCache
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include <mgdispcache.h>
+#include <mgshape.h>
+
+MgDisplayCache::MgDisplayCache()
+    : _shapes(NULL), _changeCount(0), _shapeCount(0), _pixel(0), _valid(false)
+{
+}
+
+MgDisplayCache::~MgDisplayCache()
+{
+}
+
+void MgDisplayCache::invalidate()
+{
+    _valid = false;
+}
+
+int MgDisplayCache::draw(MgShapes* shapes, GiGraphics& gs)
+{
+    if (!shapes)
+        return 0;
+
+    float pixel = gs.xf().displayToModel(1.f);
+
+    if (!_valid || _shapes != shapes
+        || _changeCount != shapes->getChangeCount()
+        || _shapeCount != shapes->getShapeCount()
+        || pixel < _pixel || pixel > _pixel * 4) {     // 简化级别不再适用
+        record(shapes, gs);
+    }
+
+    return _list.draw(gs);
+}
+
+// 将每个图形录制为显示列表中的一项
+struct RecordVisitor : public MgShapeVisitor
+{
+    GiDisplayList*  list;
+    GiGraphics*     gs;
+
+    RecordVisitor(GiDisplayList* l, GiGraphics* g) : list(l), gs(g) {}
+
+    bool visit(MgShape* sp) {
+        list->beginItem(sp->shape()->getExtent());
+        sp->draw(*gs);
+        list->endItem();
+        return true;
+    }
+};
+
+void MgDisplayCache::record(MgShapes* shapes, GiGraphics& gs)
+{
+    RecordVisitor visitor(&_list, &gs);
+
+    _list.clear();
+    if (gs.beginRecord(&_list)) {
+        shapes->traverse(visitor);
+        gs.endRecord();
+    }
+
+    _shapes = shapes;
+    _changeCount = shapes->getChangeCount();
+    _shapeCount = shapes->getShapeCount();
+    _pixel = gs.xf().displayToModel(1.f);
+    _valid = true;
+}
+
+// MgTileLayer
+//
+
+MgTileLayer::MgTileLayer(int tileSize, long maxBytes)
+    : _tiles(tileSize, maxBytes), _shapes(NULL), _changeCount(0), _invalidated(false)
+{
+}
+
+MgTileLayer::~MgTileLayer()
+{
+}
+
+void MgTileLayer::invalidate(const Box2d& rectM)
+{
+    _tiles.invalidate(rectM);
+    _invalidated = true;
+}
+
+void MgTileLayer::clear()
+{
+    _tiles.clear();
+}
+
+bool MgTileLayer::draw(MgShapes* shapes, GiGraphics& gs, int* rendered)
+{
+    if (rendered)
+        *rendered = 0;
+    if (!shapes)
+        return false;
+
+    if (_shapes != shapes
+        || (_changeCount != shapes->getChangeCount() && !_invalidated)) {
+        _tiles.clear();                     // 不知道改变了哪些图形
+    }
+    _shapes = shapes;
+    _changeCount = shapes->getChangeCount();
+    _invalidated = false;
+
+    return _tiles.draw(gs, this, rendered);
+}
+
+// 虚线等线型在瓦片边界处会重新开始，不能分块显示
+static bool isDashed(const MgShape* sp)
+{
+    int style = sp->contextc()->getLineStyle();
+    return style > kLineSolid && style < kLineNull;
+}
+
+// 按显示的图形类别显示剪裁框内的图形
+struct TilePaintVisitor : public MgShapeVisitor
+{
+    GiGraphics*     gs;
+    int             pass;
+    int             count;
+
+    TilePaintVisitor(GiGraphics* g, int p) : gs(g), pass(p), count(0) {}
+
+    bool visit(MgShape* sp) {
+        if (pass == GiTilePainter::kPaintAll
+            || isDashed(sp) == (pass == GiTilePainter::kPaintOverlay)) {
+            if (sp->draw(*gs))
+                count++;
+        }
+        return true;
+    }
+};
+
+int MgTileLayer::paint(GiGraphics& gs, int pass)
+{
+    TilePaintVisitor visitor(&gs, pass);
+
+    _shapes->queryExtent(gs.getClipModel(), visitor);
+
+    return visitor.count;
+}
@@ -7,7 +7,28 @@
 #include <mgbasicsp.h>
 #include <mgbase.h>
 
+// 以名称地址识别本类的对象。名称放在本文件的静态数组中，而不是用字符串常量，
+// 因为编译器和链接器会将内容相同的字符串常量合并为一个，其他命令类返回的同名常量可能是同一地址
+static const char s_name[] = "lines";
+
+MgStrokeFilter* mgGetStrokeFilter(MgCommand* cmd)
+{
+    return cmd && cmd->getName() == s_name ? &static_cast<MgCmdDrawLines*>(cmd)->m_filter : NULL;
+}
+
+// 按移动速度放大去点容差，返回模型长度，为0时不去点
+float MgCmdDrawLines::filterTolerance(const MgMotion* sender) const
+{
+    float mm = m_filter.tol;
+    
+    if (mm > 0 && m_filter.fastVelocity > 0 && m_filter.maxTol > mm) {
+        mm += (m_filter.maxTol - mm) * mgMin(1.f, sender->velocity / m_filter.fastVelocity);
+    }
+    return mm > 0 ? mgDisplayMmToModel(mm, sender) : 0;
+}
+
 MgCmdDrawLines::MgCmdDrawLines()
+    : m_coneValid(false), m_coneBase(0), m_coneMin(0), m_coneMax(0), m_farDist(0)
 {
 }
 
@@ -15,6 +36,11 @@ MgCmdDrawLines::~MgCmdDrawLines()
 {
 }
 
+const char* MgCmdDrawLines::getName() const
+{
+    return s_name;
+}
+
 bool MgCmdDrawLines::initialize(const MgMotion* sender)
 {
     return _initialize(MgShapeT<MgLines>::create, sender);
@@ -50,6 +76,8 @@ bool MgCmdDrawLines::touchBegan(const MgMotion* sender)
     dynshape()->shape()->setPoint(0, sender->startPointM);
     dynshape()->shape()->setPoint(1, sender->pointM);
     dynshape()->shape()->update();
+    m_filter.kept++;                    // 起点
+    resetCone(sender);
 
     return _touchBegan(sender);
 }
@@ -66,19 +94,24 @@ bool MgCmdDrawLines::touchMoved(const MgMotion* sender)
     
     if (m_step > 2 && dynshape()->shape()->isClosed() != closed) {
         lines->setClosed(closed);
-        if (closed)
+        if (closed) {
             lines->removePoint(m_step);
-        else
+            m_filter.dropped++;
+        }
+        else {
             lines->addPoint(sender->pointM);
+            resetCone(sender);
+        }
     }
     if (!closed) {
-        dynshape()->shape()->setPoint(m_step, sender->pointM);
-        if (m_step > 0 && canAddPoint(sender, false)) {
+        if (m_step > 0 && canAddPoint(sender, false)) {     // 上一个采样点需保留
             m_step++;
             if (m_step >= dynshape()->shape()->getPointCount()) {
                 ((MgBaseLines*)dynshape()->shape())->addPoint(sender->pointM);
             }
+            resetCone(sender);
         }
+        dynshape()->shape()->setPoint(m_step, sender->pointM);
     }
     dynshape()->shape()->update();
 
@@ -97,19 +130,28 @@ bool MgCmdDrawLines::touchEnded(const MgMotion* sender)
     
     if (m_step > 2 && dynshape()->shape()->isClosed() != closed) {
         lines->setClosed(closed);
-        if (closed)
+        if (closed) {
             lines->removePoint(m_step);
-        else
+            m_filter.dropped++;
+        }
+        else {
             lines->addPoint(sender->pointM);
+            resetCone(sender);
+        }
     }
     if (!closed) {
+        if (m_step > 0 && canAddPoint(sender, false)) {     // 上一个采样点需保留
+            m_step++;
+            if (m_step >= dynshape()->shape()->getPointCount())
+                lines->addPoint(sender->pointM);
+        }
         dynshape()->shape()->setPoint(m_step, sender->pointM);
         if (m_step > 0 && !canAddPoint(sender, true))
             lines->removePoint(m_step);
     }
     dynshape()->shape()->update();
     
-    if (m_step > 1) {
+    if (dynshape()->shape()->getPointCount() > 1) {     // 去点后可能只剩起点和终点
         _addshape(sender);
     }
     else {
@@ -120,24 +162,67 @@ bool MgCmdDrawLines::touchEnded(const MgMotion* sender)
     return _touchEnded(sender);
 }
 
-bool MgCmdDrawLines::canAddPoint(const MgMotion* /*sender*/, bool /*ended*/)
+// 在线去点：上一个采样点作为浮动终点，到锚点(倒数第二个顶点)之间的采样点都已去掉。
+// 新采样点在各去掉点的容差扇形的交集内时，浮动终点移到新采样点，否则保留上一个采样点。
+// ended 为 true 时检查最后的采样点是否离锚点足够远，否则去掉。
+bool MgCmdDrawLines::canAddPoint(const MgMotion* sender, bool ended)
 {
-    /*float minDist = mgDisplayMmToModel(3, sender);
-    Point2d endPt  = dynshape()->shape()->getPoint(m_step - 1);
-    float distToEnd = endPt.distanceTo(sender->pointM);
-    float turnAngle = 90;
+    float tol = filterTolerance(sender);
+    bool keep;
     
-    if (m_step > 1)
-    {
-        Point2d lastPt = dynshape()->shape()->getPoint(m_step - 2);
-        turnAngle = (endPt - lastPt).angleTo(sender->pointM - endPt);
-        turnAngle = mgRad2Deg(fabs(turnAngle));
+    if (ended) {
+        keep = (tol <= 0 || sender->pointM.distanceTo(
+            dynshape()->shape()->getPoint(m_step - 1)) > tol);
+    }
+    else {
+        keep = (tol <= 0 || !checkCone(sender->pointM, tol));
     }
+    if (keep)
+        m_filter.kept++;
+    else
+        m_filter.dropped++;
+    
+    return keep;
+}
+
+// 检查采样点是否在容差扇形内，在则收窄扇形
+bool MgCmdDrawLines::checkCone(const Point2d& pt, float tol)
+{
+    Vector2d vec(pt - dynshape()->shape()->getPoint(m_step - 1));
+    float dist = vec.length();
     
-    if (distToEnd < minDist * (ended ? 0.25 : 1))
+    if (dist < m_farDist)                       // 往回走了，去掉的点可能超差
         return false;
-    if (!ended && sin(turnAngle) * distToEnd < 5)
-        return false;*/
+    if (dist > tol) {
+        float angle = vec.angle2();
+        float halfw = asinf(tol / dist);
+        
+        if (!m_coneValid) {
+            m_coneValid = true;
+            m_coneBase = angle;
+            m_coneMin = -halfw;
+            m_coneMax = halfw;
+        }
+        else {
+            angle = mgToPI(angle - m_coneBase);
+            if (angle < m_coneMin || angle > m_coneMax)
+                return false;
+            m_coneMin = mgMax(m_coneMin, angle - halfw);
+            m_coneMax = mgMin(m_coneMax, angle + halfw);
+        }
+    }
+    m_farDist = mgMax(m_farDist, dist);
     
     return true;
 }
+
+// 以倒数第二个顶点为锚点，按当前采样点重新开始容差扇形
+void MgCmdDrawLines::resetCone(const MgMotion* sender)
+{
+    float tol = filterTolerance(sender);
+    
+    m_coneValid = false;
+    m_farDist = 0;
+    if (tol > 0)
+        checkCone(sender->pointM, tol);
+}
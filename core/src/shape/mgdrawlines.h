@@ -23,7 +23,7 @@ public:
     static MgCommand* Create() { return new MgCmdDrawLines; }
     
 private:
-    virtual const char* getName() const { return Name(); }
+    virtual const char* getName() const;
     virtual void release() { delete this; }
     
     virtual bool initialize(const MgMotion* sender);
@@ -34,7 +34,19 @@ private:
     virtual bool touchEnded(const MgMotion* sender);
     
 private:
+    friend MgStrokeFilter* mgGetStrokeFilter(MgCommand* cmd);
+    
+    float filterTolerance(const MgMotion* sender) const;
     bool canAddPoint(const MgMotion* sender, bool ended);
+    bool checkCone(const Point2d& pt, float tol);
+    void resetCone(const MgMotion* sender);
+    
+    bool    m_coneValid;    //!< 容差扇形是否已有约束
+    float   m_coneBase;     //!< 容差扇形的基准方向
+    float   m_coneMin;      //!< 容差扇形相对于基准方向的起始角度
+    float   m_coneMax;      //!< 容差扇形相对于基准方向的终止角度
+    float   m_farDist;      //!< 已去掉的采样点到锚点的最大距离
+    MgStrokeFilter  m_filter;   //!< 在线去点参数和统计
 };
 
 #endif // __GEOMETRY_MGCOMMAND_DRAW_LINES_H_
@@ -60,6 +60,7 @@ bool MgCmdDrawSplines::touchBegan(const MgMotion* sender)
     }
     else {
         lines->resize(2);
+        ((MgSplines*)lines)->setIncremental(true);  // 添加点时只重新计算末尾几段
         m_freehand = !sender->pressDrag;
         m_step = 1;
         dynshape()->shape()->setPoint(0, sender->startPointM);
@@ -90,7 +91,8 @@ bool MgCmdDrawSplines::touchEnded(const MgMotion* sender)
 {
     if (m_freehand) {
         if (m_step > 1) {
-            //MgSplines* splines = (MgSplines*)dynshape()->shape();
+            MgSplines* splines = (MgSplines*)dynshape()->shape();
+            splines->setIncremental(false);     // 整体重新计算切矢量
             //splines->smooth(mgLineHalfWidthModel(m_shape, sender) + mgDisplayMmToModel(1, sender));
             _addshape(sender);
         }
@@ -107,6 +109,7 @@ bool MgCmdDrawSplines::doubleClick(const MgMotion* sender)
 {
     if (!m_freehand) {
         if (m_step > 1) {
+            ((MgSplines*)dynshape()->shape())->setIncremental(false);
             _addshape(sender);
         }
         _delayClear();
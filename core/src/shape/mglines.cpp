@@ -5,13 +5,57 @@
 #include "mgbasicsp.h"
 #include <mgshape_.h>
 #include <mgnear.h>
+#include <mgcurv.h>
 #include <mgstorage.h>
+#include <gigraph.h>
+#include <gigraph_.h>
+#include <mglnrel.h>
+#include <mgrtree.h>
+#include <mgshapes.h>
+#include <algorithm>
+
+static const int kLodLevels = 4;            // 简化级别数
+static const float kLodMinRatio = 1.f / 2048;   // 最精细一级的容差与图形大小之比，每级放大4倍
+static const UInt32 kLodMinPoints = 16;     // 顶点数达到此数量才简化
+static const UInt32 kSegTreeMinCount = 64;  // 段数达到此数量才构造空间索引
+
+//! MgBaseLines 的各级简化顶点和曲线段空间索引
+/*! 多个线程可同时显示同一图形(读锁定的图形列表、共享图形的快照)，各项在锁外计算好后
+    在 s_lodLock 内发布，先写内容再写计数或指针，读取时不锁定。
+*/
+struct MgLinesLod
+{
+    volatile UInt32     counts[kLodLevels]; //!< 各级的顶点数，为0表示未计算
+    Point2d* volatile   points[kLodLevels]; //!< 各级的顶点，为NULL表示与原顶点相同
+    Vector2d* volatile  knotvs[kLodLevels]; //!< 各级的样条曲线切矢量
+    MgRTree* volatile   segments;           //!< 各段包络框的空间索引，对象为段序号加1
+
+    MgLinesLod() : segments(NULL)
+    {
+        for (int i = 0; i < kLodLevels; i++) {
+            counts[i] = 0;
+            points[i] = NULL;
+            knotvs[i] = NULL;
+        }
+    }
+
+    ~MgLinesLod()
+    {
+        for (int i = 0; i < kLodLevels; i++) {
+            delete[] points[i];
+            delete[] knotvs[i];
+        }
+        delete segments;
+    }
+};
+
+static MgLockRW s_lodLock;                  // 发布简化顶点等缓存时互斥
 
 // MgBaseLines
 //
 
 MgBaseLines::MgBaseLines()
-    : _points(NULL), _maxCount(0), _count(0), _closed(false)
+    : _points(NULL), _maxCount(0), _count(0), _closed(false), _lod(NULL)
 {
 }
 
@@ -19,6 +63,7 @@ MgBaseLines::~MgBaseLines()
 {
     if (_points)
         delete[] _points;
+    _clearLod();
 }
 
 UInt32 MgBaseLines::_getPointCount() const
@@ -48,6 +93,7 @@ void MgBaseLines::_copy(const MgBaseLines& src)
     for (UInt32 i = 0; i < _count; i++)
         _points[i] = src._points[i];
     _closed = src._closed;
+    _clearLod();
 
     __super::_copy(src);
 }
@@ -74,6 +120,7 @@ bool MgBaseLines::_isKindOf(UInt32 type) const
 void MgBaseLines::_update()
 {
     _extent.set(_count, _points);
+    _clearLod();
     __super::_update();
 }
 
@@ -81,6 +128,7 @@ void MgBaseLines::_transform(const Matrix2d& mat)
 {
     for (UInt32 i = 0; i < _count; i++)
         _points[i] *= mat;
+    _clearLod();
     __super::_transform(mat);
 }
 
@@ -88,6 +136,7 @@ void MgBaseLines::_clear()
 {
     _count = 0;
     _closed = false;
+    _clearLod();
     __super::_clear();
 }
 
@@ -106,7 +155,7 @@ bool MgBaseLines::resize(UInt32 count)
 {
     if (_maxCount < count)
     {
-        _maxCount = (count + 7) / 8 * 8;
+        _maxCount = (mgMax(count, _maxCount + _maxCount / 2) + 7) / 8 * 8;
 
         Point2d* pts = new Point2d[_maxCount];
 
@@ -181,10 +230,53 @@ bool MgBaseLines::_setHandlePoint(UInt32 index, const Point2d& pt, float tol)
     return true;
 }
 
+// 逐个检查空间索引找到的线段，距离相同时取序号小的，与逐段检查的结果一致
+struct LinesHitVisitor : public MgBaseLines::SegmentVisitor
+{
+    UInt32          count;
+    const Point2d*  points;
+    Point2d         pt;
+    float           tol;
+    float           distMin;
+    Point2d         nearpt;
+    Int32           segment;
+
+    LinesHitVisitor(UInt32 n, const Point2d* pts, const Point2d& pt_, float tol_)
+        : count(n), points(pts), pt(pt_), tol(tol_), distMin(_FLT_MAX), segment(-1) {}
+
+    void visit(UInt32 i) {
+        Point2d ptTemp;
+        float dist = mgPtToLine(points[i], points[(i + 1) % count], pt, ptTemp);
+
+        if (dist <= tol && (dist < distMin || (dist == distMin && (Int32)i < segment))) {
+            distMin = dist;
+            nearpt = ptTemp;
+            segment = i;
+        }
+    }
+};
+
+// 空间索引是否找到了线段
+struct AnySegmentVisitor : public MgBaseLines::SegmentVisitor
+{
+    bool    found;
+
+    AnySegmentVisitor() : found(false) {}
+    void visit(UInt32) { found = true; }
+};
+
 float MgBaseLines::_hitTest(const Point2d& pt, float tol, 
                             Point2d& nearpt, Int32& segment) const
 {
-    return mgLinesHit(_count, _points, _closed, pt, tol, nearpt, segment);
+    LinesHitVisitor visitor(_count, _points, pt, tol);
+    
+    if (!_findSegments(Box2d(pt, 2 * tol, 2 * tol), visitor))
+        return mgLinesHit(_count, _points, _closed, pt, tol, nearpt, segment);
+    
+    nearpt = visitor.nearpt;
+    segment = visitor.segment;
+    
+    return visitor.distMin;
 }
 
 bool MgBaseLines::_hitTestBox(const Box2d& rect) const
@@ -192,6 +284,10 @@ bool MgBaseLines::_hitTestBox(const Box2d& rect) const
     if (!__super::_hitTestBox(rect))
         return false;
     
+    AnySegmentVisitor visitor;
+    if (_findSegments(rect, visitor))
+        return visitor.found;
+    
     for (UInt32 i = 0; i + 1 < _count; i++) {
         if (Box2d(_points[i], _points[i + 1]).isIntersect(rect))
             return true;
@@ -212,8 +308,9 @@ bool MgBaseLines::_load(MgStorage* s)
 {
     _closed = s->readBool("closed", _closed);
     
+    // 点数不设上限，按保存的坐标个数检查，以免数据错误时开辟过大的数组
     UInt32 n = s->readUInt32("count");
-    if (n < 1 || n > 9999)
+    if (n < 1 || s->readFloatArray("points", NULL, 0) != (int)n * 2)
         return false;
     
     resize(n);
@@ -222,6 +319,109 @@ bool MgBaseLines::_load(MgStorage* s)
     return n == _count * 2;
 }
 
+void MgBaseLines::_clearLod()
+{
+    if (_lod) {
+        delete _lod;
+        _lod = NULL;
+    }
+}
+
+MgLinesLod* MgBaseLines::_getLod() const
+{
+    if (!_lod && s_lodLock.lock(true)) {
+        if (!_lod) {
+            MgLinesLod* lod = new MgLinesLod;
+            giMemoryBarrier();
+            const_cast<MgBaseLines*>(this)->_lod = lod;
+        }
+        s_lodLock.unlock(true);
+    }
+    giMemoryBarrier();
+    return _lod;
+}
+
+UInt32 MgBaseLines::_getLodPoints(const GiGraphics& gs, const Point2d*& pts,
+                                  const Vector2d** knotvs) const
+{
+    float size = mgMax(_extent.width(), _extent.height());
+    float tol = gs.xf().displayToModel(0.5f);   // 半个像素
+    int level = kLodLevels - 1;
+
+    pts = _points;
+    if (knotvs)
+        *knotvs = NULL;
+    if (_count < kLodMinPoints)                 // 记录显示列表时也按当前比例简化，放缩后重新记录
+        return _count;
+
+    for (; level >= 0; level--) {               // 找偏差不超过半个像素的最简级别
+        if (size * kLodMinRatio * (1 << (2 * level)) <= tol)
+            break;
+    }
+
+    MgLinesLod* lod = level < 0 ? NULL : _getLod();  // 显示时才计算，不改变图形内容
+    if (!lod)
+        return _count;
+
+    if (0 == lod->counts[level]) {
+        Int32* indices = new Int32[_count];
+        Point2d* simplified = NULL;
+        UInt32 count = mgSimplifyLines(_count, _points,
+            size * kLodMinRatio * (1 << (2 * level)), indices);
+
+        if (count < _count) {
+            simplified = new Point2d[count];
+            for (UInt32 i = 0; i < count; i++)
+                simplified[i] = _points[indices[i]];
+        }
+        delete[] indices;
+
+        if (s_lodLock.lock(true)) {             // 其他线程可能已算好
+            if (0 == lod->counts[level]) {
+                lod->points[level] = simplified;
+                giMemoryBarrier();
+                lod->counts[level] = count;
+                simplified = NULL;
+            }
+            s_lodLock.unlock(true);
+        }
+        delete[] simplified;
+        if (0 == lod->counts[level])
+            return _count;
+    }
+    giMemoryBarrier();
+
+    UInt32 n = lod->counts[level];
+    if (!lod->points[level])                    // 没有可去掉的顶点
+        return _count;
+
+    pts = lod->points[level];
+    if (knotvs) {
+        if (!lod->knotvs[level]) {
+            Vector2d* vs = new Vector2d[n];
+
+            mgCubicSplines(n, pts, vs, _closed ? kCubicLoop : 0);
+            if (s_lodLock.lock(true)) {
+                if (!lod->knotvs[level]) {
+                    giMemoryBarrier();
+                    lod->knotvs[level] = vs;
+                    vs = NULL;
+                }
+                s_lodLock.unlock(true);
+            }
+            delete[] vs;
+            giMemoryBarrier();
+            if (!lod->knotvs[level]) {
+                pts = _points;
+                return _count;
+            }
+        }
+        *knotvs = lod->knotvs[level];
+    }
+
+    return n;
+}
+
 // MgLines
 //
 
@@ -238,9 +438,119 @@ MgLines::~MgLines()
 bool MgLines::_draw(GiGraphics& gs, const GiContext& ctx) const
 {
     bool ret = false;
+    const Point2d* pts = NULL;
+    UInt32 n = _getLodPoints(gs, pts);
+    GiScratch<UInt32> segs(gs._scratch(), n == _count && !_closed ? n : 0);
+    Int32 nsegs = n == _count ? _findVisibleSegments(gs, segs.get()) : -1;
+
     if (_closed)
-        ret = gs.drawPolygon(&ctx, _count, _points);
+        ret = gs.drawPolygon(&ctx, n, pts);
+    else if (nsegs >= 0) {                      // 放大显示局部时
+        UInt32 start, count;
+        for (Int32 j = 0; (count = _nextRun(segs.get(), nsegs, j, start)) > 0; )
+            ret = gs.drawLines(&ctx, count, _points + start) || ret;
+    }
     else
-        ret = gs.drawLines(&ctx, _count, _points);
+        ret = gs.drawLines(&ctx, n, pts);
     return __super::_draw(gs, ctx) || ret;
 }
+
+// 将空间索引中的对象转为曲线段序号后回调
+struct SegmentTreeVisitor : public MgRTree::Visitor
+{
+    MgBaseLines::SegmentVisitor*    visitor;
+
+    SegmentTreeVisitor(MgBaseLines::SegmentVisitor* v) : visitor(v) {}
+    void found(void* item) { visitor->visit((UInt32)((size_t)item - 1)); }
+};
+
+bool MgBaseLines::_findSegments(const Box2d& rect, SegmentVisitor& visitor,
+                                const Vector2d* knotvs) const
+{
+    UInt32 n = (_closed && _count > 1) ? _count : _count - 1;
+    
+    if (_count < 2 || n < kSegTreeMinCount)
+        return false;
+    
+    MgLinesLod* lod = _getLod();                // 查找时才构造，不改变图形内容
+    if (!lod)
+        return false;
+    
+    if (!lod->segments) {
+        std::vector<void*> items(n);
+        std::vector<Box2d> boxes(n);
+        Point2d pts[4];
+        
+        for (UInt32 i = 0; i < n; i++) {
+            items[i] = (void*)(size_t)(i + 1);
+            if (knotvs) {
+                mgCubicSplineToBezier(_count, _points, knotvs, i, pts);
+                boxes[i].set(4, pts);
+            }
+            else {
+                boxes[i].set(_points[i], _points[(i + 1) % _count]);
+            }
+        }
+        MgRTree* segments = new MgRTree;
+        segments->load(n, &items.front(), &boxes.front());
+        if (s_lodLock.lock(true)) {
+            if (!lod->segments) {
+                giMemoryBarrier();
+                lod->segments = segments;
+                segments = NULL;
+            }
+            s_lodLock.unlock(true);
+        }
+        delete segments;
+        giMemoryBarrier();
+        if (!lod->segments)
+            return false;
+    }
+    
+    SegmentTreeVisitor treeVisitor(&visitor);
+    lod->segments->search(rect, treeVisitor);
+    
+    return true;
+}
+
+// 收集找到的曲线段序号
+struct SegmentCollector : public MgBaseLines::SegmentVisitor
+{
+    UInt32*     segs;
+    Int32       count;
+
+    SegmentCollector(UInt32* buf) : segs(buf), count(0) {}
+    void visit(UInt32 segment) { segs[count++] = segment; }
+};
+
+Int32 MgBaseLines::_findVisibleSegments(const GiGraphics& gs, UInt32* segs,
+                                        const Vector2d* knotvs) const
+{
+    Box2d clip(gs.getClipModel());
+    
+    SegmentCollector collector(segs);
+    
+    if (_closed || gs.isRecording()
+        || clip.contains(_extent) || !_findSegments(clip, collector, knotvs))
+        return -1;
+    
+    std::sort(segs, segs + collector.count);    // 按顶点次序连成几段
+    
+    return collector.count;
+}
+
+UInt32 MgBaseLines::_nextRun(const UInt32* segs, Int32 count, Int32& index, UInt32& start)
+{
+    if (index >= count)
+        return 0;
+    
+    start = segs[index++];
+    UInt32 n = 2;
+    
+    while (index < count && segs[index] == segs[index - 1] + 1) {
+        index++;                                // 与上一段相连
+        n++;
+    }
+    
+    return n;
+}
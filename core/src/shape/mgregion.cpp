@@ -0,0 +1,383 @@
+// mgregion.cpp: 实现区域查找条件 MgRegionQuery 和增量区域选择类 MgRegionSelection
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include <mgregion.h>
+#include <mglnrel.h>
+#include <algorithm>
+#include <iterator>
+
+// MgRegionQuery
+//
+
+// 判断一点是否在闭合图形的控制点折线内，射线法
+static bool ptInShape(const Point2d& pt, const MgBaseShape* shape)
+{
+    UInt32 n = shape->getPointCount();
+    bool inside = false;
+
+    for (UInt32 i = 0, j = n - 1; i < n; j = i++) {
+        Point2d a(shape->getPoint(i));
+        Point2d b(shape->getPoint(j));
+
+        if ((a.y > pt.y) != (b.y > pt.y)
+            && pt.x < (b.x - a.x) * (pt.y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+// 判断线段ab是否与多边形的边相交，proper为true时不包括端点重合
+static bool edgeCrossLasso(const Point2d& a, const Point2d& b,
+                           Int32 count, const Point2d* lasso, bool proper)
+{
+    for (Int32 i = 0; i < count; i++) {
+        const Point2d& c = lasso[i];
+        const Point2d& d = lasso[i + 1 < count ? i + 1 : 0];
+
+        if (proper ? mgIsIntersectProp(a, b, c, d) : mgIsIntersect(a, b, c, d))
+            return true;
+    }
+    return false;
+}
+
+bool MgRegionQuery::match(const MgBaseShape* shape) const
+{
+    Box2d extent(shape->getExtent());
+
+    if (!isLasso())
+        return contains ? box.contains(extent) : shape->hitTestBox(box);
+
+    if (contains ? !box.contains(extent) : !shape->hitTestBox(box))
+        return false;
+
+    UInt32 n = shape->getPointCount();
+    UInt32 edges = shape->isClosed() ? n : (n > 0 ? n - 1 : 0);
+    Int32 order;
+
+    if (contains) {                         // 所有控制点在套索内，且边不穿过套索
+        for (UInt32 i = 0; i < n; i++) {
+            if (kPtOutArea == mgPtInArea(shape->getPoint(i), count, lasso, order))
+                return false;
+        }
+        for (UInt32 i = 0; i < edges; i++) {
+            if (edgeCrossLasso(shape->getPoint(i), shape->getPoint((i + 1) % n),
+                               count, lasso, true))
+                return false;
+        }
+        return true;
+    }
+
+    for (UInt32 i = 0; i < n; i++) {        // 有控制点在套索内，或边与套索相交
+        if (kPtOutArea != mgPtInArea(shape->getPoint(i), count, lasso, order))
+            return true;
+    }
+    for (UInt32 i = 0; i < edges; i++) {
+        if (edgeCrossLasso(shape->getPoint(i), shape->getPoint((i + 1) % n),
+                           count, lasso, false))
+            return true;
+    }
+
+    return shape->isClosed() && n > 2 && ptInShape(lasso[0], shape);   // 套索在闭合图形内
+}
+
+// MgRegionSelection
+//
+
+MgRegionSelection::MgRegionSelection()
+    : _shapes(NULL), _changeCount(0), _contains(false), _valid(false)
+    , _scanAll(false), _changed(false), _incremental(false), _tested(0), _candidates(0)
+    , _topID(0), _topOrder(0)
+{
+}
+
+void MgRegionSelection::reset()
+{
+    _ids.clear();
+    _shapes = NULL;
+    _valid = false;
+    _scanAll = false;
+    _items.clear();
+    _topID = 0;
+    _topOrder = 0;
+}
+
+bool MgRegionSelection::update(MgShapes* shapes, const MgRegionQuery& query)
+{
+    _changed = false;
+    _tested = 0;
+    _incremental = (_valid && shapes && shapes == _shapes
+                    && shapes->getChangeCount() == _changeCount
+                    && !query.isLasso() && query.contains == _contains);
+
+    if (!shapes) {
+        _changed = !_ids.empty();
+        reset();
+        return _changed;
+    }
+    if (_incremental) {
+        Box2d strips[8];                    // 新框多出的部分和旧框去掉的部分
+        int grows = subtractBox(query.box, _box, strips);
+        int n = grows + subtractBox(_box, query.box, strips + grows);
+
+        _added.clear();
+        _removed.clear();
+        _candidates = 0;
+        if (_scanAll) {
+            scanDelta(shapes, query, strips, grows, n);
+        }
+        else {
+            for (int i = 0; i < n; i++)
+                queryDelta(shapes, query, strips[i], i < grows);
+
+            // 图形多为贯穿选择框的长图形时条带筛选不掉多少图形，本次拖动改为遍历全部图形
+            _scanAll = (_candidates > shapes->getShapeCount() / 4);
+        }
+        mergeChanges();
+    }
+    else {
+        queryAll(shapes, query);
+    }
+
+    _shapes = shapes;
+    _changeCount = shapes->getChangeCount();
+    _box = query.box;
+    _contains = query.contains;
+    _valid = !query.isLasso();
+
+    return _changed;
+}
+
+// 收集区域内的所有图形，query不为NULL时先判断是否符合区域条件
+struct MgRegionAllVisitor : public MgShapeVisitor
+{
+    std::vector<UInt32>*    ids;
+    const MgRegionQuery*    query;
+    MgShape*                last;           // 最后收集的图形，按显示次序即为最上面的图形
+
+    MgRegionAllVisitor(std::vector<UInt32>* p, const MgRegionQuery* q)
+        : ids(p), query(q), last(NULL) {}
+
+    bool visit(MgShape* shape) {
+        if (!query || query->match(shape->shapec())) {
+            ids->push_back(shape->getID());
+            last = shape;
+        }
+        return true;
+    }
+};
+
+void MgRegionSelection::queryAll(MgShapes* shapes, const MgRegionQuery& query)
+{
+    std::vector<UInt32> ids;
+    MgRegionAllVisitor visitor(&ids, _scanAll ? &query : NULL);
+
+    ids.reserve(_ids.size());
+    if (_scanAll)                           // 大部分图形都与选择框相交，不用空间索引
+        shapes->traverse(visitor);
+    else
+        shapes->queryRegion(query, visitor);
+    std::sort(ids.begin(), ids.end());
+
+    _tested = shapes->getShapeCount();
+    _items.clear();                         // 遍历全部图形时的缓存失效
+    _changed = (ids != _ids);
+    _ids.swap(ids);
+    _topID = visitor.last ? visitor.last->getID() : 0;
+    _topOrder = visitor.last ? shapes->getShapeOrder(visitor.last) : 0;
+}
+
+// 重新判断条带内可能改变选中状态的图形
+/* 图形的选中状态改变时其包络框必与新旧框之差相交，且新框多出的部分只可能增加选中的图形，
+   旧框去掉的部分只可能减少选中的图形，因此每个条带只需判断一部分图形。
+*/
+struct MgRegionDeltaVisitor : public MgShapeVisitor
+{
+    MgRegionSelection*      owner;
+    const MgRegionQuery*    query;
+    bool                    grow;           // 是新框多出的条带，只判断未选中的图形
+
+    MgRegionDeltaVisitor(MgRegionSelection* o, const MgRegionQuery* q, bool g)
+        : owner(o), query(q), grow(g) {}
+
+    bool visit(MgShape* shape) {
+        UInt32 id = shape->getID();
+        bool selected = std::binary_search(owner->_ids.begin(), owner->_ids.end(), id);
+
+        owner->_candidates++;
+        if (selected != grow) {
+            owner->_tested++;
+            if (query->match(shape->shapec()) != selected) {
+                (selected ? owner->_removed : owner->_added).push_back(id);
+                if (!selected)
+                    owner->checkTop(shape);
+            }
+        }
+        return true;
+    }
+};
+
+void MgRegionSelection::queryDelta(MgShapes* shapes, const MgRegionQuery& query,
+                                   const Box2d& delta, bool grow)
+{
+    MgRegionDeltaVisitor visitor(this, &query, grow);
+    Box2d box(delta);
+
+    box.inflate(Tol::gTol().equalPoint());  // 水平或垂直线段按容差判断相交
+    shapes->queryExtent(box, visitor);
+}
+
+// 按显示次序收集全部图形及其包络框和选中状态
+struct MgRegionCacheVisitor : public MgShapeVisitor
+{
+    MgRegionSelection*      owner;
+
+    MgRegionCacheVisitor(MgRegionSelection* o) : owner(o) {}
+
+    bool visit(MgShape* shape) {
+        owner->_items.push_back(shape);
+        owner->_extents.push_back(shape->shapec()->getExtent());
+        owner->_flags.push_back(std::binary_search(owner->_ids.begin(), owner->_ids.end(),
+                                                   shape->getID()));
+        return true;
+    }
+};
+
+// 判断未选中的图形是否与新框多出的条带相交
+/* 未选中的图形与旧框不相交，因此在相交模式下与新框相交就是与新框多出的某个条带相交，
+   只需与这些窄条带判断，比与整个新框判断时需检查的曲线段少。
+*/
+static bool hitStrips(const MgBaseShape* sp, const Box2d& extent,
+                      const Box2d* strips, int i, int grows)
+{
+    for (; i < grows; i++) {
+        if (extent.isIntersect(strips[i]) && sp->hitTestBox(strips[i]))
+            return true;
+    }
+    return false;
+}
+
+void MgRegionSelection::scanDelta(MgShapes* shapes, const MgRegionQuery& query,
+                                  const Box2d* strips, int grows, int count)
+{
+    Box2d boxes[8];
+    float tol = Tol::gTol().equalPoint();
+
+    for (int i = 0; i < count; i++) {       // 水平或垂直线段按容差判断相交，并限制在新框或旧框内
+        const Box2d& a = strips[i];
+        const Box2d& b = (i < grows) ? query.box : _box;
+
+        boxes[i] = Box2d(mgMax(a.xmin - tol, b.xmin), mgMax(a.ymin - tol, b.ymin),
+                         mgMin(a.xmax + tol, b.xmax), mgMin(a.ymax + tol, b.ymax));
+    }
+
+    if (_items.size() != shapes->getShapeCount()) {
+        MgRegionCacheVisitor visitor(this);
+
+        _items.clear();
+        _extents.clear();
+        _flags.clear();
+        shapes->traverse(visitor);
+    }
+
+    // 只判断包络框与可能改变选中状态的条带相交的图形，不必每次遍历图形列表
+    for (size_t k = 0; k < _items.size(); k++) {
+        const Box2d& extent = _extents[k];
+        bool selected = _flags[k];
+        int i = selected ? grows : 0;
+        int end = selected ? count : grows;
+
+        for (; i < end && !extent.isIntersect(boxes[i]); i++) ;
+        if (i == end)
+            continue;
+
+        MgShape* shape = _items[k];
+        const MgBaseShape* sp = shape->shapec();
+
+        _candidates++;
+        _tested++;
+        if (selected) {
+            if (!query.match(sp)) {
+                _removed.push_back(shape->getID());
+                _flags[k] = false;
+            }
+        }
+        else if (query.contains ? query.match(sp) : hitStrips(sp, extent, boxes, i, grows)) {
+            _added.push_back(shape->getID());
+            _flags[k] = true;
+            checkTop(shape);
+        }
+    }
+}
+
+void MgRegionSelection::mergeChanges()
+{
+    if (_added.empty() && _removed.empty())
+        return;
+
+    // 相邻条带在边界上重合，同一图形可能记录两次
+    std::sort(_added.begin(), _added.end());
+    _added.erase(std::unique(_added.begin(), _added.end()), _added.end());
+    std::sort(_removed.begin(), _removed.end());
+    _removed.erase(std::unique(_removed.begin(), _removed.end()), _removed.end());
+
+    std::vector<UInt32> ids;
+
+    ids.reserve(_ids.size() + _added.size());
+    std::set_difference(_ids.begin(), _ids.end(), _removed.begin(), _removed.end(),
+                        std::back_inserter(ids));
+    _ids.clear();
+    std::merge(ids.begin(), ids.end(), _added.begin(), _added.end(),
+               std::back_inserter(_ids));
+    _changed = true;
+
+    if (std::binary_search(_removed.begin(), _removed.end(), _topID))
+        findTop();                          // 最上面的图形不再选中
+}
+
+void MgRegionSelection::checkTop(const MgShape* shape)
+{
+    UInt32 order = _shapes->getShapeOrder(shape);
+
+    if (0 == _topID || order > _topOrder) {
+        _topID = shape->getID();
+        _topOrder = order;
+    }
+}
+
+void MgRegionSelection::findTop()
+{
+    _topID = 0;
+    _topOrder = 0;
+    for (size_t i = 0; i < _ids.size(); i++) {
+        const MgShape* shape = _shapes->findShape(_ids[i]);
+        if (shape)
+            checkTop(shape);
+    }
+}
+
+int MgRegionSelection::subtractBox(const Box2d& a, const Box2d& b, Box2d* strips)
+{
+    if (!a.isIntersect(b)) {
+        strips[0] = a;
+        return 1;
+    }
+
+    // 不用 Box2d::intersectWith()，以免很窄的框得到空交集
+    Box2d c(mgMax(a.xmin, b.xmin), mgMax(a.ymin, b.ymin),
+            mgMin(a.xmax, b.xmax), mgMin(a.ymax, b.ymax));
+    int n = 0;
+
+    if (a.ymax > c.ymax)                    // 上下两条带与a同宽，左右两条带与交集同高
+        strips[n++] = Box2d(a.xmin, c.ymax, a.xmax, a.ymax);
+    if (a.ymin < c.ymin)
+        strips[n++] = Box2d(a.xmin, a.ymin, a.xmax, c.ymin);
+    if (a.xmin < c.xmin)
+        strips[n++] = Box2d(a.xmin, c.ymin, c.xmin, c.ymax);
+    if (a.xmax > c.xmax)
+        strips[n++] = Box2d(c.xmax, c.ymin, a.xmax, c.ymax);
+
+    return n;
+}
@@ -3,8 +3,16 @@
 // License: LGPL, https://github.com/rhcad/touchvg
 
 #include "mgshape.h"
+#include <gidef.h>
 
-MgBaseShape::MgBaseShape()
+static volatile long s_changeCount = 0;     // 各图形共用的修改标记计数
+
+static UInt32 newChangeCount()
+{
+    return (UInt32)giInterlockedIncrement(&s_changeCount);
+}
+
+MgBaseShape::MgBaseShape() : _changeCount(newChangeCount())
 {
 }
 
@@ -15,6 +23,7 @@ MgBaseShape::~MgBaseShape()
 void MgBaseShape::_copy(const MgBaseShape& src)
 {
     _extent = src._extent;
+    _changeCount = newChangeCount();
 }
 
 bool MgBaseShape::_equals(const MgBaseShape&) const
@@ -34,6 +43,7 @@ Box2d MgBaseShape::_getExtent() const
 
 void MgBaseShape::_update()
 {
+    _changeCount = newChangeCount();
     if (!_extent.isNull()) {
         if (_extent.width() < Tol::gTol().equalPoint()) {
             _extent.inflate(Tol::gTol().equalPoint(), 0);
@@ -47,11 +57,13 @@ void MgBaseShape::_update()
 void MgBaseShape::_transform(const Matrix2d& mat)
 {
     _extent *= mat;
+    _changeCount = newChangeCount();
 }
 
 void MgBaseShape::_clear()
 {
     _extent.empty();
+    _changeCount = newChangeCount();
 }
 
 bool MgBaseShape::_draw(GiGraphics&, const GiContext&) const
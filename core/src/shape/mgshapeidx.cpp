@@ -0,0 +1,492 @@
+// mgshapeidx.cpp: 实现图形索引类 MgShapeIndex
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include <mgshapeidx.h>
+#include <mgrtree.h>
+#include <algorithm>
+#include <deque>
+
+#if (defined(_MSC_VER) && _MSC_VER >= 1600) || __cplusplus >= 201103L
+#include <unordered_map>
+#define MGHASHMAP std::unordered_map
+#else
+#include <map>
+#define MGHASHMAP std::map
+#endif
+
+struct MgShapeIndex::Impl
+{
+    struct Item {
+        Box2d   box;        // 空间索引中的包络框
+        UInt32  order;      // 加入次序
+        UInt32  id;         // 索引中的ID
+        UInt32  tag;        // 索引中的标识
+        bool    moved;      // 是否在 moved 中，空间索引中仍为原包络框
+    };
+    typedef MGHASHMAP<MgShape*, Item> ItemMap;
+    typedef MGHASHMAP<UInt32, MgShape*> IdMap;
+    typedef MGHASHMAP<UInt32, std::vector<MgShape*> > TagMap;
+    typedef ItemMap::value_type ItemPair;
+    typedef std::pair<ItemPair*, Box2d> Moved;
+    typedef MGHASHMAP<UInt32, Pending*> PendingMap;
+
+    ItemMap     items;
+    IdMap       ids;
+    TagMap      tags;
+    MgRTree     tree;
+    std::vector<Moved> moved;   // 暂缓更新空间索引的图形及其原包络框
+    std::deque<Pending> pendings;   // 待加载的图形，已取出的 mark 为0
+    PendingMap  pendingIds;     // 待加载图形的ID
+    MgRTree     pendingTree;    // 待加载图形的空间索引，含已取出的图形
+    UInt32      pendingTaken;   // 空间索引中已取出的图形个数
+    bool        pendingDirty;   // 是否需要重新构造待加载图形的空间索引
+    Box2d       pendingExtent;  // 待加载图形的包络框
+    bool        extentDirty;    // 取出了包络框边上的图形，需重新计算 pendingExtent
+    bool        spatial;    // 是否已建立空间索引
+    UInt32      order;      // 下一个加入次序
+    UInt32      maxID;      // 已分配过的最大ID
+
+    Impl() : pendingTaken(0), pendingDirty(false), extentDirty(false)
+        , spatial(false), order(0), maxID(0) {}
+
+    void addTag(MgShape* shape, UInt32 tag)
+    {
+        if (tag != 0)
+            tags[tag].push_back(shape);
+    }
+
+    void removeTag(MgShape* shape, UInt32 tag)
+    {
+        TagMap::iterator it = tag ? tags.find(tag) : tags.end();
+
+        if (it != tags.end()) {
+            std::vector<MgShape*>& arr = it->second;
+            arr.erase(std::remove(arr.begin(), arr.end(), shape), arr.end());
+            if (arr.empty())
+                tags.erase(it);
+        }
+    }
+
+    void addID(MgShape* shape, UInt32 id)
+    {
+        ids[id] = shape;
+        if (maxID < id)
+            maxID = id;
+    }
+
+    void removeID(MgShape* shape, UInt32 id)
+    {
+        IdMap::iterator it = ids.find(id);
+        if (it != ids.end() && it->second == shape)
+            ids.erase(it);
+    }
+
+    void buildPending()
+    {
+        std::vector<void*> items;
+        std::vector<Box2d> boxes;
+
+        for (std::deque<Pending>::iterator it = pendings.begin();
+             it != pendings.end(); ++it) {
+            if (it->mark) {
+                items.push_back(&*it);
+                boxes.push_back(it->box);
+            }
+        }
+        pendingTree.load((UInt32)items.size(), items.empty() ? NULL : &items.front(),
+                         boxes.empty() ? NULL : &boxes.front());
+        pendingTaken = 0;
+        pendingDirty = false;
+    }
+
+    // 图形重叠较多时从R树中逐个删除较慢，故只作标记，过半已取出时再重新构造
+    void takePending(Pending* p, std::vector<Pending>& items)
+    {
+        const Box2d& box = p->box;
+
+        items.push_back(*p);
+        pendingIds.erase(p->id);
+        p->mark = 0;
+        pendingTaken++;
+        if (!(box.xmin > pendingExtent.xmin && box.ymin > pendingExtent.ymin
+              && box.xmax < pendingExtent.xmax && box.ymax < pendingExtent.ymax)) {
+            extentDirty = true;
+        }
+    }
+
+    void endTaking()
+    {
+        if (pendingIds.empty()) {
+            pendings.clear();
+            pendingTree.clear();
+            pendingTaken = 0;
+            pendingDirty = false;
+            pendingExtent.empty();
+            extentDirty = false;
+        }
+        else if (pendingTaken > pendingIds.size()) {
+            pendingDirty = true;
+        }
+    }
+
+    struct OrderLess {
+        bool operator()(void* a, void* b) const {
+            return ((ItemPair*)a)->second.order < ((ItemPair*)b)->second.order;
+        }
+    };
+
+    struct PendingLess {
+        bool operator()(const Pending& a, const Pending& b) const {
+            return a.order < b.order;
+        }
+    };
+};
+
+MgShapeIndex::MgShapeIndex() : _impl(new Impl)
+{
+}
+
+MgShapeIndex::~MgShapeIndex()
+{
+    delete _impl;
+}
+
+void MgShapeIndex::clear()
+{
+    _impl->tree.clear();
+    _impl->moved.clear();
+    _impl->items.clear();
+    _impl->ids.clear();
+    _impl->tags.clear();
+    _impl->pendings.clear();
+    _impl->pendingIds.clear();
+    _impl->pendingTree.clear();
+    _impl->pendingTaken = 0;
+    _impl->pendingDirty = false;
+    _impl->pendingExtent.empty();
+    _impl->extentDirty = false;
+    _impl->spatial = false;
+    _impl->order = 0;
+    _impl->maxID = 0;
+}
+
+UInt32 MgShapeIndex::getCount() const
+{
+    return (UInt32)_impl->items.size();
+}
+
+void MgShapeIndex::addShape(MgShape* shape, bool deferSpatial)
+{
+    addItem(shape, _impl->order++, deferSpatial);
+}
+
+void MgShapeIndex::addShape(MgShape* shape, const Pending& item)
+{
+    addItem(shape, item.order, false);
+}
+
+void MgShapeIndex::addItem(MgShape* shape, UInt32 order, bool deferSpatial)
+{
+    if (_impl->items.find(shape) != _impl->items.end())
+        removeShape(shape);
+
+    Impl::ItemPair& pair = *_impl->items.insert(
+        Impl::ItemPair(shape, Impl::Item())).first;
+    Impl::Item& item = pair.second;
+
+    item.box = shape->shape()->getExtent();
+    item.moved = false;
+    item.order = order;
+    item.id = shape->getID();
+    item.tag = shape->getTag();
+    _impl->addID(shape, item.id);
+    _impl->addTag(shape, item.tag);
+
+    if (!deferSpatial) {
+        if (_impl->spatial)
+            _impl->tree.insert(&pair, item.box);
+        else
+            buildSpatial();
+    }
+}
+
+bool MgShapeIndex::removeShape(MgShape* shape)
+{
+    Impl::ItemMap::iterator it = _impl->items.find(shape);
+
+    if (it == _impl->items.end())
+        return false;
+
+    if (_impl->spatial) {
+        Box2d box(it->second.box);
+
+        if (it->second.moved) {     // 空间索引中为暂缓更新前的包络框
+            for (std::vector<Impl::Moved>::iterator m = _impl->moved.begin();
+                 m != _impl->moved.end(); ++m) {
+                if (m->first == &*it) {
+                    box = m->second;
+                    _impl->moved.erase(m);
+                    break;
+                }
+            }
+        }
+        _impl->tree.remove(&*it, box);
+    }
+    _impl->removeID(shape, it->second.id);
+    _impl->removeTag(shape, it->second.tag);
+    _impl->items.erase(it);
+
+    return true;
+}
+
+bool MgShapeIndex::updateShape(MgShape* shape, bool deferSpatial)
+{
+    Impl::ItemMap::iterator it = _impl->items.find(shape);
+
+    if (it == _impl->items.end()) {
+        addShape(shape);
+        return true;
+    }
+
+    Impl::Item& item = it->second;
+    Box2d box(shape->shape()->getExtent());
+    bool changed = false;
+
+    if (item.id != shape->getID()) {
+        _impl->removeID(shape, item.id);
+        item.id = shape->getID();
+        _impl->addID(shape, item.id);
+        changed = true;
+    }
+    if (item.tag != shape->getTag()) {
+        _impl->removeTag(shape, item.tag);
+        item.tag = shape->getTag();
+        _impl->addTag(shape, item.tag);
+        changed = true;
+    }
+    if (box.xmin != item.box.xmin || box.ymin != item.box.ymin
+        || box.xmax != item.box.xmax || box.ymax != item.box.ymax)
+    {
+        if (_impl->spatial && item.moved) {
+            // 已暂缓过，空间索引中仍为最初的包络框，flushSpatial() 时一起更新
+        }
+        else if (_impl->spatial && deferSpatial) {
+            _impl->moved.push_back(Impl::Moved(&*it, item.box));
+            item.moved = true;
+        }
+        else if (_impl->spatial) {
+            _impl->tree.remove(&*it, item.box);
+            _impl->tree.insert(&*it, box);
+        }
+        item.box = box;
+        changed = true;
+    }
+
+    return changed;
+}
+
+void MgShapeIndex::flushSpatial()
+{
+    if (_impl->moved.size() > getCount() / 16) {
+        buildSpatial();
+    }
+    else {
+        for (std::vector<Impl::Moved>::iterator it = _impl->moved.begin();
+             it != _impl->moved.end(); ++it) {
+            _impl->tree.remove(it->first, it->second);
+            _impl->tree.insert(it->first, it->first->second.box);
+            it->first->second.moved = false;
+        }
+        _impl->moved.clear();
+    }
+}
+
+void MgShapeIndex::buildSpatial()
+{
+    UInt32 count = getCount();
+
+    _impl->moved.clear();
+    if (_impl->pendingDirty)
+        _impl->buildPending();
+    if (count + getPendingCount() < kMinShapes && !_impl->spatial)
+        return;
+
+    std::vector<void*> items;
+    std::vector<Box2d> boxes;
+
+    items.reserve(count);
+    boxes.reserve(count);
+    for (Impl::ItemMap::iterator it = _impl->items.begin();
+         it != _impl->items.end(); ++it) {
+        items.push_back(&*it);
+        boxes.push_back(it->second.box);
+        it->second.moved = false;
+    }
+    _impl->tree.load(count, count ? &items.front() : NULL,
+                     count ? &boxes.front() : NULL);
+    _impl->spatial = true;
+}
+
+bool MgShapeIndex::hasSpatial() const
+{
+    return _impl->spatial;
+}
+
+MgShape* MgShapeIndex::findShape(UInt32 nID) const
+{
+    Impl::IdMap::const_iterator it = _impl->ids.find(nID);
+    return it != _impl->ids.end() ? it->second : NULL;
+}
+
+MgShape* MgShapeIndex::findShapeByTag(UInt32 tag) const
+{
+    Impl::TagMap::const_iterator it = _impl->tags.find(tag);
+    return it != _impl->tags.end() ? it->second.front() : NULL;
+}
+
+UInt32 MgShapeIndex::getNewID(UInt32 nID) const
+{
+    if (0 == nID || findShape(nID)
+        || _impl->pendingIds.find(nID) != _impl->pendingIds.end()) {
+        nID = _impl->maxID + 1;
+    }
+    return nID;
+}
+
+UInt32 MgShapeIndex::query(const Box2d& box, std::vector<MgShape*>& shapes) const
+{
+    std::vector<void*> found;
+
+    shapes.clear();
+    query(box, found);
+
+    shapes.reserve(found.size());
+    for (std::vector<void*>::const_iterator it = found.begin();
+         it != found.end(); ++it) {
+        shapes.push_back(getShape(*it));
+    }
+
+    return (UInt32)shapes.size();
+}
+
+UInt32 MgShapeIndex::query(const Box2d& box, std::vector<void*>& items) const
+{
+    items.clear();
+    _impl->tree.search(box, items);
+    std::sort(items.begin(), items.end(), Impl::OrderLess());
+
+    return (UInt32)items.size();
+}
+
+MgShape* MgShapeIndex::getShape(const void* item)
+{
+    return ((const Impl::ItemPair*)item)->first;
+}
+
+UInt32 MgShapeIndex::getOrder(const MgShape* shape) const
+{
+    Impl::ItemMap::const_iterator it = _impl->items.find(const_cast<MgShape*>(shape));
+    return it != _impl->items.end() ? it->second.order : 0;
+}
+
+UInt32 MgShapeIndex::addPending(UInt32 type, UInt32 id, const Box2d& box, UInt32 mark)
+{
+    Pending item;
+
+    item.type = type;
+    item.id = getNewID(id);
+    item.order = _impl->order++;
+    item.mark = mark;
+    item.box = box;
+
+    _impl->pendings.push_back(item);
+    _impl->pendingIds[item.id] = &_impl->pendings.back();
+    _impl->pendingDirty = true;
+    _impl->pendingExtent.unionWith(box);
+    if (_impl->maxID < item.id)
+        _impl->maxID = item.id;
+
+    return item.id;
+}
+
+UInt32 MgShapeIndex::getPendingCount() const
+{
+    return (UInt32)_impl->pendingIds.size();
+}
+
+Box2d MgShapeIndex::getPendingExtent() const
+{
+    return _impl->pendingExtent;
+}
+
+bool MgShapeIndex::isPendingExtentDirty() const
+{
+    return _impl->extentDirty;
+}
+
+void MgShapeIndex::updatePendingExtent()
+{
+    if (_impl->extentDirty) {
+        _impl->pendingExtent.empty();
+        for (std::deque<Pending>::const_iterator it = _impl->pendings.begin();
+             it != _impl->pendings.end(); ++it) {
+            if (it->mark)
+                _impl->pendingExtent.unionWith(it->box);
+        }
+        _impl->extentDirty = false;
+    }
+}
+
+UInt32 MgShapeIndex::takePending(const Box2d& box, std::vector<Pending>& items)
+{
+    std::vector<void*> found;
+
+    items.clear();
+    if (_impl->pendingIds.empty())
+        return 0;
+    if (_impl->pendingDirty)
+        _impl->buildPending();
+
+    _impl->pendingTree.search(box, found);
+    items.reserve(found.size());
+    for (std::vector<void*>::const_iterator it = found.begin();
+         it != found.end(); ++it) {
+        if (((Pending*)*it)->mark)
+            _impl->takePending((Pending*)*it, items);
+    }
+    std::sort(items.begin(), items.end(), Impl::PendingLess());
+    _impl->endTaking();
+
+    return (UInt32)items.size();
+}
+
+UInt32 MgShapeIndex::takePending(std::vector<Pending>& items)
+{
+    items.clear();
+    items.reserve(_impl->pendingIds.size());
+    for (std::deque<Pending>::const_iterator it = _impl->pendings.begin();
+         it != _impl->pendings.end(); ++it) {
+        if (it->mark)
+            items.push_back(*it);
+    }
+    _impl->pendingIds.clear();
+    _impl->endTaking();
+
+    return (UInt32)items.size();
+}
+
+bool MgShapeIndex::takePending(UInt32 nID, Pending& item)
+{
+    Impl::PendingMap::iterator it = _impl->pendingIds.find(nID);
+    std::vector<Pending> items;
+
+    if (it == _impl->pendingIds.end())
+        return false;
+
+    _impl->takePending(it->second, items);
+    _impl->endTaking();
+    item = items.front();
+
+    return true;
+}
@@ -0,0 +1,219 @@
+// mgsnapshot.cpp: 实现图形列表的只读快照类 MgShapesSnapshot 和快照发布类 MgSnapshotStore
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include <mgsnapshot.h>
+#include <mgshape.h>
+#include <gigraph.h>
+#include <map>
+
+// MgShapesSnapshot
+//
+
+const MgShape* MgShapesSnapshot::getShape(UInt32 index) const
+{
+    return index < _nodes.size() ? _nodes[index]->shape : NULL;
+}
+
+int MgShapesSnapshot::draw(GiGraphics& gs, const GiContext *ctx) const
+{
+    Box2d clip(gs.getClipModel());
+    int count = 0;
+
+    for (std::vector<Node*>::const_iterator it = _nodes.begin();
+         it != _nodes.end(); ++it) {
+        if ((*it)->extent.isIntersect(clip) && (*it)->shape->draw(gs, ctx))
+            count++;
+    }
+
+    return count;
+}
+
+// MgSnapshotStore
+//
+
+MgSnapshotStore::MgSnapshotStore()
+    : _current(NULL), _epoch(1), _version(0), _shared(0), _copied(0)
+{
+    for (int i = 0; i < kMaxReaders; i++) {
+        _readerEpochs[i] = 0;
+        _registered[i] = false;
+    }
+}
+
+MgSnapshotStore::~MgSnapshotStore()
+{
+    for (size_t i = 0; i < _retired.size(); i++)
+        freeSnapshot(_retired[i]);
+    if (_current)
+        freeSnapshot(_current);
+}
+
+void MgSnapshotStore::freeSnapshot(MgShapesSnapshot* snapshot)
+{
+    for (std::vector<MgShapesSnapshot::Node*>::iterator it = snapshot->_nodes.begin();
+         it != snapshot->_nodes.end(); ++it) {
+        if (0 == --(*it)->refcount) {       // 图形不再被其他版本共用
+            (*it)->shape->release();
+            delete *it;
+        }
+    }
+    delete snapshot;
+}
+
+// 发布时逐个复制或共用图形
+struct MgSnapshotPublisher : public MgShapeVisitor
+{
+    typedef MgShapesSnapshot::Node Node;
+
+    const MgShapesSnapshot* prev;
+    std::vector<Node*>*     nodes;
+    Box2d*                  extent;
+    std::map<UInt32, Node*> prevNodes;      // 上一版本中与原次序不一致时才用
+    size_t                  hint;
+    UInt32                  shared;
+    UInt32                  copied;
+
+    MgSnapshotPublisher(const MgShapesSnapshot* p, std::vector<Node*>* n, Box2d* e)
+        : prev(p), nodes(n), extent(e), hint(0), shared(0), copied(0) {}
+
+    bool visit(MgShape* sp) {
+        Node* node = NULL;
+
+        if (prev && hint < prev->_nodes.size()                 // 通常次序不变
+            && prev->_nodes[hint]->shape->getID() == sp->getID()) {
+            node = prev->_nodes[hint++];
+        }
+        else if (prev) {
+            if (prevNodes.empty()) {
+                for (size_t i = 0; i < prev->_nodes.size(); i++)
+                    prevNodes[prev->_nodes[i]->shape->getID()] = prev->_nodes[i];
+            }
+            std::map<UInt32, Node*>::const_iterator found = prevNodes.find(sp->getID());
+            node = found != prevNodes.end() ? found->second : NULL;
+        }
+
+        if (node && node->source == sp
+            && node->changeCount == sp->shapec()->getChangeCount()
+            && node->shape->getTag() == sp->getTag()
+            && *node->shape->contextc() == *sp->contextc()) {
+            node->refcount++;                                   // 未改变，共用
+            shared++;
+        }
+        else {
+            node = new Node;
+            node->shape = (MgShape*)sp->clone();
+            node->shape->setParent(NULL, sp->getID());
+            node->source = sp;
+            node->changeCount = sp->shapec()->getChangeCount();
+            node->extent = node->shape->shapec()->getExtent();
+            node->refcount = 1;
+            copied++;
+        }
+        nodes->push_back(node);
+        extent->unionWith(node->extent);
+
+        return true;
+    }
+};
+
+const MgShapesSnapshot* MgSnapshotStore::publish(MgShapes* shapes)
+{
+    MgShapesSnapshot* prev = _current;
+    MgShapesSnapshot* snapshot = new MgShapesSnapshot;
+    MgSnapshotPublisher visitor(prev, &snapshot->_nodes, &snapshot->_extent);
+
+    snapshot->_version = ++_version;
+    if (shapes) {
+        snapshot->_nodes.reserve(shapes->getShapeCount());
+        snapshot->_xf = shapes->modelTransform();
+        shapes->traverse(visitor);
+    }
+    _shared = visitor.shared;
+    _copied = visitor.copied;
+
+    _current = snapshot;                    // 此后开始读取的读者得到新版本
+    giMemoryBarrier();
+    if (prev) {
+        prev->_retiredEpoch = _epoch;
+        _retired.push_back(prev);
+    }
+    giInterlockedIncrement(&_epoch);
+    giMemoryBarrier();
+    reclaim();
+
+    return snapshot;
+}
+
+int MgSnapshotStore::reclaim()
+{
+    long minEpoch = _epoch;
+    int count = 0;
+
+    giMemoryBarrier();
+    for (int i = 0; i < kMaxReaders; i++) {     // 正在读取的读者的最早纪元
+        long e = _readerEpochs[i];
+        if (e != 0 && minEpoch > e)
+            minEpoch = e;
+    }
+
+    // 读者在纪元e开始读取时，可能取得在纪元e及以后替换的版本
+    std::vector<MgShapesSnapshot*>::iterator it = _retired.begin();
+    while (it != _retired.end()) {
+        if ((*it)->_retiredEpoch < minEpoch) {
+            freeSnapshot(*it);
+            it = _retired.erase(it);
+            count++;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return count;
+}
+
+int MgSnapshotStore::registerReader()
+{
+    int reader = -1;
+
+    if (_readersLock.lock(true)) {
+        for (int i = 0; i < kMaxReaders && reader < 0; i++) {
+            if (!_registered[i]) {
+                _registered[i] = true;
+                reader = i;
+            }
+        }
+        _readersLock.unlock(true);
+    }
+
+    return reader;
+}
+
+void MgSnapshotStore::unregisterReader(int reader)
+{
+    if (reader >= 0 && reader < kMaxReaders && _readersLock.lock(true)) {
+        _readerEpochs[reader] = 0;
+        _registered[reader] = false;
+        _readersLock.unlock(true);
+    }
+}
+
+const MgShapesSnapshot* MgSnapshotStore::acquire(int reader)
+{
+    if (reader < 0 || reader >= kMaxReaders)
+        return NULL;
+
+    _readerEpochs[reader] = _epoch;         // 先公布开始读取的纪元，再读取当前版本
+    giMemoryBarrier();
+
+    return _current;
+}
+
+void MgSnapshotStore::release(int reader)
+{
+    if (reader >= 0 && reader < kMaxReaders) {
+        giMemoryBarrier();
+        _readerEpochs[reader] = 0;
+    }
+}
@@ -6,10 +6,14 @@
 #include <mgshape_.h>
 #include <mgnear.h>
 #include <mgcurv.h>
+#include <gigraph_.h>
 
 MG_IMPLEMENT_CREATE(MgSplines)
 
-MgSplines::MgSplines() : _knotvs(NULL), _bzcount(0)
+static const UInt32 kIncWindow = 8;     // 增量计算时重新计算切矢量的末尾点数
+
+MgSplines::MgSplines()
+    : _knotvs(NULL), _bzcount(0), _incremental(false), _solved(0), _frozen(0)
 {
 }
 
@@ -19,55 +23,314 @@ MgSplines::~MgSplines()
         delete[] _knotvs;
 }
 
-void MgSplines::_update()
+void MgSplines::setIncremental(bool incremental)
 {
-    __super::_update();
+    _incremental = incremental;
+    _solved = 0;
+    _frozen = 0;
+    if (!incremental)
+        update();
+}
 
+void MgSplines::_update()
+{
     if (_bzcount < _count)
     {
+        Vector2d* knotvs = new Vector2d[_maxCount];
+        
+        for (UInt32 i = 0; i < _solved && i < _bzcount; i++)
+            knotvs[i] = _knotvs[i];
         if (_knotvs)
             delete[] _knotvs;
         _bzcount = _maxCount;
-        _knotvs = new Vector2d[_bzcount];
+        _knotvs = knotvs;
     }
+    
+    if (!_updateTail())
+    {
+        __super::_update();
+        mgCubicSplines(_count, _points, _knotvs, _closed ? kCubicLoop : 0);
+        mgCubicSplinesBox(_extent, _count, _points, _knotvs);
+        _solved = _count;
+        _frozen = 0;
+    }
+}
 
-    mgCubicSplines(_count, _points, _knotvs, _closed ? kCubicLoop : 0);
-    mgCubicSplinesBox(_extent, _count, _points, _knotvs);
+bool MgSplines::_updateTail()
+{
+    if (!_incremental || _closed || _count < kIncWindow + 2)
+        return false;
+    
+    // 前面的型值点的切矢量已算好，只在末尾 kIncWindow+1 个点的范围内重新计算
+    UInt32 start = _count - 1 - kIncWindow;
+    Box2d box;
+    
+    if (start >= _solved || start < _frozen)    // 一次添加了多个点，或删除了点
+        return false;
+    
+    if (start > _frozen) {                      // 起始夹持点之前的曲线段不再改变
+        mgCubicSplinesBox(box, start - _frozen + 1, _points + _frozen, _knotvs + _frozen);
+        if (_frozen == 0)
+            _frozenBox = box;
+        else {
+            _frozenBox.unionWith(box.leftBottom());
+            _frozenBox.unionWith(box.rightTop());
+        }
+        _frozen = start;
+    }
+    
+    mgCubicSplines(_count - start, _points + start, _knotvs + start, kCubicTan1);
+    mgCubicSplinesBox(box, _count - start, _points + start, _knotvs + start);
+    
+    _extent = _frozenBox;
+    _extent.unionWith(box.leftBottom());
+    _extent.unionWith(box.rightTop());
+    _solved = _count;
+    _clearLod();
+    MgBaseShape::_update();
+    
+    return true;
 }
 
+// 逐个检查空间索引找到的曲线段，rect不为NULL时判断是否与矩形框相交
+struct SplinesHitVisitor : public MgBaseLines::SegmentVisitor
+{
+    UInt32          count;
+    const Point2d*  points;
+    const Vector2d* vs;
+    Point2d         pt;
+    float           tol;
+    const Box2d*    rect;
+    float           distMin;
+    Point2d         nearpt;
+    Int32           segment;
+
+    SplinesHitVisitor(UInt32 n, const Point2d* pts, const Vector2d* knotvs)
+        : count(n), points(pts), vs(knotvs), tol(0), rect(NULL)
+        , distMin(_FLT_MAX), segment(-1) {}
+
+    void visit(UInt32 i) {
+        Point2d knots[2], ptTemp;
+        Vector2d knotvs[2];
+        Int32 segTemp;
+
+        knots[0] = points[i];                   // 闭合时末段的终点为起点
+        knots[1] = points[(i + 1) % count];
+        knotvs[0] = vs[i];
+        knotvs[1] = vs[(i + 1) % count];
+        if (rect) {
+            if (segment < 0 && mgCubicSplinesIntersectBox(*rect, 2, knots, knotvs, false))
+                segment = i;
+            return;
+        }
+
+        float dist = mgCubicSplinesHit(2, knots, knotvs, false, pt, tol, ptTemp, segTemp);
+        if (dist < distMin || (dist == distMin && (Int32)i < segment)) {
+            distMin = dist;                     // 距离相同时取序号小的，与逐段检查的结果一致
+            nearpt = ptTemp;
+            segment = i;
+        }
+    }
+};
+
 float MgSplines::_hitTest(const Point2d& pt, float tol, 
                           Point2d& nearpt, Int32& segment) const
 {
-    return mgCubicSplinesHit(_count, _points, _knotvs, _closed, 
-        pt, tol, nearpt, segment);
+    SplinesHitVisitor visitor(_count, _points, _knotvs);
+    
+    visitor.pt = pt;
+    visitor.tol = tol;
+    if (!_findSegments(Box2d(pt, 2 * tol, 2 * tol), visitor, _knotvs)) {
+        return mgCubicSplinesHit(_count, _points, _knotvs, _closed, 
+            pt, tol, nearpt, segment);
+    }
+    
+    nearpt = visitor.nearpt;
+    segment = visitor.segment;
+    
+    return visitor.distMin;
 }
 
 bool MgSplines::_hitTestBox(const Box2d& rect) const
 {
-    if (!__super::_hitTestBox(rect))
+    if (!MgBaseShape::_hitTestBox(rect))        // 曲线不一定在各边的包络框内
         return false;
-    return mgCubicSplinesIntersectBox(rect, _count, _points, _knotvs, _closed);
+    
+    SplinesHitVisitor visitor(_count, _points, _knotvs);
+    
+    visitor.rect = &rect;
+    if (!_findSegments(rect, visitor, _knotvs))
+        return mgCubicSplinesIntersectBox(rect, _count, _points, _knotvs, _closed);
+    
+    return visitor.segment >= 0;
 }
 
 bool MgSplines::_draw(GiGraphics& gs, const GiContext& ctx) const
 {
     bool ret = false;
+    const Point2d* pts = _points;
+    const Vector2d* knotvs = NULL;
+    UInt32 n = _incremental ? _count            // 正在交互绘制时不简化
+        : _getLodPoints(gs, pts, &knotvs);
+    bool partial = !_incremental && n == _count;
+    GiScratch<UInt32> segs(gs._scratch(), partial && !_closed ? n : 0);
+    Int32 nsegs = partial ? _findVisibleSegments(gs, segs.get(), _knotvs) : -1;
 
-    if (_count == 2)
-        ret = gs.drawLine(&ctx, _points[0], _points[1]);
+    if (!knotvs)
+        knotvs = _knotvs;
+    if (nsegs >= 0) {                           // 放大显示局部时
+        UInt32 start, count;
+        for (Int32 j = 0; (count = _nextRun(segs.get(), nsegs, j, start)) > 0; ) {
+            ret = gs.drawSplines(&ctx, count, _points + start,
+                                 _knotvs + start) || ret;
+        }
+    }
+    else if (n == 2)
+        ret = gs.drawLine(&ctx, pts[0], pts[1]);
     else if (_closed)
-        ret = gs.drawClosedSplines(&ctx, _count, _points, _knotvs);
+        ret = gs.drawClosedSplines(&ctx, n, pts, knotvs);
     else
-        ret = gs.drawSplines(&ctx, _count, _points, _knotvs);
+        ret = gs.drawSplines(&ctx, n, pts, knotvs);
 
     return __super::_draw(gs, ctx) || ret;
 }
 
-void MgSplines::smooth(float tol)
+static const int kSmoothVerifyPasses = 4;   // 局部去点后整体校验的最多次数
+
+// 在候选点前后的局部范围内检查能否去掉点，keep[]标记保留的点
+static void smoothLocal(UInt32 count, const Point2d* pts, const Vector2d* vs,
+                          bool closed, float tol, UInt32 window, bool* keep)
+{
+    Point2d* wpts = new Point2d[window * 2 + 1];
+    Vector2d* wvs = new Vector2d[window * 2 + 1];
+    UInt32* windex = new UInt32[window * 2 + 1];
+    UInt32* kept = new UInt32[count];           // 已保留点的序号
+    UInt32 n = 0;
+    UInt32 i, j, m, k0;
+    Point2d nearpt;
+    Int32 segment;
+    
+    kept[0] = 0;                                // 第一个点不动
+    keep[0] = true;
+    
+    for (i = 1; i + 1 < count; i++)             // 检查第i点能否去掉，最末点除外
+    {
+        // 局部曲线：前面最近的几个保留点 + 第i点之后的几个点
+        m = 0;
+        k0 = n + 1 > window ? n + 1 - window : 0;
+        for (j = k0; j <= n; j++)
+            windex[m++] = kept[j];
+        for (j = i + 1; j < count && j <= i + window; j++)
+            windex[m++] = j;
+        for (j = 0; j < m; j++)
+            wpts[j] = pts[windex[j]];
+        
+        // 局部曲线的两端未到原曲线端点时，用原切矢量夹持
+        UInt32 flag = 0;
+        if (k0 > 0 || closed) {
+            flag |= kCubicTan1;
+            wvs[0] = vs[windex[0]];
+        }
+        if (windex[m - 1] + 1 < count || closed) {
+            flag |= kCubicTan2;
+            wvs[m - 1] = vs[windex[m - 1]];
+        }
+        mgCubicSplines(m, wpts, wvs, flag);
+        
+        bool removed = mgCubicSplinesHit(m, wpts, wvs, false, pts[i],
+                                         tol * 2, nearpt, segment) < tol;
+        for (j = 0; j < m && removed; j++) {    // 切向变化超过45度时也保留点
+            if (vs[windex[j]].angleTo(wvs[j]) > _M_PI_4)
+                removed = false;
+        }
+        if (!removed) {
+            kept[++n] = i;
+            keep[i] = true;
+        }
+    }
+    if (pts[kept[n]].distanceTo(pts[count - 1]) > tol) {
+        kept[++n] = count - 1;                  // 加上末尾点
+        keep[count - 1] = true;
+    }
+    
+    delete[] wpts;
+    delete[] wvs;
+    delete[] windex;
+    delete[] kept;
+}
+
+// 对去点后的整条曲线校验各去掉点的距离，补回超差的点，返回是否有补回的点
+static bool smoothVerify(UInt32 count, const Point2d* pts, bool closed, float tol,
+                         bool* keep, Point2d* points, Vector2d* knotvs)
+{
+    UInt32 n = 0, i, k;
+    Point2d nearpt;
+    Int32 segment;
+    bool changed = false;
+    
+    for (i = 0; i < count; i++) {
+        if (keep[i])
+            points[n++] = pts[i];
+    }
+    mgCubicSplines(n, points, knotvs, closed ? kCubicLoop : 0);
+    
+    for (i = 1, k = 0; i < count && k + 1 < n; i++) {
+        if (keep[i]) {
+            k++;
+            continue;
+        }
+        // 第i点在第k、k+1保留点之间，检查附近三段曲线
+        UInt32 k1 = k > 0 ? k - 1 : 0;
+        UInt32 k2 = mgMin(k + 2, n - 1);
+        if (mgCubicSplinesHit(k2 - k1 + 1, points + k1, knotvs + k1, false,
+                              pts[i], tol * 2, nearpt, segment) >= tol) {
+            keep[i] = true;
+            changed = true;
+        }
+    }
+    
+    return changed;
+}
+
+void MgSplines::smooth(float tol, UInt32 window)
 {
     if (_count < 3)
         return;
     
+    if (window > 0) {
+        bool* keep = new bool[_count];
+        Point2d* points = new Point2d[_count];
+        Vector2d* knotvs = new Vector2d[_count];
+        UInt32 i, n = 0;
+        
+        for (i = 0; i < _count; i++)
+            keep[i] = false;
+        smoothLocal(_count, _points, _knotvs, _closed, tol, window, keep);
+        for (int pass = 0; smoothVerify(_count, _points, _closed, tol, keep, points, knotvs); ) {
+            if (++pass >= kSmoothVerifyPasses) {    // 补回点后曲线有变化，需再次校验，次数有限
+                for (i = 0; i < _count; i++)    // 仍未收敛则不去点
+                    keep[i] = true;
+                break;
+            }
+        }
+        
+        for (i = 0; i < _count; i++) {
+            if (keep[i])
+                points[n++] = _points[i];
+        }
+        if (n < _count) {
+            _count = n;
+            for (i = 0; i < _count; i++)
+                _points[i] = points[i];
+            update();
+        }
+        
+        delete[] keep;
+        delete[] points;
+        delete[] knotvs;
+        return;
+    }
+    
     Point2d* points = new Point2d[_count];
     Vector2d* knotvs = new Vector2d[_count];
     UInt32* indexMap = new UInt32[_count];
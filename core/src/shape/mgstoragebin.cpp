@@ -0,0 +1,549 @@
+// mgstoragebin.cpp: 实现二进制图形存取类 MgStorageBin
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#include <mgstoragebin.h>
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 文件格式: 文件头(标记"TVGB", 版本, 名称表位置, 名称个数)、字段记录、名称表。
+// 每个字段记录以一个字(类型<<24|名称序号)开始，均按4字节对齐。
+//   节点: 字头, 内容字节数, 内容(子节点和字段)
+//   整数、布尔值、浮点数: 字头, 值
+//   浮点数数组: 字头, 个数, 各个浮点数
+//   字符串: 字头, 字节数, 字节内容(补齐到4字节)
+// 名称表: 每项为字节数和字节内容(补齐到4字节)。
+
+typedef unsigned int Word;              // 文件中的四字节字
+
+static const char   kMagic[4] = { 'T', 'V', 'G', 'B' };
+static const Word   kVersion = 1;
+static const Word   kHeadSize = 16;
+static const int    kCacheSize = 61;
+static const int    kLookAhead = 8;     // 字段不匹配时向后查找的记录数
+
+enum { kNode = 1, kInt, kBool, kFloat, kFloats, kString };
+
+static inline Word padded(Word n) { return (n + 3) & ~3u; }
+
+struct MgStorageBin::Impl
+{
+    struct KeyCache {
+        const char* name;
+        int         key;
+    };
+
+    // 读取
+    const unsigned char*    data;
+    Word                    size;
+    Word                    pos;            // 当前记录位置
+    Word                    dataEnd;        // 字段记录的结束位置
+    std::vector<Word>       nodeEnds;       // 各级已开始节点的结束位置
+    std::vector<const char*> keyNames;      // 名称表中的各个名称
+    std::vector<Word>       keyLens;
+    KeyCache                readCache[kCacheSize];
+    void*                   mapped;
+    Word                    mappedSize;
+#ifdef _WIN32
+    HANDLE                  hfile;
+    HANDLE                  hmap;
+#endif
+
+    // 写入
+    std::vector<unsigned char>  buf;
+    std::vector<Word>       nodeStarts;     // 各级已开始节点的长度字位置
+    std::vector<std::string> names;
+    std::map<std::string, int> nameKeys;
+    KeyCache                writeCache[kCacheSize];
+    Word                    keyOffset;      // 已结束写入时名称表的位置，否则为0
+
+    Impl() : data(NULL), size(0), pos(0), dataEnd(0), mapped(NULL), mappedSize(0)
+        , keyOffset(0)
+    {
+#ifdef _WIN32
+        hfile = INVALID_HANDLE_VALUE;
+        hmap = NULL;
+#endif
+        memset(readCache, 0, sizeof(readCache));
+        memset(writeCache, 0, sizeof(writeCache));
+    }
+
+    static int slot(const char* name)
+    {
+        return (int)(((size_t)name >> 2) % kCacheSize);
+    }
+
+    Word word(Word offset) const
+    {
+        Word v;
+        memcpy(&v, data + offset, 4);
+        return v;
+    }
+
+    Word limit() const
+    {
+        return nodeEnds.empty() ? dataEnd : nodeEnds.back();
+    }
+
+    bool parse()
+    {
+        if (size < kHeadSize || memcmp(data, kMagic, 4) != 0 || word(4) != kVersion)
+            return false;
+
+        Word offset = word(8);
+        Word count = word(12);
+
+        if (offset < kHeadSize || offset > size || (offset & 3))
+            return false;
+        dataEnd = offset;
+        pos = kHeadSize;
+
+        for (Word i = 0; i < count; i++) {
+            if (offset + 4 > size)
+                return false;
+            Word len = word(offset);
+            if (len > size - offset - 4)
+                return false;
+            keyNames.push_back((const char*)data + offset + 4);
+            keyLens.push_back(len);
+            offset += 4 + padded(len);
+        }
+
+        return true;
+    }
+
+    int findKey(const char* name)
+    {
+        KeyCache& c = readCache[slot(name)];
+
+        if (c.name != name) {
+            Word len = (Word)strlen(name);
+
+            c.name = name;
+            c.key = -1;
+            for (Word i = 0; i < keyNames.size(); i++) {
+                if (keyLens[i] == len && memcmp(keyNames[i], name, len) == 0) {
+                    c.key = (int)i;
+                    break;
+                }
+            }
+        }
+
+        return c.key;
+    }
+
+    // 返回当前记录的字节数，含字头，出错返回0
+    Word recordSize(Word at, Word end) const
+    {
+        if (at + 8 > end)
+            return 0;
+
+        Word avail = end - at - 8;
+        Word len = 0;
+
+        switch (word(at) >> 24) {
+            case kNode:     len = word(at + 4); break;
+            case kFloats:
+                len = word(at + 4) > avail / 4 ? avail + 1 : word(at + 4) * 4;
+                break;
+            case kString:
+                len = word(at + 4) > avail ? avail + 1 : padded(word(at + 4));
+                break;
+        }
+        return len <= avail ? 8 + len : 0;
+    }
+
+    // 定位到给定名称和类型的记录，返回记录位置，找不到时返回0
+    Word seek(const char* name, int type)
+    {
+        int key = findKey(name);
+        Word end = limit();
+        Word at = pos;
+
+        if (key < 0)
+            return 0;
+        for (int i = 0; i < kLookAhead; i++) {
+            Word n = recordSize(at, end);
+            if (0 == n)
+                break;
+            if (word(at) == ((Word)type << 24 | (Word)key)) {
+                pos = at;
+                return at;
+            }
+            at += n;
+        }
+
+        return 0;
+    }
+
+    void unmap()
+    {
+#ifdef _WIN32
+        if (mapped)
+            UnmapViewOfFile(mapped);
+        if (hmap)
+            CloseHandle(hmap);
+        if (hfile != INVALID_HANDLE_VALUE)
+            CloseHandle(hfile);
+        hfile = INVALID_HANDLE_VALUE;
+        hmap = NULL;
+#else
+        if (mapped)
+            munmap(mapped, mappedSize);
+#endif
+        mapped = NULL;
+        mappedSize = 0;
+    }
+
+    int writeKey(const char* name)
+    {
+        KeyCache& c = writeCache[slot(name)];
+
+        if (c.name != name) {
+            std::map<std::string, int>::iterator it = nameKeys.find(name);
+
+            c.name = name;
+            if (it != nameKeys.end()) {
+                c.key = it->second;
+            }
+            else {
+                c.key = (int)names.size();
+                names.push_back(name);
+                nameKeys[name] = c.key;
+            }
+        }
+
+        return c.key;
+    }
+
+    void writeWord(Word v)
+    {
+        size_t n = buf.size();
+        buf.resize(n + 4);
+        memcpy(&buf[n], &v, 4);
+    }
+
+    void writeBytes(const void* p, Word n)
+    {
+        size_t old = buf.size();
+
+        buf.resize(old + padded(n), 0);
+        if (n > 0)
+            memcpy(&buf[old], p, n);
+    }
+
+    void beginField(const char* name, int type)
+    {
+        if (buf.empty()) {
+            writeBytes(kMagic, 4);
+            writeWord(kVersion);
+            writeWord(0);
+            writeWord(0);
+        }
+        else if (keyOffset) {           // 已结束写入，去掉名称表以便续写
+            buf.resize(keyOffset);
+            keyOffset = 0;
+        }
+        writeWord((Word)type << 24 | (Word)writeKey(name));
+    }
+
+    void finish()
+    {
+        if (!buf.empty() && !keyOffset) {
+            Word count = (Word)names.size();
+
+            keyOffset = (Word)buf.size();
+            memcpy(&buf[8], &keyOffset, 4);
+            memcpy(&buf[12], &count, 4);
+            for (Word i = 0; i < count; i++) {
+                writeWord((Word)names[i].size());
+                writeBytes(names[i].c_str(), (Word)names[i].size());
+            }
+        }
+    }
+};
+
+MgStorageBin::MgStorageBin() : _impl(new Impl)
+{
+}
+
+MgStorageBin::~MgStorageBin()
+{
+    close();
+    delete _impl;
+}
+
+bool MgStorageBin::open(const char* filename)
+{
+    close();
+
+#ifdef _WIN32
+    _impl->hfile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_impl->hfile == INVALID_HANDLE_VALUE)
+        return false;
+    _impl->mappedSize = GetFileSize(_impl->hfile, NULL);
+    _impl->hmap = _impl->mappedSize > 0 ? CreateFileMappingA(
+        _impl->hfile, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    _impl->mapped = _impl->hmap ? MapViewOfFile(_impl->hmap, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int fd = ::open(filename, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        _impl->mappedSize = (Word)st.st_size;
+        _impl->mapped = mmap(NULL, _impl->mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (_impl->mapped == MAP_FAILED)
+            _impl->mapped = NULL;
+    }
+    ::close(fd);
+#endif
+
+    if (!_impl->mapped) {
+        _impl->unmap();
+        return false;
+    }
+    if (!attach(_impl->mapped, _impl->mappedSize)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MgStorageBin::attach(const void* data, UInt32 size)
+{
+    _impl->data = (const unsigned char*)data;
+    _impl->size = data ? (Word)size : 0;
+    _impl->pos = 0;
+    _impl->dataEnd = 0;
+    _impl->nodeEnds.clear();
+    _impl->keyNames.clear();
+    _impl->keyLens.clear();
+    memset(_impl->readCache, 0, sizeof(_impl->readCache));
+
+    if (!_impl->parse()) {
+        _impl->data = NULL;
+        _impl->size = 0;
+        _impl->dataEnd = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void MgStorageBin::close()
+{
+    _impl->unmap();
+    _impl->data = NULL;
+    _impl->size = 0;
+    _impl->pos = 0;
+    _impl->dataEnd = 0;
+    _impl->nodeEnds.clear();
+    _impl->keyNames.clear();
+    _impl->keyLens.clear();
+}
+
+bool MgStorageBin::save(const char* filename)
+{
+    UInt32 size = 0;
+    const void* data = getWrittenData(size);
+    FILE* fp = data ? fopen(filename, "wb") : NULL;
+    bool ret = false;
+
+    if (fp) {
+        ret = fwrite(data, 1, size, fp) == size;
+        ret = (fclose(fp) == 0) && ret;
+    }
+
+    return ret;
+}
+
+const void* MgStorageBin::getWrittenData(UInt32& size)
+{
+    _impl->finish();
+    size = (Word)_impl->buf.size();
+    return size > 0 ? &_impl->buf.front() : NULL;
+}
+
+void MgStorageBin::resetWriting()
+{
+    _impl->buf.clear();
+    _impl->nodeStarts.clear();
+    _impl->names.clear();
+    _impl->nameKeys.clear();
+    _impl->keyOffset = 0;
+    memset(_impl->writeCache, 0, sizeof(_impl->writeCache));
+}
+
+bool MgStorageBin::readNode(const char* name, int, bool ended)
+{
+    if (ended) {
+        if (_impl->nodeEnds.empty())
+            return false;
+        _impl->pos = _impl->nodeEnds.back();
+        _impl->nodeEnds.pop_back();
+        return true;
+    }
+
+    Word at = _impl->data ? _impl->seek(name, kNode) : 0;
+
+    if (at) {
+        _impl->nodeEnds.push_back(at + 8 + _impl->word(at + 4));
+        _impl->pos = at + 8;
+    }
+
+    return at != 0;
+}
+
+int MgStorageBin::readInt(const char* name, int defvalue)
+{
+    Word at = _impl->data ? _impl->seek(name, kInt) : 0;
+
+    if (at) {
+        _impl->pos = at + 8;
+        defvalue = (int)_impl->word(at + 4);
+    }
+    return defvalue;
+}
+
+bool MgStorageBin::readBool(const char* name, bool defvalue)
+{
+    Word at = _impl->data ? _impl->seek(name, kBool) : 0;
+
+    if (at) {
+        _impl->pos = at + 8;
+        defvalue = _impl->word(at + 4) != 0;
+    }
+    return defvalue;
+}
+
+float MgStorageBin::readFloat(const char* name, float defvalue)
+{
+    Word at = _impl->data ? _impl->seek(name, kFloat) : 0;
+
+    if (at) {
+        _impl->pos = at + 8;
+        memcpy(&defvalue, _impl->data + at + 4, 4);
+    }
+    return defvalue;
+}
+
+int MgStorageBin::readFloatArray(const char* name, float* values, int count)
+{
+    Word at = _impl->data ? _impl->seek(name, kFloats) : 0;
+    int n = 0;
+
+    if (at) {
+        n = (int)_impl->word(at + 4);
+        if (values) {
+            n = n < count ? n : count;
+            memcpy(values, _impl->data + at + 8, n * sizeof(float));
+            _impl->pos = at + 8 + _impl->word(at + 4) * 4;
+        }
+    }
+    return n;
+}
+
+int MgStorageBin::readString(const char* name, char* value, int count)
+{
+    Word at = _impl->data ? _impl->seek(name, kString) : 0;
+    int n = 0;
+
+    if (at) {
+        n = (int)_impl->word(at + 4);
+        if (value) {
+            n = n < count ? n : count;
+            memcpy(value, _impl->data + at + 8, n);
+            _impl->pos = at + 8 + padded(_impl->word(at + 4));
+        }
+    }
+    return n;
+}
+
+UInt32 MgStorageBin::tellRead()
+{
+    return _impl->data ? _impl->pos : 0;
+}
+
+bool MgStorageBin::seekRead(UInt32 pos)
+{
+    if (!_impl->data || pos < kHeadSize || pos >= _impl->dataEnd || (pos & 3))
+        return false;
+
+    _impl->pos = (Word)pos;
+    _impl->nodeEnds.clear();
+
+    return true;
+}
+
+bool MgStorageBin::writeNode(const char* name, int, bool ended)
+{
+    if (ended) {
+        if (_impl->nodeStarts.empty())
+            return false;
+
+        Word start = _impl->nodeStarts.back();
+        Word len = (Word)_impl->buf.size() - start - 4;
+
+        _impl->nodeStarts.pop_back();
+        memcpy(&_impl->buf[start], &len, 4);
+    }
+    else {
+        _impl->beginField(name, kNode);
+        _impl->nodeStarts.push_back((Word)_impl->buf.size());
+        _impl->writeWord(0);
+    }
+
+    return true;
+}
+
+void MgStorageBin::writeInt(const char* name, int value)
+{
+    _impl->beginField(name, kInt);
+    _impl->writeWord((Word)value);
+}
+
+void MgStorageBin::writeBool(const char* name, bool value)
+{
+    _impl->beginField(name, kBool);
+    _impl->writeWord(value ? 1 : 0);
+}
+
+void MgStorageBin::writeFloat(const char* name, float value)
+{
+    _impl->beginField(name, kFloat);
+    _impl->writeBytes(&value, 4);
+}
+
+void MgStorageBin::writeFloatArray(const char* name, const float* values, int count)
+{
+    if (!values || count < 0)
+        count = 0;
+    _impl->beginField(name, kFloats);
+    _impl->writeWord((Word)count);
+    _impl->writeBytes(values, count * sizeof(float));
+}
+
+void MgStorageBin::writeString(const char* name, const char* value)
+{
+    Word n = value ? (Word)strlen(value) : 0;
+
+    _impl->beginField(name, kString);
+    _impl->writeWord(n);
+    _impl->writeBytes(value, n);
+}
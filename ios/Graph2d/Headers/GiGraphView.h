@@ -7,6 +7,7 @@
 #import "GiZoom.h"
 
 class GiGraphIos;
+class MgTileLayer;
 
 //! 图形视图类
 /*! \ingroup GRAPH_IOS
@@ -16,6 +17,7 @@ class GiGraphIos;
     MgShapes*       _shapes;                //!< 图形列表
     MgShapes*       _playShapes;            //!< 临时播放的图形列表
     GiGraphIos*     _graph;                 //!< 图形显示对象
+    MgTileLayer*    _tiles;                 //!< 静态图形的瓦片缓存
     id              _drawingDelegate;       //!< 动态绘图用的委托控制器对象
     MgShape*        _shapeAdded;            //!< 待添加显示的图形
     int             _buffered;              //!< 刷新显示时是否使用缓冲图
@@ -9,6 +9,7 @@ struct MgShapes;
 struct MgShape;
 class GiTransform;
 class GiGraphics;
+class Box2d;
 struct GiColor;
 
 //! 图形视图协议
@@ -27,6 +28,7 @@ struct GiColor;
 
 - (void)shapeAdded:(MgShape*)shape;     //!< 通知已添加图形，由视图重新构建显示
 - (void)regen;                          //!< 标记视图待重新构建显示
+- (void)regenRect:(const Box2d&)rectM;  //!< 标记视图的局部区域待重新构建显示，模型坐标
 - (void)redraw:(bool)fast;              //!< 标记视图待更新显示
 - (BOOL)isZooming;                      //!< 是否正在动态放缩或平移
 
@@ -78,6 +78,7 @@ public:
     virtual bool hasCachedBitmap(bool secondBmp = false) const;
     virtual void clearCachedBitmap(bool clearAll = false);
     virtual bool isBufferedDrawing() const;
+    virtual bool rawImage(const UInt8* pixels, int width, int height, float x, float y);
     virtual int getCanvasType() const { return 10; }
     virtual float getScreenDpi() const;
     
@@ -71,6 +71,22 @@ private:
         }
     }
     
+    void regenRect(const Box2d& rectM) {
+        if (rectM.isNull())
+            return;
+        [_mainview regenRect:rectM];
+        for (int i = 0; _auxviews[i]; i++) {
+            if ([_auxviews[i] conformsToProtocol:@protocol(GiView)]
+                && !_auxviews[i].hidden) {
+                id<GiView> gv = (id<GiView>)_auxviews[i];
+                [gv regenRect:rectM];
+            }
+        }
+        if (MgDynShapeLock::lockedForWrite()) {
+            _dynChanged = YES;
+        }
+    }
+    
     void redraw(bool fast) {
         [_curview redraw:fast];
         
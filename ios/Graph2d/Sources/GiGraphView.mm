@@ -5,6 +5,8 @@
 #import "GiGraphView.h"
 #include <iosgraph.h>
 #include <mgshapes.h>
+#include <mgcmd.h>
+#include <mgdispcache.h>
 
 @interface GiGraphView(Zooming)
 
@@ -69,6 +71,10 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
         [_bkImg release];
         _bkImg = nil;
     }
+    if (_tiles) {
+        delete _tiles;
+        _tiles = NULL;
+    }
     if (_graph) {
         delete _graph;
         _graph = NULL;
@@ -84,6 +90,9 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
     if (!_graph) {
         _graph = new GiGraphIos();
     }
+    if (!_tiles) {
+        _tiles = new MgTileLayer();
+    }
 
     _graph->xf.setWndSize(CGRectGetWidth(self.bounds), CGRectGetHeight(self.bounds));
     _graph->xf.setViewScaleRange(0.01, 20.0);
@@ -139,10 +148,25 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
                 nextDraw = true;
             }
         }
-        else if (_shapeAdded) {                     // 在缓冲图上显示新的图形
-            _shapeAdded->draw(gs);
-            cv.saveCachedBitmap();                  // 更新缓冲图
-            tmpAdded = NULL;
+        else {
+            Box2d rectDirty(gs.getDirtyWorld());
+            bool redrawn = gs.beginDirtyDraw();
+            
+            if (redrawn) {                          // 在缓冲图上重新显示改变的区域
+                if (![self draw:&gs]) {
+                    gs.addDirtyWorld(rectDirty);    // 下次再显示
+                    nextDraw = true;
+                }
+                gs.endDirtyDraw();
+            }
+            if (_shapeAdded) {                      // 在缓冲图上显示新的图形，已在改变区域内则不用再显示
+                if (!redrawn || !rectDirty.contains(mgShapeDisplayBox(_shapeAdded, &gs)
+                                                    * _graph->xf.modelToWorld())) {
+                    _shapeAdded->draw(gs);
+                    cv.saveCachedBitmap();          // 更新缓冲图
+                }
+                tmpAdded = NULL;
+            }
         }
         
         nextDraw = ![self dynDraw:&gs] || nextDraw; // 显示动态临时图形
@@ -161,6 +185,9 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
 
 - (void)shapeAdded:(MgShape*)shape
 {
+    if (shape) {
+        _tiles->invalidate(mgShapeDisplayBox(shape, &_graph->gs));
+    }
     if (_shapeAdded || !shape) {
         _buffered |= 1;
         [self regen];
@@ -184,7 +211,12 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
         }
     }
     else if (_shapes) {
-        _shapes->draw(*gs);
+        if (_zooming && _graph->xf.getViewScale() != _lastViewScale) {
+            _shapes->draw(*gs);                 // 动态放缩时显示比例一直在变，不生成瓦片
+        }
+        else {
+            _tiles->draw(_shapes, *gs);         // 平移显示时只生成新露出的瓦片
+        }
     }
     
     return ret;
@@ -257,6 +289,12 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
     [self setNeedsDisplay];
 }
 
+- (void)regenRect:(const Box2d&)rectM {
+    _tiles->invalidate(rectM);
+    _graph->gs.addDirtyWorld(rectM * _graph->xf.modelToWorld());
+    [self setNeedsDisplay];
+}
+
 - (void)redraw:(bool)fast
 {
     _buffered = fast ? (_buffered & ~1) : (_buffered | 1);
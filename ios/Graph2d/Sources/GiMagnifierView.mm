@@ -113,6 +113,10 @@
     [self setNeedsDisplay];
 }
 
+- (void)regenRect:(const Box2d&)rectM {     // 放大镜视图很小，全部重新显示
+    [self regen];
+}
+
 - (void)redraw:(bool)fast {
     _cachedDraw = !fast;
     [self setNeedsDisplay];
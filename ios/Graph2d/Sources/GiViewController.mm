@@ -421,8 +421,8 @@
                 locker.shapes->draw(*gs);
             }
             else {
-                void *it;
-                MgShape *tmpShape = locker.shapes->getFirstShape(it);
+                MgShape *tmpShape = NULL;
+                locker.shapes->getShapes(0, 1, &tmpShape);
                 MgShape *added = [gview shapeAdded];
                 
                 if (tmpShape && added
@@ -276,6 +276,8 @@ void GiCanvasIos::endPaint(bool draw)
 {
     if (m_draw->getContext())
     {
+        if (owner2())
+            owner2()->flushBatch();         // 先输出批量提交时缓存的图元
         if (draw && m_draw->_buffctx && m_draw->_context) {
             CGContextRef context = m_draw->_context;
             CGImageRef image = CGBitmapContextCreateImage(m_draw->_buffctx);
@@ -497,6 +499,40 @@ bool GiCanvasIos::drawImage(CGImageRef image, const Box2d& rectM)
     return ret;
 }
 
+bool GiCanvasIos::rawImage(const UInt8* pixels, int width, int height, float x, float y)
+{
+    CGContextRef context = m_draw->getContext();
+    bool ret = false;
+    
+    if (context && pixels && width > 0 && height > 0) {
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, pixels,
+                                                                  width * height * 4, NULL);
+        CGImageRef image = CGImageCreate(width, height, 8, 32, width * 4, colorSpace,
+                                         kCGImageAlphaPremultipliedLast, provider,
+                                         NULL, false, kCGRenderingIntentDefault);
+        CGDataProviderRelease(provider);
+        CGColorSpaceRelease(colorSpace);
+        
+        if (image) {
+            CGAffineTransform af = CGAffineTransformMake(1, 0, 0, -1, 0, m_draw->height());
+            CGContextConcatCTM(context, af);    // 图像是朝上的，上下文坐标系朝下，上下颠倒显示
+            
+            CGInterpolationQuality oldQuality = CGContextGetInterpolationQuality(context);
+            CGContextSetInterpolationQuality(context, kCGInterpolationNone);
+            CGContextDrawImage(context, CGRectMake(x, m_draw->height() - y - height,
+                                                   width, height), image);
+            CGContextSetInterpolationQuality(context, oldQuality);
+            
+            CGContextConcatCTM(context, CGAffineTransformInvert(af));
+            CGImageRelease(image);
+            ret = true;
+        }
+    }
+    
+    return ret;
+}
+
 bool GiCanvasIos::isBufferedDrawing() const
 {
     return !!m_draw->_buffctx;
@@ -7,6 +7,7 @@
 #include <canvasgdip.h>
 #include <canvasgdi.h>
 #include <mgshapest.h>
+#include <mgcmd.h>
 #include <list>
 
 #ifdef _DEBUG
@@ -95,10 +96,22 @@ void CBaseView::OnPaint()
 			DrawAll(&gs);                       // 显示正式图形
 			cv->saveCachedBitmap();	            // 保存正式图形内容
 		}
-        else if (m_shapeAdded)                  // 在背景图上添加显示新图形
+        else
         {
-            m_shapeAdded->draw(gs);
-            cv->saveCachedBitmap();	            // 更新正式图形内容
+            Box2d rectDirty (gs.getDirtyWorld());
+            bool redrawn = gs.beginDirtyDraw();
+
+            if (redrawn)                        // 在背景图上重新显示改变的区域
+            {
+                DrawAll(&gs);
+                gs.endDirtyDraw();              // 更新正式图形内容
+            }
+            if (m_shapeAdded && (!redrawn       // 在背景图上添加显示新图形，已在改变区域内则已显示
+                || !rectDirty.contains(mgShapeDisplayBox(m_shapeAdded, &gs) * gs.xf().modelToWorld())))
+            {
+                m_shapeAdded->draw(gs);
+                cv->saveCachedBitmap();	        // 更新正式图形内容
+            }
         }
         m_shapeAdded = NULL;
 
@@ -133,7 +146,7 @@ void CBaseView::shapeAdded(MgShape* shape)
 
 void CBaseView::DrawAll(GiGraphics* gs)
 {
-	m_shapes->draw(*gs);
+	m_cache.draw(m_shapes, *gs);            // 平移时重放显示列表
 }
 
 void CBaseView::OnZoomExtent() 
@@ -4,6 +4,7 @@
 
 #include "RandomShape.h"
 #include <graphwin.h>
+#include <mgdispcache.h>
 
 class CBaseView : public CWnd
 {
@@ -15,6 +16,7 @@ public:
     MgShapes*       m_shapes;           // 图形数据
     GiGraphWin*     m_graph;	        // 图形系统对象
     MgShape*        m_shapeAdded;
+    MgDisplayCache  m_cache;            // 图形显示缓存，图形改变后须调用invalidate()
 
     void shapeAdded(MgShape* shape);
 
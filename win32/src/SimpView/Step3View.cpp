@@ -29,9 +29,15 @@ private:
     GiGraphics* graph() { return &view->m_graph->gs; }
     void redraw(bool) { view->Invalidate(); }
     void regen() {
+        view->m_cache.invalidate();             // 命令改变了图形
         view->m_graph->gs.clearCachedBitmap();
         view->Invalidate();
     }
+    void regenRect(const Box2d& rectM) {
+        view->m_cache.invalidate();
+        view->m_graph->gs.addDirtyWorld(rectM * view->m_graph->xf.modelToWorld());
+        view->Invalidate();
+    }
     GiContext* context() {
         RandomParam().setShapeProp(view->m_shapes->context());
         return view->m_shapes->context();
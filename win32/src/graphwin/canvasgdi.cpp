@@ -367,6 +367,7 @@ void GiCanvasGdi::endPaint(bool draw)
 {
     if (m_owner->isDrawing())
     {
+        m_owner->flushBatch();              // 先输出批量提交时缓存的图元
         if (m_draw->m_buffBmp != NULL && draw)
         {
             RECT rc;
@@ -434,6 +434,7 @@ void GiCanvasGdip::endPaint(bool draw)
 {
     if (owner()->isDrawing())
     {
+        owner2()->flushBatch();             // 先输出批量提交时缓存的图元
         if (m_draw->m_memGs != NULL && draw)
         {
             m_draw->m_gs->SetInterpolationMode(G::InterpolationModeDefault);
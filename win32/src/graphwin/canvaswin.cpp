@@ -149,6 +149,7 @@ void GiCanvasWin::endPaint(bool /*draw*/)
 {
     if (m_owner->isDrawing())
     {
+        m_owner->flushBatch();
         m_attribDC = NULL;
         m_owner->_endPaint();
     }